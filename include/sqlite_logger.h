@@ -75,6 +75,132 @@ tSL_LogLevel;
 //! @brief This is a convenience alias for logging nothing.
 #define SL_LOGLEVEL_NOTHING     eSL_LogLevel_None
 
+//! @brief Callback for __SL_Query__, called once for each result row.
+//! @param [in] context The __context__ pointer passed to __SL_Query__.
+//! @param [in] columnCount The number of columns in the row.
+//! @param [in] values The column values as strings (__NULL__ for SQL NULL values).
+//! @param [in] names The column names.
+//! @return 0 to continue, or non-zero to stop the query.
+typedef int (*tSL_QueryCallback) (void* context, int columnCount, char** values, char** names);
+
+//! @brief A log entry delivered to a subscriber.
+typedef struct tsl_logrecord
+{
+    const char*     timestamp;          //!< When the entry was logged
+    const char*     message;            //!< The message
+    tSL_LogLevel    level;              //!< The log level
+    const char*     fileName;           //!< The source file name (may be empty)
+    const char*     functionName;       //!< The function name (may be empty)
+    uint32_t        lineNumber;         //!< The source line number
+    const char*     tag;                //!< The tag (may be empty)
+    const char*     supplementalData;   //!< The supplemental data (may be empty)
+    uint32_t        repeatCount;        //!< The number of messages collapsed into this entry
+}
+tSL_LogRecord;
+
+//! @brief Which log entries a subscriber receives, and when.
+typedef struct tsl_subscriptionfilter
+{
+    tSL_LogLevel    level;              //!< The lowest log level to deliver
+    const char*     tag;                //!< Only deliver entries with this tag (__NULL__ for any tag)
+    bool            onWrite;            //!< Deliver entries when they're written to the log file
+                                        //!< (with their final repeat count), instead of when
+                                        //!< they're logged
+}
+tSL_SubscriptionFilter;
+
+//! @brief Callback for __SL_Subscribe__, called once for each matching log entry.
+//! @param [in] record The log entry (only valid for the duration of the call).
+//! @param [in] context The __context__ pointer passed to __SL_Subscribe__.
+typedef void (*tSL_SubscriptionCallback) (const tSL_LogRecord* record, void* context);
+
+//! @brief Export file formats.
+typedef enum tsl_exportformat
+{
+    eSL_ExportFormat_NDJSON = 0,    //!< One JSON object per line (NULL columns are left out)
+    eSL_ExportFormat_CSV    = 1     //!< Comma separated values, with a header line (RFC 4180)
+}
+tSL_ExportFormat;
+
+//! @brief What to export, and how.
+typedef struct tsl_exportoptions
+{
+    tSL_ExportFormat    format;         //!< The export file format
+    const char*         tableName;      //!< The __log__ table to export (__NULL__ for every
+                                        //!< session)
+    const char*         startTime;      //!< Only export entries logged at or after this time
+                                        //!< (__NULL__ for no limit)
+    const char*         endTime;        //!< Only export entries logged before this time
+                                        //!< (__NULL__ for no limit)
+    uint32_t            threadCount;    //!< The number of threads to export with (0 or 1
+                                        //!< exports on the calling thread)
+}
+tSL_ExportOptions;
+
+//! @brief Import file formats.
+typedef enum tsl_importformat
+{
+    eSL_ImportFormat_Text   = 0,    //!< One entry per line: an optional timestamp, an optional
+                                    //!< log level, and the message
+    eSL_ImportFormat_NDJSON = 1     //!< One JSON object per line, with __log__ table column
+                                    //!< names (or common names like "time", "level" and "msg")
+}
+tSL_ImportFormat;
+
+//! @brief What to import, and how.
+typedef struct tsl_importoptions
+{
+    tSL_ImportFormat    format;         //!< The import file format
+    uint32_t            threadCount;    //!< The number of threads to parse with (0 is the same
+                                        //!< as 1)
+}
+tSL_ImportOptions;
+
+//! @brief Merge outputs.
+typedef enum tsl_mergeoutput
+{
+    eSL_MergeOutput_Database    = 0,    //!< A new __log__ table in a SQLite database, with a
+                                        //!< __log_source__ column
+    eSL_MergeOutput_NDJSON      = 1,    //!< An NDJSON file, with a __log_source__ field
+    eSL_MergeOutput_CSV         = 2     //!< A CSV file, with a __log_source__ column
+}
+tSL_MergeOutput;
+
+//! @brief What to merge, and how.
+typedef struct tsl_mergeoptions
+{
+    tSL_MergeOutput output;         //!< Where the merged entries go
+    const char*     startTime;      //!< Only merge entries logged at or after this time
+                                    //!< (__NULL__ for no limit)
+    const char*     endTime;        //!< Only merge entries logged before this time (__NULL__
+                                    //!< for no limit)
+    uint32_t        threadCount;    //!< The number of threads to read the log files with (0
+                                    //!< reads on the calling thread)
+}
+tSL_MergeOptions;
+
+//! @brief Statistics of the WAL checkpoints of a session.
+typedef struct tsl_checkpointstats
+{
+    uint64_t    checkpointCount;    //!< The number of checkpoints that completed
+    uint64_t    truncateCount;      //!< The number of those that emptied the WAL (which the
+                                    //!< next commit starts over and truncates)
+    uint64_t    busyCount;          //!< The number of checkpoints that couldn't run (and were
+                                    //!< tried again later)
+    uint64_t    errorCount;         //!< The number of checkpoints that failed
+    uint64_t    totalTime;          //!< The time spent checkpointing, in microseconds
+    uint64_t    maxTime;            //!< The longest checkpoint, in microseconds
+    uint32_t    walFrameCount;      //!< The number of frames in the WAL that the last
+                                    //!< checkpoint left to checkpoint
+}
+tSL_CheckpointStats;
+
+//! @brief The id of a timing span.
+typedef uint64_t tSL_SpanId;
+
+//! @brief The parent of spans that aren't nested in another span.
+#define SL_NO_PARENT_SPAN   0
+
 // =================================================================================================
 //  Prototypes
 // =================================================================================================
@@ -176,6 +302,563 @@ extern "C"
                     const char* tag,
                     const char* supplementalData);
 
+    //! @fn int32_t SL_SpanBegin (const char* name, const char* tag, tSL_SpanId parentId,
+    //! tSL_SpanId* spanId)
+    //! @brief Call __SL_SpanBegin__ to start timing a span of work. When the span is ended by
+    //! __SL_SpanEnd__, it's written to the __log spans__ table with the times it started and
+    //! ended (from the monotonic clock, in nanoseconds), its duration in
+    //! __span_duration_ns__, and the id of its parent span, so nested spans form a tree that
+    //! can be queried like a profile. For example:
+    //! @code
+    //! tSL_SpanId spanId = SL_NO_PARENT_SPAN;
+    //! int32_t result = SL_SpanBegin("Load configuration", "Startup", SL_NO_PARENT_SPAN, &spanId);
+    //! ...
+    //! result = SL_SpanEnd(spanId);
+    //! @endcode
+    //! @code
+    //! SELECT span_name, COUNT(*), AVG(span_duration_ns) FROM `log spans` GROUP BY span_name;
+    //! @endcode
+    //! @param [in] name The name of the span. This parameter must not be NULL.
+    //! @param [in] tag A tag to associate with the span.
+    //! @param [in] parentId The id of the span this span is nested in, or
+    //! __SL_NO_PARENT_SPAN__.
+    //! @param [out] spanId The id of the span, to end it with. Span ids are unique within a
+    //! log file.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that the __name__ or __spanId__ argument is
+    //! __NULL__.
+    //! @note A return value of __ENOSPC__ indicates that 64 spans have already been begun and
+    //! not ended.
+    //! @note A return value of __SL_RESULT_NOT_INITIALIZED__ indicates that __SL_Initialize__
+    //! has not been called.
+    //! @note Return values may also include result codes from __sqlite3__.
+    //! @see SL_SpanEnd
+    int32_t SL_SpanBegin (const char* name, const char* tag, tSL_SpanId parentId, tSL_SpanId* spanId);
+
+    //! @fn int32_t SL_SpanEnd (tSL_SpanId spanId)
+    //! @brief Call __SL_SpanEnd__ to stop timing a span begun by __SL_SpanBegin__. Ended spans
+    //! are written with the next batch of log entries (or by __SL_Terminate__); spans that
+    //! haven't been ended when __SL_Terminate__ is called aren't written.
+    //! @code
+    //! int32_t result = SL_SpanEnd(spanId);
+    //! @endcode
+    //! @param [in] spanId The id of the span.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __ENOENT__ indicates that there's no span with that id (or it's
+    //! already been ended).
+    //! @note A return value of __SL_RESULT_NOT_INITIALIZED__ indicates that __SL_Initialize__
+    //! has not been called.
+    //! @note Return values may also include result codes from __sqlite3__.
+    //! @see SL_SpanBegin
+    int32_t SL_SpanEnd (tSL_SpanId spanId);
+
+    //! @fn int32_t SL_RecordMetric (const char* name, double value)
+    //! @brief Call __SL_RecordMetric__ to record a value of a counter or gauge. Values aren't
+    //! written as they're recorded; each metric's values are aggregated in memory over an
+    //! interval (see __SL_SetMetricInterval__), and when the interval ends, one row per metric
+    //! is written to the __log metrics__ table with the next batch of log entries. A row holds
+    //! the count, sum, minimum, maximum and last of the values, and a histogram of them, as a
+    //! JSON array of 32 counts: the first counts values below 1, the next values from 1 up to
+    //! 2, then 2 up to 4, and so on, and the last counts everything above those. The current
+    //! interval is written by __SL_Terminate__.
+    //! @code
+    //! int32_t result = SL_RecordMetric("Queue depth", (double)queueDepth);
+    //! @endcode
+    //! @param [in] name The name of the metric (up to 127 characters are used). At most 64
+    //! metrics can be recorded in an interval.
+    //! @param [in] value The value to record.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that the __name__ argument is __NULL__.
+    //! @note A return value of __EINVAL__ indicates that the __name__ argument is empty, or the
+    //! __value__ argument isn't a number.
+    //! @note A return value of __ENOSPC__ indicates that 64 other metrics have already been
+    //! recorded in this interval.
+    //! @note A return value of __SL_RESULT_NOT_INITIALIZED__ indicates that __SL_Initialize__
+    //! has not been called.
+    //! @note Return values may also include result codes from __sqlite3__.
+    //! @see SL_SetMetricInterval
+    int32_t SL_RecordMetric (const char* name, double value);
+
+    //! @fn int32_t SL_SetRateLimit (uint32_t messagesPerSecond, uint32_t burstSize)
+    //! @brief Call __SL_SetRateLimit__ to limit how often an identical message is logged.
+    //! Messages are identical if their message, level, file name, line number and tag match.
+    //! Each identical message gets a token bucket holding up to __burstSize__ tokens that
+    //! refills at __messagesPerSecond__. Repeats logged while the bucket is empty are
+    //! collapsed into the message's pending log entry, which records the repeat count in
+    //! its __log_repeat_count__ column and the timestamp of the last repeat in its
+    //! __log_last_timestamp__ column.
+    //! @code
+    //! int32_t result = SL_SetRateLimit(10, 100);
+    //! @endcode
+    //! @param [in] messagesPerSecond The sustained rate at which identical messages are logged
+    //! as separate log entries. A value of 0 disables rate limiting (the default).
+    //! @param [in] burstSize The number of identical messages that may be logged as separate
+    //! log entries before rate limiting takes effect.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EINVAL__ indicates that __burstSize__ is zero while
+    //! __messagesPerSecond__ is not.
+    //! @note A pending log entry is one that hasn't been committed to the log file yet, so
+    //! a burst of repeats may be spread over one log entry per committed transaction.
+    int32_t SL_SetRateLimit (uint32_t messagesPerSecond, uint32_t burstSize);
+
+    //! @fn int32_t SL_SetSamplingRate (tSL_LogLevel level, double rate)
+    //! @brief Call __SL_SetSamplingRate__ to log only a random sample of the messages at a
+    //! log level. The sampling rate is recorded in the __log_sample_rate__ column of each
+    //! sampled log entry, so that counts can be re-weighted by __1 / log_sample_rate__.
+    //! @code
+    //! int32_t result = SL_SetSamplingRate(eSL_LogLevel_Diagnostic, 0.01);
+    //! @endcode
+    //! @param [in] level The log level to sample.
+    //! @param [in] rate The fraction of messages at __level__ to log, greater than 0 and at
+    //! most 1. The default for every log level is 1 (log every message).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EINVAL__ indicates that the __level__ or __rate__ argument
+    //! is invalid.
+    //! @see SL_SetTagSamplingRate
+    int32_t SL_SetSamplingRate (tSL_LogLevel level, double rate);
+
+    //! @fn int32_t SL_SetTagSamplingRate (const char* tag, double rate)
+    //! @brief Call __SL_SetTagSamplingRate__ to log only a random sample of the messages
+    //! with a tag. A tag sampling rate overrides the sampling rate of the message's log level.
+    //! @code
+    //! int32_t result = SL_SetTagSamplingRate("Render loop", 0.05);
+    //! @endcode
+    //! @param [in] tag The tag to sample.
+    //! @param [in] rate The fraction of messages with __tag__ to log, greater than 0 and at
+    //! most 1. A rate of 1 removes the tag sampling rate.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that the __tag__ argument is __NULL__.
+    //! @note A return value of __EINVAL__ indicates that the __tag__ argument is an empty
+    //! string or that the __rate__ argument is invalid.
+    //! @note A return value of __ENOSPC__ indicates that the maximum number of sampled tags
+    //! (16) is already in use.
+    //! @see SL_SetSamplingRate
+    int32_t SL_SetTagSamplingRate (const char* tag, double rate);
+
+    //! @fn int32_t SL_SetCompressionThreshold (uint32_t threshold)
+    //! @brief Call __SL_SetCompressionThreshold__ to compress long messages and supplemental
+    //! data. Values of __log_message__ and __log_supplementaldata__ that are at least 
+    //! __threshold__ bytes long are compressed when they are written to the log file, and are
+    //! stored as BLOBs (if compression makes them smaller). The views associated with a 
+    //! __log__ table decompress these values with the __sl_decompress__ SQL function.
+    //! __SL_SetCompressionThreshold__ must be called before __SL_Initialize__.
+    //! @code
+    //! int32_t result = SL_SetCompressionThreshold(128);
+    //! @endcode
+    //! @param [in] threshold The minimum length in bytes of a value to compress. A value of 0
+    //! disables compression (the default).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __SL_RESULT_ALREADY_INITIALIZED__ indicates that 
+    //! __SL_Initialize__ has already been called.
+    //! @warning The __sl_decompress__ SQL function is only registered with the SQLite Logger
+    //! database connection, so other SQLite clients can read the views of a log file with 
+    //! compressed values only if they provide their own __sl_decompress__ function.
+    int32_t SL_SetCompressionThreshold (uint32_t threshold);
+
+    //! @fn int32_t SL_SetDictionaryCompression (bool enable)
+    //! @brief Call __SL_SetDictionaryCompression__ to compress messages and supplemental data
+    //! against a shared dictionary. The dictionary is trained on a sample of recent log entries
+    //! and stored in the __log dictionaries__ table, and is retrained periodically as the logs
+    //! change. Each row that was compressed with a dictionary stores its id in 
+    //! __log_dictionary_id__. A dictionary makes even short messages compressible, so once a
+    //! dictionary has been trained, values of 16 bytes or more are compressed regardless of
+    //! the compression threshold.
+    //! __SL_SetDictionaryCompression__ must be called before __SL_Initialize__.
+    //! @code
+    //! int32_t result = SL_SetDictionaryCompression(true);
+    //! @endcode
+    //! @param [in] enable Whether to use dictionary compression (the default is false).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __SL_RESULT_ALREADY_INITIALIZED__ indicates that 
+    //! __SL_Initialize__ has already been called.
+    //! @see SL_SetCompressionThreshold
+    int32_t SL_SetDictionaryCompression (bool enable);
+
+    //! @fn int32_t SL_SetRollups (bool enable)
+    //! @brief Call __SL_SetRollups__ to keep counts of log entries per minute, level and tag in
+    //! the __log rollups__ table, so that queries that count entries over the whole log file
+    //! read a small table instead of every __log__ table. Each batch of log entries is counted
+    //! in memory, and the counts are added to the table in the same transaction as the entries
+    //! (including imported ones). __rollup_count__ counts rows, and __rollup_repeat_count__
+    //! counts the entries that were collapsed into them (see __SL_SetRateLimit__).
+    //! __SL_SetRollups__ must be called before __SL_Initialize__.
+    //! @code
+    //! int32_t result = SL_SetRollups(true);
+    //! @endcode
+    //! @param [in] enable Whether to keep rollups (the default is false).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __SL_RESULT_ALREADY_INITIALIZED__ indicates that
+    //! __SL_Initialize__ has already been called.
+    int32_t SL_SetRollups (bool enable);
+
+    //! @fn int32_t SL_SetPreallocatedMemory (uint64_t budget, bool useHeap)
+    //! @brief Call __SL_SetPreallocatedMemory__ to give SQLite a fixed amount of memory,
+    //! allocated once by __SL_Initialize__ and freed by __SL_Terminate__. A sixteenth of the
+    //! budget is used for the lookaside slots of the SQLite Logger database connection, and the
+    //! rest for the page cache; if __useHeap__ is true, half of the budget is used for the page
+    //! cache and the rest for a heap that all of SQLite's other allocations come from, so once
+    //! the caches are warm, logging doesn't allocate memory from the system, and SQLite's memory
+    //! use is bounded by the budget (an allocation that doesn't fit fails with
+    //! __SQLITE_NOMEM__). __SL_SetPreallocatedMemory__ must be called before __SL_Initialize__.
+    //! @code
+    //! int32_t result = SL_SetPreallocatedMemory(16 * 1024 * 1024, true);
+    //! @endcode
+    //! @param [in] budget The number of bytes of memory to preallocate, from 1 MB to 1 GB. A
+    //! value of 0 disables preallocation (the default).
+    //! @param [in] useHeap Whether SQLite's other allocations also come from the budget.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EINVAL__ indicates that the __budget__ argument is out of range.
+    //! @note A return value of __SL_RESULT_ALREADY_INITIALIZED__ indicates that
+    //! __SL_Initialize__ has already been called.
+    //! @note SQLite's memory can only be configured before SQLite is first used (or after
+    //! __sqlite3_shutdown__), and SQLite Logger doesn't shut it down to get around that, so
+    //! __SL_Initialize__ returns __SQLITE_MISUSE__ if a budget is set after anything in the
+    //! process, SQLite Logger sessions without a budget included, has used SQLite.
+    //! @warning SQLite's memory is configured for the whole process, so when a budget is set,
+    //! no other SQLite connection (including those of __SL_Export__ and __SL_Merge__) can be
+    //! open when __SL_Initialize__ or __SL_Terminate__ is called; __SL_Terminate__ shuts SQLite
+    //! down to take back the budget. Connections opened in between share the budget.
+    int32_t SL_SetPreallocatedMemory (uint64_t budget, bool useHeap);
+
+    //! @fn int32_t SL_SetMemoryLimit (uint64_t limit)
+    //! @brief Call __SL_SetMemoryLimit__ to cap the memory that SQLite Logger uses. The buffers
+    //! that log entries are collected and compressed in, the budget given to
+    //! __SL_SetPreallocatedMemory__, and the io_uring write buffers of __SL_SetAsyncWrites__
+    //! (about 512 KB for each database and WAL file, including those that the WAL checkpointing
+    //! connection opens), count against the limit, and the rest is the most that SQLite's heap
+    //! (its page cache, prepared statements and everything else) can grow to. As
+    //! SQLite nears the limit, it reuses its cached pages instead of allocating more. If writing
+    //! a batch of log entries still runs out of memory, SQLite gives back the memory it has
+    //! cached and the batch is tried again; if it fails again, the entries are kept, and
+    //! __SL_Log__ returns __SQLITE_NOMEM__ until a batch is written, rather than using more
+    //! memory. __SL_SetMemoryLimit__ must be called before __SL_Initialize__.
+    //! @code
+    //! int32_t result = SL_SetMemoryLimit(16 * 1024 * 1024);
+    //! @endcode
+    //! @param [in] limit The most memory to use, in bytes, of at least 1 MB. A value of 0
+    //! removes the limit (the default).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EINVAL__ indicates that the __limit__ argument is out of range.
+    //! __SL_Initialize__ also returns __EINVAL__ if the limit leaves less than 1 MB for SQLite.
+    //! @note A return value of __SL_RESULT_ALREADY_INITIALIZED__ indicates that
+    //! __SL_Initialize__ has already been called.
+    //! @note In builds that turn off SQLite's memory statistics (__BUILD_SQLITE_TUNING__), the
+    //! heap limit needs them turned back on, which SQLite only allows before it's first used, so
+    //! __SL_Initialize__ returns __SQLITE_MISUSE__ if a limit is first set after anything in
+    //! the process has used SQLite. SQLite isn't shut down to get around it.
+    //! @warning SQLite's heap limit applies to the whole process, so the connections of
+    //! __SL_Export__, __SL_Merge__ and WAL checkpointing share it while SQLite Logger is
+    //! initialized. Memory that isn't SQLite's or SQLite Logger's, such as the stack of the WAL
+    //! checkpointing thread and the kernel's io_uring queues, isn't counted. If
+    //! __SL_SetPreallocatedMemory__ is called with __useHeap__, all of SQLite's memory is already
+    //! in the budget, and no heap limit is set.
+    //! @see SL_SetPreallocatedMemory
+    int32_t SL_SetMemoryLimit (uint64_t limit);
+
+    //! @fn int32_t SL_SetMetricInterval (uint32_t interval)
+    //! @brief Call __SL_SetMetricInterval__ to set how long the values of metrics recorded by
+    //! __SL_RecordMetric__ are aggregated before they're written. Intervals start at multiples
+    //! of the interval since the epoch (so the default intervals start on the minute).
+    //! __SL_SetMetricInterval__ must be called before __SL_Initialize__.
+    //! @code
+    //! int32_t result = SL_SetMetricInterval(10);
+    //! @endcode
+    //! @param [in] interval The length of the interval, in seconds, from 1 to 86400 (a day).
+    //! The default is 60.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EINVAL__ indicates that the __interval__ argument is out of
+    //! range.
+    //! @note A return value of __SL_RESULT_ALREADY_INITIALIZED__ indicates that
+    //! __SL_Initialize__ has already been called.
+    //! @see SL_RecordMetric
+    int32_t SL_SetMetricInterval (uint32_t interval);
+
+    //! @fn int32_t SL_SetAsyncWrites (bool enable)
+    //! @brief Call __SL_SetAsyncWrites__ to write the log file through io_uring. The pages of a
+    //! batch are copied and submitted to the kernel in groups as SQLite writes them, instead of
+    //! being written one system call at a time, and the writes and the sync that commits them
+    //! are waited for together. Where io_uring isn't available (kernels before 5.6, or systems
+    //! that disable it), the log file is written synchronously, as it is by default.
+    //! __SL_SetAsyncWrites__ must be called before __SL_Initialize__.
+    //! @code
+    //! int32_t result = SL_SetAsyncWrites(true);
+    //! @endcode
+    //! @param [in] enable Whether to write through io_uring (the default is false).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __SL_RESULT_ALREADY_INITIALIZED__ indicates that
+    //! __SL_Initialize__ has already been called.
+    int32_t SL_SetAsyncWrites (bool enable);
+
+    //! @fn int32_t SL_SetMemoryMapSize (uint64_t size)
+    //! @brief Call __SL_SetMemoryMapSize__ to read log files through a memory map of up to
+    //! __size__ bytes (SQLite's __mmap_size__ pragma). Pages are then read straight from the
+    //! map instead of being copied by __read()__, which speeds up large queries, archiving and
+    //! checkpoints on the SQLite Logger database connection, and the connections that
+    //! __SL_Export__ and __SL_Merge__ read log files with. __SL_SetMemoryMapSize__ can be
+    //! called at any time; the SQLite Logger database connection uses the new size right away,
+    //! and other connections use it from the next time they're opened.
+    //! @code
+    //! int32_t result = SL_SetMemoryMapSize(256 * 1024 * 1024);
+    //! @endcode
+    //! @param [in] size The largest part of a log file to map, in bytes. A value of 0 disables
+    //! memory mapping (the default). SQLite limits the size to 2 GB.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note Return values may also include result codes from __sqlite3__.
+    //! @warning An I/O error on a memory mapped file (the file being truncated by another
+    //! program, for example) raises __SIGBUS__ instead of returning an error.
+    int32_t SL_SetMemoryMapSize (uint64_t size);
+
+    //! @fn int32_t SL_SetWALCheckpointing (uint32_t interval, uint32_t pageThreshold)
+    //! @brief Call __SL_SetWALCheckpointing__ to write the log file in WAL mode, with its
+    //! checkpoints made on a background thread instead of by the commits of the logging
+    //! thread. The background thread makes a PASSIVE checkpoint (one that never holds up a
+    //! commit) every __interval__ milliseconds, and whenever a commit leaves at least
+    //! __pageThreshold__ pages in the WAL. Once nothing has been committed for an interval, the
+    //! rest of the WAL is checkpointed, and the next commit starts the WAL over and truncates
+    //! it. WAL checkpointing can be combined with __SL_SetAsyncWrites__, since commits are only
+    //! published in the WAL index once their writes are done. The log file stays in WAL mode
+    //! after the session. __SL_SetWALCheckpointing__ must be called before __SL_Initialize__.
+    //! @code
+    //! int32_t result = SL_SetWALCheckpointing(1000, 4096);
+    //! @endcode
+    //! @param [in] interval The time between checkpoints, in milliseconds (0 checkpoints only
+    //! when the WAL reaches __pageThreshold__).
+    //! @param [in] pageThreshold The number of WAL pages that triggers a checkpoint (0
+    //! checkpoints only every __interval__). Values of 0 for both disable WAL checkpointing
+    //! (the default).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __SL_RESULT_ALREADY_INITIALIZED__ indicates that
+    //! __SL_Initialize__ has already been called.
+    //! @see SL_GetCheckpointStats
+    int32_t SL_SetWALCheckpointing (uint32_t interval, uint32_t pageThreshold);
+
+    //! @fn int32_t SL_SetChunkSize (uint32_t size)
+    //! @brief Call __SL_SetChunkSize__ to grow the log file __size__ bytes at a time
+    //! (SQLite's __SQLITE_FCNTL_CHUNK_SIZE__). Each time the log file fills up, it's extended
+    //! to the next multiple of __size__, and the space is allocated with __posix_fallocate__,
+    //! so the file system allocates large extents, and most commits don't change the size of
+    //! the file (and so don't have to sync it). The log file is never smaller than one chunk.
+    //! __SL_SetChunkSize__ can be called at any time; the log file uses the new size the next
+    //! time it grows.
+    //! @code
+    //! int32_t result = SL_SetChunkSize(64 * 1024 * 1024);
+    //! @endcode
+    //! @param [in] size The number of bytes to grow the log file by, up to 1 GB. A value of 0
+    //! grows the log file a page at a time (the default).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EINVAL__ indicates that the __size__ argument is out of range.
+    //! @note Return values may also include result codes from __sqlite3__.
+    int32_t SL_SetChunkSize (uint32_t size);
+
+    //! @fn int32_t SL_GetCheckpointStats (tSL_CheckpointStats* stats)
+    //! @brief Call __SL_GetCheckpointStats__ to get the statistics of the WAL checkpoints made
+    //! since __SL_Initialize__ was called (they're all 0 if WAL checkpointing isn't enabled).
+    //! @code
+    //! tSL_CheckpointStats stats;
+    //! int32_t result = SL_GetCheckpointStats(&stats);
+    //! @endcode
+    //! @param [out] stats The checkpoint statistics.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that the __stats__ argument is __NULL__.
+    //! @note A return value of __SL_RESULT_NOT_INITIALIZED__ indicates that __SL_Initialize__
+    //! has not been called.
+    int32_t SL_GetCheckpointStats (tSL_CheckpointStats* stats);
+
+    //! @fn int32_t SL_ArchiveClosedLogs (void)
+    //! @brief Call __SL_ArchiveClosedLogs__ to convert the __log__ tables of earlier sessions
+    //! (every __log__ table except the current one) to a columnar archive. The rows of each
+    //! table are split into chunks of 4096 rows, and each column of a chunk is compressed 
+    //! separately and stored in the __log archive__ table. The __log__ table is then replaced
+    //! by a view of the same name over the __sl_archive__ table-valued function, so existing
+    //! queries and views keep working, but only read the columns they need. For example:
+    //! @code
+    //! SELECT log_level, COUNT(*) FROM sl_archive('log at 2022-03-14 10:00:00.000000 CDT') GROUP BY log_level;
+    //! @endcode
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __SL_RESULT_NOT_INITIALIZED__ indicates that __SL_Initialize__ 
+    //! has not been called.
+    //! @warning Like __sl_decompress__, the __sl_archive__ table-valued function is only 
+    //! registered with the SQLite Logger database connection.
+    int32_t SL_ArchiveClosedLogs (void);
+
+    //! @fn int32_t SL_Query (const char* sql, tSL_QueryCallback callback, void* context)
+    //! @brief Call __SL_Query__ to run SQL on the SQLite Logger database connection. Unlike 
+    //! other connections to the log file, this connection can see the log entries that haven't
+    //! been written to the log file yet, through the __sl_pending__ table, and the 
+    //! __log at <timestamp>.live__ view of the current __log__ table combines both. The view is
+    //! TEMP, so it's only there for the current session, on this connection. Querying doesn't
+    //! write the pending entries.
+    //! @code
+    //! int32_t result = SL_Query("SELECT log_message FROM sl_pending WHERE log_level = 'Error'",
+    //!                           myCallback, NULL);
+    //! @endcode
+    //! @param [in] sql The SQL to run (one or more statements).
+    //! @param [in] callback A function called for each result row, or __NULL__.
+    //! @param [in] context A pointer passed to __callback__.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that the __sql__ argument is __NULL__.
+    //! @note A return value of __SL_RESULT_NOT_INITIALIZED__ indicates that __SL_Initialize__ 
+    //! has not been called.
+    //! @note Return values may also include result codes from __sqlite3__.
+    int32_t SL_Query (const char* sql, tSL_QueryCallback callback, void* context);
+
+    //! @fn int32_t SL_Subscribe (const tSL_SubscriptionFilter* filter, tSL_SubscriptionCallback callback, void* context, uint32_t* subscriptionId)
+    //! @brief Call __SL_Subscribe__ to have log entries delivered to a callback as they're
+    //! logged (or as they're written to the log file). The callback is called on the thread
+    //! that logs (or writes) the entry, so it should return quickly, and it must not call 
+    //! SQLite Logger functions. Delivery doesn't take a lock, so subscribing and unsubscribing
+    //! are safe from any thread. Up to 16 subscriptions can be active at once.
+    //! @code
+    //! tSL_SubscriptionFilter filter = {eSL_LogLevel_Error, NULL, false};
+    //! uint32_t subscriptionId = 0;
+    //! int32_t result = SL_Subscribe(&filter, myCallback, NULL, &subscriptionId);
+    //! @endcode
+    //! @param [in] filter Which entries to deliver, and when. The tag is copied.
+    //! @param [in] callback The function to deliver entries to.
+    //! @param [in] context A pointer passed to __callback__.
+    //! @param [out] subscriptionId The id to pass to __SL_Unsubscribe__.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that an argument other than __context__ 
+    //! is __NULL__.
+    //! @note A return value of __EINVAL__ indicates that the filter level is invalid.
+    //! @note A return value of __ENOSPC__ indicates that there are too many subscriptions.
+    //! @see SL_Unsubscribe
+    int32_t SL_Subscribe (const tSL_SubscriptionFilter* filter, 
+                          tSL_SubscriptionCallback callback, 
+                          void* context, 
+                          uint32_t* subscriptionId);
+
+    //! @fn int32_t SL_Unsubscribe (uint32_t subscriptionId)
+    //! @brief Call __SL_Unsubscribe__ to stop delivering log entries to a subscriber. When
+    //! __SL_Unsubscribe__ returns, the subscriber's callback is no longer running on any thread.
+    //! A callback can unsubscribe its own subscription (but no other); it isn't called again
+    //! once it returns.
+    //! @code
+    //! int32_t result = SL_Unsubscribe(subscriptionId);
+    //! @endcode
+    //! @param [in] subscriptionId The id returned by __SL_Subscribe__.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __ENOENT__ indicates that there's no such subscription.
+    //! @see SL_Subscribe
+    int32_t SL_Unsubscribe (uint32_t subscriptionId);
+
+    //! @fn int32_t SL_Export (const char* logPath, const char* outputPath, const tSL_ExportOptions* options)
+    //! @brief Call __SL_Export__ to export log entries from a log file to an NDJSON or CSV file,
+    //! for loading into other tools. Each exported row has a __log_table__ column naming the
+    //! __log__ table it came from, followed by the __log__ table columns (compressed and
+    //! archived values are exported as text). Entries are exported in session order, and in
+    //! __log_id__ order within a session. Time limits are compared with __log_timestamp__ as
+    //! text, so they should have the same form (for example, "2022-03-14 10:00:00"). With more
+    //! than one thread, each session is split into __log_id__ ranges that the threads format in
+    //! memory, in parallel, and the calling thread writes the ranges to __outputPath__ in order.
+    //! __SL_Export__ opens its own read-only connections to the log file, so it doesn't need
+    //! __SL_Initialize__ to have been called.
+    //! @code
+    //! tSL_ExportOptions options = {eSL_ExportFormat_NDJSON, NULL, "2022-03-14 10:00:00", NULL, 4};
+    //! int32_t result = SL_Export("/home/my-user/my-log-file.sqlite3", "/tmp/my-log.ndjson", &options);
+    //! @endcode
+    //! @param [in] logPath The path to the log file.
+    //! @param [in] outputPath The path to the export file (overwritten if it exists).
+    //! @param [in] options What to export, and how.
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that an argument is __NULL__.
+    //! @note A return value of __EINVAL__ indicates that the export format is invalid.
+    //! @note Return values may also include __errno__ values from file operations, and result
+    //! codes from __sqlite3__.
+    int32_t SL_Export (const char* logPath, const char* outputPath, const tSL_ExportOptions* options);
+
+    //! @fn int32_t SL_Import (const char* inputPath, const tSL_ImportOptions* options, uint64_t* entryCount)
+    //! @brief Call __SL_Import__ to import a text or NDJSON log file into a new __log__ table
+    //! (with its own views), so that logs from before SQLite Logger can be queried like the
+    //! logs of earlier sessions. The table is named for the time of the import. Lines are
+    //! parsed on separate threads, and the entries are written on the calling thread in batches,
+    //! the same way logged entries are (including compression), but without log level
+    //! filtering, rate limiting or sampling, and without delivery to subscribers. Entries
+    //! without a timestamp (like the lines of a stack trace) get the timestamp of the entry
+    //! before them (or the time of the import, if no entry before them has one), entries
+    //! without a log level are info entries, and lines that can't be parsed are skipped. Entries logged before the import
+    //! are written first, and stay in the current __log__ table.
+    //! @code
+    //! tSL_ImportOptions options = {eSL_ImportFormat_NDJSON, 4};
+    //! uint64_t entryCount = 0;
+    //! int32_t result = SL_Import("/home/my-user/old-log.ndjson", &options, &entryCount);
+    //! @endcode
+    //! @param [in] inputPath The path to the file to import.
+    //! @param [in] options What to import, and how.
+    //! @param [out] entryCount The number of entries imported (may be __NULL__).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that __inputPath__ or __options__ is
+    //! __NULL__.
+    //! @note A return value of __EINVAL__ indicates that the import format is invalid.
+    //! @note A return value of __SL_RESULT_NOT_INITIALIZED__ indicates that __SL_Initialize__
+    //! has not been called.
+    //! @note Return values may also include __errno__ values from file operations, and result
+    //! codes from __sqlite3__.
+    //! @warning If the import fails part way, the entries written so far stay in the new
+    //! __log__ table.
+    int32_t SL_Import (const char* inputPath, const tSL_ImportOptions* options, uint64_t* entryCount);
+
+    //! @fn int32_t SL_Merge (const char* const* logPaths, uint32_t logCount, const char* outputPath, const tSL_MergeOptions* options, uint64_t* entryCount)
+    //! @brief Call __SL_Merge__ to merge the sessions of several log files (for example, one
+    //! per host or process) into a single stream of entries, ordered by timestamp. Each
+    //! __log__ table (and archived __log__ table) is read in timestamp order (then log id
+    //! order), a batch at a time, and the tables are merged as they are read, so the log files
+    //! are never loaded into memory. Log tables have no timestamp index, so SQLite sorts each
+    //! one as it starts reading it, which costs a pass over the table, and temporary files for
+    //! large tables. Ties go to the earlier log file in __logPaths__ (and then to the earlier
+    //! session). A database output gets a new __log__ table, named for the timestamp of its
+    //! first entry, that is written in a single transaction. __SL_Merge__ doesn't need
+    //! __SL_Initialize__ to have been called.
+    //! @code
+    //! const char* logPaths[] = {"/home/my-user/host-1.sqlite3", "/home/my-user/host-2.sqlite3"};
+    //! tSL_MergeOptions options = {eSL_MergeOutput_Database, NULL, NULL, 2};
+    //! uint64_t entryCount = 0;
+    //! int32_t result = SL_Merge(logPaths, 2, "/home/my-user/merged.sqlite3", &options, &entryCount);
+    //! @endcode
+    //! @param [in] logPaths The paths to the log files to merge.
+    //! @param [in] logCount The number of log files to merge.
+    //! @param [in] outputPath The path to the output file (a database output may already exist).
+    //! @param [in] options What to merge, and how.
+    //! @param [out] entryCount The number of entries merged (may be __NULL__).
+    //! @return A status code indicating whether the function call succeeded.
+    //! @note A return value of __SL_RESULT_SUCCESS__ indicates the function call succeeded.
+    //! @note A return value of __EFAULT__ indicates that __logPaths__, one of the log file
+    //! paths, __outputPath__ or __options__ is __NULL__.
+    //! @note A return value of __EINVAL__ indicates that __logCount__ is 0 or the output is
+    //! invalid.
+    //! @note Return values may also include __errno__ values from file operations, and result
+    //! codes from __sqlite3__.
+    //! @warning Timestamps are compared as text, so the log files should be logged in the same
+    //! time zone. The output file must not be one of the log files.
+    int32_t SL_Merge (const char* const* logPaths,
+                      uint32_t logCount,
+                      const char* outputPath,
+                      const tSL_MergeOptions* options,
+                      uint64_t* entryCount);
+
     //! @fn const char* SL_Result_String (int32_t resultCode)
     //! @brief Call __SL_Result_String__ to get a description of a result code.
     //! @code
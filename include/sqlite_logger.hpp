@@ -0,0 +1,612 @@
+// =================================================================================================
+//! @file sqlite_logger.hpp
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the header-only C++ interface for the SQLite Logger.
+//! @remarks Requires ISO C++17 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-30
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#pragma once
+
+#ifndef __SQLITE_LOGGER_HPP__
+#define __SQLITE_LOGGER_HPP__
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include "sqlite_logger.h"
+
+#if __cplusplus >= 202002L
+    #define SL_COMPILE_TIME_FORMATS     1
+#else
+    #define SL_COMPILE_TIME_FORMATS     0
+#endif
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+//! @brief The lowest log level that C++ log records are compiled for. Records of lower levels
+//! compile to nothing, including the formatting of their messages.
+#ifndef SL_MINIMUM_COMPILED_LOG_LEVEL
+#define SL_MINIMUM_COMPILED_LOG_LEVEL   eSL_LogLevel_Diagnostic
+#endif
+
+//! @brief The size of the buffers that C++ log records are formatted in (longer messages are
+//! truncated, as __SL_Log__ truncates them).
+#define SL_RECORD_BUFFER_SIZE           1024
+
+//! @brief The number of C++ log records that can be formatting at once (records are
+//! nested when a value streamed into one logs a record of its own).
+#define SL_RECORD_BUFFER_COUNT          4
+
+//! @brief The most pieces (runs of text and placeholders) that a compile-time format can be
+//! parsed into.
+#define SL_FORMAT_MAX_PIECE_COUNT       32
+
+namespace SL
+{
+    // =============================================================================================
+    //  Record
+    // =============================================================================================
+
+    //! @class Record
+    //! @brief A log entry being formatted. A record is created by __Logger::Log__ (or one of
+    //! the level methods), has values streamed into it with __operator<<__, and is logged when
+    //! it's destroyed (at the end of the statement that created it), or by __Commit__. Values
+    //! are formatted into one of a few static buffers without allocating memory (so records,
+    //! like __SL_Log__, must only be used by one thread at a time), and records are move-only,
+    //! so a record is only ever logged once.
+    //! @code
+    //! logger.Info("Network") << "Connected to " << host << " in " << milliseconds << " ms.";
+    //! @endcode
+    class Record
+    {
+    public:
+        //! @brief Creates a record, which is inactive (and ignores what's streamed into it) if
+        //! its level is below SQLite Logger's log level, or if there's no free buffer.
+        Record (tSL_LogLevel level,
+                const char* tag,
+                const char* supplementalData,
+                const char* fileName,
+                const char* functionName,
+                uint32_t lineNumber) noexcept :
+            mLevel(level),
+            mTag(tag),
+            mSupplementalData(supplementalData),
+            mFileName(fileName),
+            mFunctionName(functionName),
+            mLineNumber(lineNumber)
+        {
+            tSL_LogLevel logLevel = eSL_LogLevel_Info;
+
+            if ((SL_GetLogLevel(&logLevel) == SL_RESULT_SUCCESS) && (level >= logLevel))
+                mBuffer = ClaimBuffer();
+        }
+
+        //! @brief Takes over another record, which is left inactive.
+        Record (Record&& other) noexcept :
+            mLevel(other.mLevel),
+            mTag(other.mTag),
+            mSupplementalData(other.mSupplementalData),
+            mFileName(other.mFileName),
+            mFunctionName(other.mFunctionName),
+            mLineNumber(other.mLineNumber),
+            mBuffer(other.mBuffer),
+            mLength(other.mLength)
+        {
+            other.mBuffer = nullptr;
+        }
+
+        Record (const Record&) = delete;
+        Record& operator= (const Record&) = delete;
+        Record& operator= (Record&&) = delete;
+
+        //! @brief Logs the record, unless it's been committed (or is inactive).
+        ~Record (void) noexcept
+        {
+            (void)Commit();
+        }
+
+        //! @brief Logs the record now, and makes it inactive.
+        //! @return The result of __SL_Log__, or __SL_RESULT_SUCCESS__ if the record is inactive.
+        int32_t Commit (void) noexcept
+        {
+            int32_t result = SL_RESULT_SUCCESS;
+
+            if (mBuffer != nullptr)
+            {
+                mBuffer[mLength] = '\0';
+                result = SL_Log(mBuffer, mLevel, mFileName, mFunctionName, mLineNumber,
+                                mTag, mSupplementalData);
+                ReleaseBuffer(mBuffer);
+                mBuffer = nullptr;
+            }
+            return result;
+        }
+
+        //! @brief Whether the record is formatting a message to log.
+        bool Active (void) const noexcept
+        {
+            return mBuffer != nullptr;
+        }
+
+        //! @brief Appends text to the message.
+        Record& operator<< (std::string_view text) noexcept
+        {
+            if (mBuffer != nullptr)
+                Append(text.data(), text.size());
+            return *this;
+        }
+
+        //! @brief Appends a string to the message ("(null)" for a null pointer).
+        Record& operator<< (const char* text) noexcept
+        {
+            return *this << std::string_view((text != nullptr) ? text : "(null)");
+        }
+
+        //! @brief Appends a character to the message.
+        Record& operator<< (char character) noexcept
+        {
+            if (mBuffer != nullptr)
+                Append(&character, 1);
+            return *this;
+        }
+
+        //! @brief Appends "true" or "false" to the message.
+        Record& operator<< (bool value) noexcept
+        {
+            return *this << std::string_view(value ? "true" : "false");
+        }
+
+        //! @brief Appends an integer (in decimal) or a floating point number (as printf's %g
+        //! formats it) to the message.
+        template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+        Record& operator<< (T value) noexcept
+        {
+            if ((mBuffer != nullptr) && (mLength < (SL_RECORD_BUFFER_SIZE - 1)))
+            {
+                if constexpr (std::is_integral_v<T>)
+                {
+                    std::to_chars_result converted = std::to_chars(mBuffer + mLength,
+                                                                   mBuffer + SL_RECORD_BUFFER_SIZE - 1, value);
+
+                    mLength = (converted.ec == std::errc()) ? (size_t)(converted.ptr - mBuffer) : mLength;
+                }
+                else
+                {
+                    int length = snprintf(mBuffer + mLength, SL_RECORD_BUFFER_SIZE - mLength, "%g", (double)value);
+
+                    if (length > 0)
+                        mLength = std::min(mLength + (size_t)length, (size_t)(SL_RECORD_BUFFER_SIZE - 1));
+                }
+            }
+            return *this;
+        }
+
+        //! @brief Appends a pointer (in hexadecimal) to the message.
+        Record& operator<< (const void* pointer) noexcept
+        {
+            if ((mBuffer != nullptr) && (mLength < (SL_RECORD_BUFFER_SIZE - 1)))
+            {
+                int length = snprintf(mBuffer + mLength, SL_RECORD_BUFFER_SIZE - mLength, "%p", pointer);
+
+                if (length > 0)
+                    mLength = std::min(mLength + (size_t)length, (size_t)(SL_RECORD_BUFFER_SIZE - 1));
+            }
+            return *this;
+        }
+
+    private:
+        //  Appends as much of the text as fits
+        void Append (const char* text, size_t length) noexcept
+        {
+            size_t available = SL_RECORD_BUFFER_SIZE - 1 - mLength;
+
+            if (length > available)
+                length = available;
+            memcpy(mBuffer + mLength, text, length);
+            mLength += length;
+        }
+
+        //  Claims a free buffer, if there is one
+        static char* ClaimBuffer (void) noexcept
+        {
+            char* buffer = nullptr;
+
+            for (uint32_t i = 0; (i < SL_RECORD_BUFFER_COUNT) && (buffer == nullptr); i++)
+            {
+                if ((sClaimedBuffers & (1u << i)) == 0)
+                {
+                    sClaimedBuffers |= (1u << i);
+                    buffer = sBuffers[i];
+                }
+            }
+            return buffer;
+        }
+
+        //  Frees a buffer claimed by ClaimBuffer (records can be destroyed in any order)
+        static void ReleaseBuffer (char* buffer) noexcept
+        {
+            sClaimedBuffers &= ~(1u << (uint32_t)((buffer - sBuffers[0]) / SL_RECORD_BUFFER_SIZE));
+        }
+
+        tSL_LogLevel    mLevel;
+        const char*     mTag;
+        const char*     mSupplementalData;
+        const char*     mFileName;
+        const char*     mFunctionName;
+        uint32_t        mLineNumber;
+        char*           mBuffer = nullptr;  // Null when inactive
+        size_t          mLength = 0;
+
+        static inline char sBuffers[SL_RECORD_BUFFER_COUNT][SL_RECORD_BUFFER_SIZE];
+        static inline uint32_t sClaimedBuffers = 0;
+    };
+
+    // =============================================================================================
+    //  NullRecord
+    // =============================================================================================
+
+    //! @class NullRecord
+    //! @brief What a log level below __SL_MINIMUM_COMPILED_LOG_LEVEL__ creates instead of a
+    //! __Record__; it ignores everything streamed into it, so the compiler drops the statement.
+    class NullRecord
+    {
+    public:
+        template <typename T>
+        constexpr const NullRecord& operator<< (const T&) const noexcept
+        {
+            return *this;
+        }
+
+        constexpr int32_t Commit (void) const noexcept
+        {
+            return SL_RESULT_SUCCESS;
+        }
+
+        constexpr bool Active (void) const noexcept
+        {
+            return false;
+        }
+    };
+
+    // =============================================================================================
+    //  Logger
+    // =============================================================================================
+
+    //! @class Logger
+    //! @brief An SQLite Logger session: the constructor calls __SL_Initialize__, and the
+    //! destructor calls __SL_Terminate__. SQLite Logger has one session per process, so a
+    //! logger can be moved, but not copied. The file name, function name and line number of a
+    //! record are those of the call that created it. Like the C interface, a logger (and its
+    //! records and spans) must only be used by one thread at a time.
+    //! @code
+    //! SL::Logger logger("/var/log/service.sqlite3");
+    //! if (logger)
+    //!     logger.Warning("Disk") << "Only " << freeMegabytes << " MB left.";
+    //! @endcode
+    class Logger
+    {
+    public:
+        //! @brief Initializes SQLite Logger with the log file at __path__ (__Result__ tells
+        //! whether it succeeded).
+        explicit Logger (const char* path) noexcept :
+            mResult(SL_Initialize(path))
+        {
+        }
+
+        //! @brief Takes over another logger's session.
+        Logger (Logger&& other) noexcept :
+            mResult(other.mResult)
+        {
+            other.mResult = SL_RESULT_NOT_INITIALIZED;
+        }
+
+        Logger (const Logger&) = delete;
+        Logger& operator= (const Logger&) = delete;
+        Logger& operator= (Logger&&) = delete;
+
+        //! @brief Terminates SQLite Logger, if this logger initialized it.
+        ~Logger (void) noexcept
+        {
+            if (mResult == SL_RESULT_SUCCESS)
+                (void)SL_Terminate();
+        }
+
+        //! @brief The result of __SL_Initialize__.
+        int32_t Result (void) const noexcept
+        {
+            return mResult;
+        }
+
+        //! @brief Whether SQLite Logger was initialized.
+        explicit operator bool (void) const noexcept
+        {
+            return mResult == SL_RESULT_SUCCESS;
+        }
+
+        //! @brief Creates a record of log level __Level__ (a __NullRecord__ if the level is
+        //! below __SL_MINIMUM_COMPILED_LOG_LEVEL__).
+        template <tSL_LogLevel Level>
+        auto Log (const char* tag = nullptr,
+                  const char* supplementalData = nullptr,
+                  const char* fileName = __builtin_FILE(),
+                  const char* functionName = __builtin_FUNCTION(),
+                  uint32_t lineNumber = __builtin_LINE()) const noexcept
+        {
+            if constexpr (Level < SL_MINIMUM_COMPILED_LOG_LEVEL)
+                return NullRecord();
+            else
+                return Record(Level, tag, supplementalData, fileName, functionName, lineNumber);
+        }
+
+        //! @brief Creates a diagnostic record.
+        auto Diagnostic (const char* tag = nullptr,
+                         const char* supplementalData = nullptr,
+                         const char* fileName = __builtin_FILE(),
+                         const char* functionName = __builtin_FUNCTION(),
+                         uint32_t lineNumber = __builtin_LINE()) const noexcept
+        {
+            return Log<eSL_LogLevel_Diagnostic>(tag, supplementalData, fileName, functionName, lineNumber);
+        }
+
+        //! @brief Creates a detail record.
+        auto Detail (const char* tag = nullptr,
+                     const char* supplementalData = nullptr,
+                     const char* fileName = __builtin_FILE(),
+                     const char* functionName = __builtin_FUNCTION(),
+                     uint32_t lineNumber = __builtin_LINE()) const noexcept
+        {
+            return Log<eSL_LogLevel_Detail>(tag, supplementalData, fileName, functionName, lineNumber);
+        }
+
+        //! @brief Creates an info record.
+        auto Info (const char* tag = nullptr,
+                   const char* supplementalData = nullptr,
+                   const char* fileName = __builtin_FILE(),
+                   const char* functionName = __builtin_FUNCTION(),
+                   uint32_t lineNumber = __builtin_LINE()) const noexcept
+        {
+            return Log<eSL_LogLevel_Info>(tag, supplementalData, fileName, functionName, lineNumber);
+        }
+
+        //! @brief Creates a warning record.
+        auto Warning (const char* tag = nullptr,
+                      const char* supplementalData = nullptr,
+                      const char* fileName = __builtin_FILE(),
+                      const char* functionName = __builtin_FUNCTION(),
+                      uint32_t lineNumber = __builtin_LINE()) const noexcept
+        {
+            return Log<eSL_LogLevel_Warning>(tag, supplementalData, fileName, functionName, lineNumber);
+        }
+
+        //! @brief Creates an error record.
+        auto Error (const char* tag = nullptr,
+                    const char* supplementalData = nullptr,
+                    const char* fileName = __builtin_FILE(),
+                    const char* functionName = __builtin_FUNCTION(),
+                    uint32_t lineNumber = __builtin_LINE()) const noexcept
+        {
+            return Log<eSL_LogLevel_Error>(tag, supplementalData, fileName, functionName, lineNumber);
+        }
+
+    private:
+        int32_t mResult;
+    };
+
+    // =============================================================================================
+    //  ScopedSpan
+    // =============================================================================================
+
+    //! @class ScopedSpan
+    //! @brief A timing span that begins when it's constructed and ends when it's destroyed
+    //! (see __SL_SpanBegin__). Spans constructed while another span is in scope are nested in
+    //! it.
+    //! @code
+    //! {
+    //!     SL::ScopedSpan span("Load configuration", "Startup");
+    //!     ...
+    //! }
+    //! @endcode
+    class ScopedSpan
+    {
+    public:
+        //! @brief Begins a span (__Id__ is __SL_NO_PARENT_SPAN__ if it couldn't be begun).
+        explicit ScopedSpan (const char* name, const char* tag = nullptr) noexcept :
+            mParentId(sCurrentId)
+        {
+            if (SL_SpanBegin(name, tag, mParentId, &mId) == SL_RESULT_SUCCESS)
+                sCurrentId = mId;
+            else
+                mId = SL_NO_PARENT_SPAN;
+        }
+
+        ScopedSpan (const ScopedSpan&) = delete;
+        ScopedSpan& operator= (const ScopedSpan&) = delete;
+
+        //! @brief Ends the span.
+        ~ScopedSpan (void) noexcept
+        {
+            if (mId != SL_NO_PARENT_SPAN)
+            {
+                (void)SL_SpanEnd(mId);
+                sCurrentId = mParentId;
+            }
+        }
+
+        //! @brief The id of the span.
+        tSL_SpanId Id (void) const noexcept
+        {
+            return mId;
+        }
+
+    private:
+        tSL_SpanId  mId = SL_NO_PARENT_SPAN;
+        tSL_SpanId  mParentId;
+
+        static inline tSL_SpanId sCurrentId = SL_NO_PARENT_SPAN;
+    };
+
+#if SL_COMPILE_TIME_FORMATS
+    // =============================================================================================
+    //  FormatString
+    // =============================================================================================
+
+    //! @concept Formattable
+    //! @brief A type of value that can be an argument of a compile-time format.
+    template <typename T>
+    concept Formattable = requires (Record& record, const T& value) { record << value; };
+
+    //! @class FormatString
+    //! @brief A format for arguments of types __Args__, parsed when it's compiled. Each __{}__
+    //! is replaced by the next argument (as __Record::operator<<__ formats it), and __{{__ and
+    //! __}}__ stand for __{__ and __}__. A format that doesn't parse, or doesn't have one
+    //! placeholder for each argument, doesn't compile. The file name, function name and line
+    //! number are those of the call that the format is written in.
+    template <typename... Args>
+    class FormatString
+    {
+    public:
+        //  A run of the format's text (argument < 0), or a placeholder for an argument
+        struct Piece
+        {
+            uint16_t    offset;
+            uint16_t    length;
+            int16_t     argument;
+        };
+
+        template <size_t N>
+        consteval FormatString (const char (&format)[N],
+                                const char* fileName = __builtin_FILE(),
+                                const char* functionName = __builtin_FUNCTION(),
+                                uint32_t lineNumber = __builtin_LINE()) :
+            mFormat(format),
+            mFileName(fileName),
+            mFunctionName(functionName),
+            mLineNumber(lineNumber)
+        {
+            size_t start = 0;
+            size_t i = 0;
+            int16_t argumentCount = 0;
+
+            // Errors are thrown, which stops the compiler with the message
+            static_assert(N <= UINT16_MAX, "SQLite Logger formats are limited to 64 KB");
+            while (i < (N - 1))
+            {
+                if ((format[i] == '{') || (format[i] == '}'))
+                {
+                    bool placeholder = (format[i] == '{') && (format[i + 1] == '}');
+
+                    if (!placeholder && (format[i + 1] != format[i]))
+                        throw "SQLite Logger format has a '{' or '}' that isn't part of {}, {{ or }}";
+
+                    // Text up to an escaped brace includes one of the braces
+                    AddPiece(start, i - start + (placeholder ? 0 : 1), -1);
+                    if (placeholder)
+                    {
+                        if (argumentCount == (int16_t)sizeof...(Args))
+                            throw "SQLite Logger format has more placeholders than arguments";
+                        AddPiece(i, 0, argumentCount++);
+                    }
+                    i += 2;
+                    start = i;
+                }
+                else
+                    i++;
+            }
+            AddPiece(start, (N - 1) - start, -1);
+            if (argumentCount != (int16_t)sizeof...(Args))
+                throw "SQLite Logger format has fewer placeholders than arguments";
+        }
+
+        const char*     mFormat;
+        const char*     mFileName;
+        const char*     mFunctionName;
+        uint32_t        mLineNumber;
+        Piece           mPieces[SL_FORMAT_MAX_PIECE_COUNT] = {};
+        uint32_t        mPieceCount = 0;
+
+    private:
+        consteval void AddPiece (size_t offset, size_t length, int16_t argument)
+        {
+            if ((length > 0) || (argument >= 0))
+            {
+                if (mPieceCount == SL_FORMAT_MAX_PIECE_COUNT)
+                    throw "SQLite Logger format has too many pieces";
+                mPieces[mPieceCount++] = Piece{(uint16_t)offset, (uint16_t)length, argument};
+            }
+        }
+    };
+
+    //! @brief The type of a format for __Args__ (which keeps the format from taking part in
+    //! deducing them).
+    template <typename... Args>
+    using Format = FormatString<std::type_identity_t<Args>...>;
+
+    // =============================================================================================
+    //  Log
+    // =============================================================================================
+
+    //  Streams an argument into a record
+    template <typename T>
+    void AppendArgument (Record& record, const void* value) noexcept
+    {
+        record << *static_cast<const T*>(value);
+    }
+
+    //! @brief Logs __args__ formatted with __format__ at log level __Level__. Nothing is
+    //! formatted unless the entry is logged, and then the format isn't parsed again: its text
+    //! is copied, and the arguments are converted into the gaps.
+    //! @code
+    //! SL_LOG(eSL_LogLevel_Info, "Network", "Connected to {} in {} ms.", host, milliseconds);
+    //! @endcode
+    //! @return The result of __SL_Log__, or __SL_RESULT_SUCCESS__ if the entry isn't logged.
+    template <tSL_LogLevel Level, typename... Args>
+    int32_t Log (const char* tag, Format<Args...> format, const Args&... args) noexcept
+    {
+        static_assert((Formattable<Args> && ...), "SQLite Logger can't format an argument's type");
+
+        int32_t result = SL_RESULT_SUCCESS;
+
+        if constexpr (Level >= SL_MINIMUM_COMPILED_LOG_LEVEL)
+        {
+            Record record(Level, tag, nullptr, format.mFileName, format.mFunctionName, format.mLineNumber);
+
+            if (record.Active())
+            {
+                using Appender = void (*)(Record&, const void*);
+                const void* values[sizeof...(Args) + 1] = {static_cast<const void*>(&args)..., nullptr};
+                const Appender appenders[sizeof...(Args) + 1] = {&AppendArgument<Args>..., nullptr};
+
+                for (uint32_t i = 0; i < format.mPieceCount; i++)
+                {
+                    const typename Format<Args...>::Piece& piece = format.mPieces[i];
+
+                    if (piece.argument < 0)
+                        record << std::string_view(format.mFormat + piece.offset, piece.length);
+                    else
+                        appenders[piece.argument](record, values[piece.argument]);
+                }
+                result = record.Commit();
+            }
+        }
+        return result;
+    }
+#endif
+}
+
+#if SL_COMPILE_TIME_FORMATS
+//! @brief A helper macro to log a message from a compile-time format (C++20 or later).
+#define SL_LOG(level, tag, ...)     SL::Log<level>(tag, __VA_ARGS__)
+#endif
+
+// =================================================================================================
+#endif	// __SQLITE_LOGGER_HPP__
+// =================================================================================================
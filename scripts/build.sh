@@ -65,9 +65,12 @@ ROOT_DIRECTORY_PATH_CMD="--root-directory-path"
 VERBOSE_CMD="--verbose"
 WITH_DOCUMENTATION_CMD="--with-documentation"
 WITH_LOG_ENTRY_CACHE_SIZE_CMD="--with-log-entry-cache-size"
+WITH_LTO_CMD="--with-lto"
+WITH_PGO_CMD="--with-pgo"
 WITH_PROFILING_CMD="--with-profiling"
 WITH_SDK_CMD="--with-sdk"
 WITH_SHARED_LIBS_CMD="--with-shared-libs"
+WITH_SQLITE_TUNING_CMD="--with-sqlite-tuning"
 WITH_UNIT_TESTING_CMD="--with-unit-testing"
 
 # Analyze options
@@ -215,6 +218,27 @@ function printSummary () {
     else
         printWithIndent "Without unit testing\n" $INDENT_LEN
     fi
+
+    if [ $BUILD_SQLITE_TUNING -eq 1 ]
+    then
+        printWithIndent "With SQLite tuning\n" $INDENT_LEN
+    else
+        printWithIndent "Without SQLite tuning\n" $INDENT_LEN
+    fi
+
+    if [ $BUILD_LTO -eq 1 ]
+    then
+        printWithIndent "With link-time optimization\n" $INDENT_LEN
+    else
+        printWithIndent "Without link-time optimization\n" $INDENT_LEN
+    fi
+
+    if [ $BUILD_WITH_PGO -eq 1 ]
+    then
+        printWithIndent "With profile-guided optimization\n" $INDENT_LEN
+    else
+        printWithIndent "Without profile-guided optimization\n" $INDENT_LEN
+    fi
 	
 	printIt " "
 	resetConsoleAttributes
@@ -305,6 +329,8 @@ function printUsage {
 	printIt "\t• Without documentation build"
     printIt "\t• With log entry cache size of '$BUILD_LOG_ENTRY_CACHE_SIZE'"
 	printIt "\t• Without profiling"
+    printIt "\t• With SQLite tuned for the logger"
+    printIt "\t• Without link-time or profile-guided optimization"
     printIt "\t• Without unit testing"
 	printIt " "
 	printIt "\tPossible argument values are:"
@@ -320,9 +346,13 @@ function printUsage {
     printIt "\t$VERBOSE_CMD\t\t\t\t\tPrints all build log output to console."
 	printIt "\t$WITH_DOCUMENTATION_CMD\t\t\t\tBuilds documentation using Doxygen."
     printIt "\t$WITH_LOG_ENTRY_CACHE_SIZE_CMD=<value>\t\tSets the size of the log entry cache."
+    printIt "\t$WITH_LTO_CMD\t\t\t\t\tBuilds with link-time optimization (gcc only; use with --clean)."
+    printIt "\t$WITH_PGO_CMD\t\t\t\t\tBuilds a release version with profile-guided optimization, trained"
+    printIt "\t\t\t\t\t\t\twith the benchmark tool (gcc only)."
 	printIt "\t$WITH_PROFILING_CMD\t\t\t\tBuilds with profiling enabled (Linux only)."
     printIt "\t$WITH_SDK_CMD\t\t\t\t\tCreates a Software Development Kit (SDK) archive in the results directory."
 	printIt "\t$WITH_SHARED_LIBS_CMD\t\t\t\tBuild and link with shared library instead of static library."
+    printIt "\t$WITH_SQLITE_TUNING_CMD\t\t\tBuilds SQLite with options tuned for the logger (use with --clean)."
     printIt "\t$WITH_UNIT_TESTING_CMD\t\t\t\tPerform unit testing after build."
 	printIt " "
 	printIt "\tPrerequisites for running this script include:"
@@ -386,6 +416,12 @@ function parseCommandLineArgument {
         then
             handleError "Log entry cache size can't be zero!"
         fi
+    elif [ "$CMD_LINE_ARG" == $WITH_LTO_CMD ]
+    then
+        BUILD_LTO=1
+    elif [ "$CMD_LINE_ARG" == $WITH_PGO_CMD ]
+    then
+        BUILD_WITH_PGO=1
 	elif [ "$CMD_LINE_ARG" == $WITH_PROFILING_CMD ]
 	then
 		if hasGprof
@@ -426,6 +462,9 @@ function parseCommandLineArgument {
     elif [ "$CMD_LINE_ARG" == $WITH_UNIT_TESTING_CMD ]
     then
         BUILD_WITH_UNIT_TESTING=1
+    elif [ "$CMD_LINE_ARG" == $WITH_SQLITE_TUNING_CMD ]
+    then
+        BUILD_SQLITE_TUNING=1
 	else
 		printError "Unrecognized argument: '$CMD_LINE_ARG'."
 		printIt ""
@@ -480,6 +519,10 @@ BUILD_SDK=0
 BUILD_SHARED_LIB=0
 BUILD_VERBOSE=0
 BUILD_WITH_UNIT_TESTING=0
+BUILD_SQLITE_TUNING=0
+BUILD_LTO=0
+BUILD_WITH_PGO=0
+BUILD_PGO=none
 
 # Log tags
 CLEAN_LOG_PREFIX="_clean_log"
@@ -513,6 +556,13 @@ then
 	fi
 fi
 
+# Profile-guided optimization only makes sense for release builds
+if [ $BUILD_WITH_PGO -eq 1 ]
+then
+    BUILD_DEBUG=0
+    BUILD_RELEASE=1
+fi
+
 # Export debug/release/profile flag
 if [ $BUILD_DEBUG -eq 1 ]
 then
@@ -522,12 +572,6 @@ then
 	BUILD_CFG=Release
 fi
 
-if fileExists "../include/sqlite_logger_config.h"
-then
-	forceDeleteFile "../include/sqlite_logger_config.h"
-fi
-echo "#define SL_LOG_ENTRY_CACHE_SIZE $BUILD_LOG_ENTRY_CACHE_SIZE" >> "../include/sqlite_logger_config.h"
-
 # Create build directory if necessary
 if ! directoryExists "$BUILD_ROOT/$BUILD_PRODUCTS_DIR_NAME/"
 then
@@ -560,6 +604,7 @@ fi
 # Export build environment
 export BUILD_ARCH
 export BUILD_CFG
+export BUILD_LOG_ENTRY_CACHE_SIZE
 export BUILD_LOGS_DIR
 export BUILD_OPERATING_ENV
 export BUILD_PRODUCTS_BIN_DIR
@@ -569,6 +614,9 @@ export BUILD_PROFILE
 export BUILD_RESULTS_DIR
 export BUILD_ROOT
 export BUILD_SHARED_LIB
+export BUILD_SQLITE_TUNING
+export BUILD_LTO
+export BUILD_PGO
 
 printIt " "
 
@@ -610,6 +658,10 @@ then
 
     cleanIt "libsqlitelogger$BUILD_LIB_EXTENSION" "../src" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/libsqlitelogger$CLEAN_LOG_PREFIX$LOG_POSTFIX"
     cleanIt "sqlite_logger_unit_test" "../test" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_unit_test$CLEAN_LOG_PREFIX$LOG_POSTFIX"
+    cleanIt "sqlite_logger_export" "../tools" sqlite_logger_export.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_export$CLEAN_LOG_PREFIX$LOG_POSTFIX"
+    cleanIt "sqlite_logger_import" "../tools" sqlite_logger_import.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_import$CLEAN_LOG_PREFIX$LOG_POSTFIX"
+    cleanIt "sqlite_logger_merge" "../tools" sqlite_logger_merge.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_merge$CLEAN_LOG_PREFIX$LOG_POSTFIX"
+    cleanIt "sqlite_logger_benchmark" "../tools" sqlite_logger_benchmark.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_benchmark$CLEAN_LOG_PREFIX$LOG_POSTFIX"
 fi
 
 # =================================================================================================
@@ -629,6 +681,7 @@ then
 
         checkIt "libsqlitelogger" "../src" $BUILD_VERBOSE "$BUILD_LOGS_DIR/libsqlitelogger$CPPCHECK_LOG_PREFIX$LOG_POSTFIX" ""
         checkIt "sqlite_logger_unit_test" "../test" $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_unit_test$CPPCHECK_LOG_PREFIX$LOG_POSTFIX" ""
+        checkIt "tools" "../tools" $BUILD_VERBOSE "$BUILD_LOGS_DIR/tools$CPPCHECK_LOG_PREFIX$LOG_POSTFIX" ""
     fi
 fi
 
@@ -645,6 +698,10 @@ then
 
         scanIt "libsqlitelogger" "../src" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/libsqlitelogger$SCAN_BUILD_LOG_PREFIX$LOG_POSTFIX"
         scanIt "sqlite_logger_unit_test" "../test" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_unit_test$SCAN_BUILD_LOG_PREFIX$LOG_POSTFIX"
+        scanIt "sqlite_logger_export" "../tools" sqlite_logger_export.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_export$SCAN_BUILD_LOG_PREFIX$LOG_POSTFIX"
+        scanIt "sqlite_logger_import" "../tools" sqlite_logger_import.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_import$SCAN_BUILD_LOG_PREFIX$LOG_POSTFIX"
+        scanIt "sqlite_logger_merge" "../tools" sqlite_logger_merge.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_merge$SCAN_BUILD_LOG_PREFIX$LOG_POSTFIX"
+        scanIt "sqlite_logger_benchmark" "../tools" sqlite_logger_benchmark.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_benchmark$SCAN_BUILD_LOG_PREFIX$LOG_POSTFIX"
     fi
 fi
 
@@ -654,11 +711,45 @@ fi
 
 printBanner "BUILD"
 
+# Profile-guided optimization builds an instrumented library and benchmark tool, runs the
+# benchmark to write the profiles, and then rebuilds everything with the profiles
+if [ $BUILD_WITH_PGO -eq 1 ]
+then
+    BUILD_PGO_OBJ_DIR="$BUILD_ROOT/$BUILD_PRODUCTS_DIR_NAME/$BUILD_PRODUCTS_OBJ_DIR/$BUILD_OPERATING_ENV/$BUILD_ARCH/$BUILD_CFG"
+
+    BUILD_PGO=generate
+    export BUILD_PGO
+    rm -f "$BUILD_PGO_OBJ_DIR/"*.gcda
+    cleanIt "libsqlitelogger$BUILD_LIB_EXTENSION" "../src" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/libsqlitelogger$CLEAN_LOG_PREFIX$LOG_POSTFIX"
+    cleanIt "sqlite_logger_benchmark" "../tools" sqlite_logger_benchmark.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_benchmark$CLEAN_LOG_PREFIX$LOG_POSTFIX"
+    buildIt "libsqlitelogger$BUILD_LIB_EXTENSION (instrumented)" "../src" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/libsqlitelogger_pgo$BUILD_LOG_PREFIX$LOG_POSTFIX" ""
+    buildIt "sqlite_logger_benchmark (instrumented)" "../tools" sqlite_logger_benchmark.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_benchmark_pgo$BUILD_LOG_PREFIX$LOG_POSTFIX" ""
+
+    printIt "Training with the benchmark tool..."
+    rm -f "$BUILD_RESULTS_DIR/sqlite_logger_pgo_training.sqlite3"
+    if ! "$PROG_DIR/sqlite_logger_benchmark" -n 1000000 -r 1 "$BUILD_RESULTS_DIR/sqlite_logger_pgo_training.sqlite3" > "$BUILD_LOGS_DIR/sqlite_logger_pgo_training$LOG_POSTFIX" 2>&1
+    then
+        cat "$BUILD_LOGS_DIR/sqlite_logger_pgo_training$LOG_POSTFIX"
+        handleError "Training with the benchmark tool failed!"
+    fi
+    rm -f "$BUILD_RESULTS_DIR/sqlite_logger_pgo_training.sqlite3"
+    printSuccess "\tTraining succeeded.\n"
+
+    BUILD_PGO=use
+    export BUILD_PGO
+    cleanIt "libsqlitelogger$BUILD_LIB_EXTENSION" "../src" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/libsqlitelogger$CLEAN_LOG_PREFIX$LOG_POSTFIX"
+    cleanIt "sqlite_logger_benchmark" "../tools" sqlite_logger_benchmark.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_benchmark$CLEAN_LOG_PREFIX$LOG_POSTFIX"
+fi
+
 # Libraries
 buildIt "libsqlitelogger$BUILD_LIB_EXTENSION" "../src" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/libsqlitelogger$BUILD_LOG_PREFIX$LOG_POSTFIX" ""
 
 # Programs
 buildIt "sqlite_logger_unit_test" "../test" makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_unit_test$BUILD_LOG_PREFIX$LOG_POSTFIX" ""
+buildIt "sqlite_logger_export" "../tools" sqlite_logger_export.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_export$BUILD_LOG_PREFIX$LOG_POSTFIX" ""
+buildIt "sqlite_logger_import" "../tools" sqlite_logger_import.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_import$BUILD_LOG_PREFIX$LOG_POSTFIX" ""
+buildIt "sqlite_logger_merge" "../tools" sqlite_logger_merge.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_merge$BUILD_LOG_PREFIX$LOG_POSTFIX" ""
+buildIt "sqlite_logger_benchmark" "../tools" sqlite_logger_benchmark.makefile $BUILD_VERBOSE "$BUILD_LOGS_DIR/sqlite_logger_benchmark$BUILD_LOG_PREFIX$LOG_POSTFIX" ""
 
 # =================================================================================================
 #   Unit test
@@ -741,6 +832,7 @@ then
     cp "../LICENSE" "./$SQLITE_LOGGER_SDK_DIR"
     createDirectory "./$SQLITE_LOGGER_SDK_DIR/include"
     cp "../include/sqlite_logger.h" "./$SQLITE_LOGGER_SDK_DIR/include"
+    cp "../include/sqlite_logger.hpp" "./$SQLITE_LOGGER_SDK_DIR/include"
     if fileExists "$PROG_DIR/libsqlitelogger$BUILD_LIB_EXTENSION"
     then
         createDirectory "./$SQLITE_LOGGER_SDK_DIR/bin"
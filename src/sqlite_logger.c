@@ -11,7 +11,15 @@
 // =================================================================================================
 #include "sqlite_logger.h"
 #include "sqlite_logger_config.h"
+#include "sqlite_logger_compression.h"
+#include "sqlite_logger_archive.h"
+#include "sqlite_logger_checkpoint.h"
+#include "sqlite_logger_export.h"
+#include "sqlite_logger_import.h"
+#include "sqlite_logger_vfs.h"
 #include "sqlite3.h"
+#include <sched.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/time.h>
 #include <time.h>
@@ -33,31 +41,109 @@ static const char* kSL_ResultStrings[4] = {
 
 //  SQL command to create table
 static const char* kSL_CreateTableSQLCommandString = 
-    "CREATE TABLE IF NOT EXISTS `log at %s` (`log_id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, `log_timestamp` TEXT NOT NULL, `log_message` TEXT NOT NULL, `log_level` TEXT NOT NULL, `log_filename` TEXT, `log_functionname` TEXT, `log_linenumber` INTEGER, `log_tag` TEXT, `log_supplementaldata` TEXT)";
+    "CREATE TABLE IF NOT EXISTS `log at %s` (`log_id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, `log_timestamp` TEXT NOT NULL, `log_message` TEXT NOT NULL, `log_level` TEXT NOT NULL, `log_filename` TEXT, `log_functionname` TEXT, `log_linenumber` INTEGER, `log_tag` TEXT, `log_supplementaldata` TEXT, `log_repeat_count` INTEGER NOT NULL DEFAULT 1, `log_last_timestamp` TEXT, `log_sample_rate` REAL NOT NULL DEFAULT 1.0, `log_dictionary_id` INTEGER)";
+
+//  SQL command to create dictionary table
+static const char* kSL_CreateDictionaryTableSQLCommandString =
+    "CREATE TABLE IF NOT EXISTS `" SL_DICTIONARY_TABLE_NAME "` (`dictionary_id` INTEGER PRIMARY KEY NOT NULL, `dictionary_timestamp` TEXT NOT NULL, `dictionary_content` BLOB NOT NULL)";
+
+//  SQL command to insert into dictionary table
+static const char* kSL_InsertDictionarySQLCommandString =
+    "INSERT INTO `" SL_DICTIONARY_TABLE_NAME "` (dictionary_timestamp,dictionary_content) VALUES(?,?)";
 
 //  SQL command to insert into table
 static const char* kSL_ParameterizedInsertSQLCommandString =
-    "INSERT INTO `log at %s` (log_timestamp,log_message,log_level,log_filename,log_functionname,log_linenumber,log_tag,log_supplementaldata) VALUES(?,?,?,?,?,?,?,?)";
+    "INSERT INTO `log at %s` (log_timestamp,log_message,log_level,log_filename,log_functionname,log_linenumber,log_tag,log_supplementaldata,log_repeat_count,log_last_timestamp,log_sample_rate,log_dictionary_id) VALUES(?,?,?,?,?,?,?,?,?,?,?,?)";
 
 //  SQL command to create view for diagnostic messages
 static const char* kSL_CreateDiagnosticMessageViewCommandString = 
-    "CREATE VIEW `log at %s.diagnostic_messages` AS SELECT log_timestamp,log_message,log_filename,log_functionname,log_linenumber,log_tag,log_supplementaldata FROM `log at %s` WHERE log_level = 'Diagnostic'";
+    "CREATE VIEW `log at %s.diagnostic_messages` AS SELECT %s FROM `log at %s` WHERE log_level = 'Diagnostic'";
 
 //  SQL command to create view for detail messages
 static const char* kSL_CreateDetailMessageViewCommandString = 
-    "CREATE VIEW `log at %s.detail_messages` AS SELECT log_timestamp,log_message,log_filename,log_functionname,log_linenumber,log_tag,log_supplementaldata FROM `log at %s` WHERE log_level = 'Detail'";
+    "CREATE VIEW `log at %s.detail_messages` AS SELECT %s FROM `log at %s` WHERE log_level = 'Detail'";
 
 //  SQL command to create view for info messages
 static const char* kSL_CreateInfoMessageViewCommandString = 
-    "CREATE VIEW `log at %s.info_messages` AS SELECT log_timestamp,log_message,log_filename,log_functionname,log_linenumber,log_tag,log_supplementaldata FROM `log at %s` WHERE log_level = 'Info'";
+    "CREATE VIEW `log at %s.info_messages` AS SELECT %s FROM `log at %s` WHERE log_level = 'Info'";
 
 //  SQL command to create view for warning messages
 static const char* kSL_CreateWarningMessageViewCommandString = 
-    "CREATE VIEW `log at %s.warning_messages` AS SELECT log_timestamp,log_message,log_filename,log_functionname,log_linenumber,log_tag,log_supplementaldata FROM `log at %s` WHERE log_level = 'Warning'";
+    "CREATE VIEW `log at %s.warning_messages` AS SELECT %s FROM `log at %s` WHERE log_level = 'Warning'";
 
 //  SQL command to create view for error messages
 static const char* kSL_CreateErrorMessageViewCommandString = 
-    "CREATE VIEW `log at %s.error_messages` AS SELECT log_timestamp,log_message,log_filename,log_functionname,log_linenumber,log_tag,log_supplementaldata FROM `log at %s` WHERE log_level = 'Error'";
+    "CREATE VIEW `log at %s.error_messages` AS SELECT %s FROM `log at %s` WHERE log_level = 'Error'";
+
+//  Columns selected by views
+static const char* kSL_ViewColumnsString =
+    "log_timestamp,log_message,log_filename,log_functionname,log_linenumber,log_tag,log_supplementaldata,log_repeat_count,log_last_timestamp,log_sample_rate,log_dictionary_id";
+
+//  Columns selected by views when compression is enabled
+static const char* kSL_CompressedViewColumnsString =
+    "log_timestamp," SL_DECOMPRESS_FUNCTION_NAME "(log_message) AS log_message,log_filename,log_functionname,log_linenumber,log_tag," SL_DECOMPRESS_FUNCTION_NAME "(log_supplementaldata) AS log_supplementaldata,log_repeat_count,log_last_timestamp,log_sample_rate,log_dictionary_id";
+
+//  Name of the table that exposes unflushed log entries
+#define SL_PENDING_MODULE_NAME              "sl_pending"
+
+//  SQL command to create view of logged and pending entries (pending entries are only ever the
+//  current session's, and only this connection can read them, so the view is TEMP, and goes
+//  away with the session)
+static const char* kSL_CreateLiveViewCommandString =
+    "CREATE TEMP VIEW `log at %s.live` AS SELECT log_id,log_level,%s FROM `log at %s` UNION ALL SELECT log_id,log_level,%s FROM " SL_PENDING_MODULE_NAME;
+
+//  Schema of the sl_pending table
+static const char* kSL_PendingSchemaString =
+    "CREATE TABLE x(log_id INTEGER, log_timestamp TEXT, log_message TEXT, log_level TEXT, log_filename TEXT, log_functionname TEXT, log_linenumber INTEGER, log_tag TEXT, log_supplementaldata TEXT, log_repeat_count INTEGER, log_last_timestamp TEXT, log_sample_rate REAL, log_dictionary_id INTEGER)";
+
+//  SQL command to find the next closed log table (the tables of other sessions); merged tables
+//  aren't archived, since the archive has no log_source column
+static const char* kSL_SelectClosedLogTableSQLCommandString =
+    "SELECT m.name FROM sqlite_master AS m WHERE m.type = 'table' AND m.name GLOB 'log at [0-9]*' AND m.name <> ?1 AND EXISTS (SELECT 1 FROM pragma_table_info(m.name) AS c WHERE c.name = 'log_message') AND NOT EXISTS (SELECT 1 FROM pragma_table_info(m.name) AS c WHERE c.name = 'log_source') LIMIT 1";
+
+//  Name of the table of timing spans
+#define SL_SPANS_TABLE_NAME                 "log spans"
+
+//  SQL command to create spans table
+static const char* kSL_CreateSpansTableSQLCommandString =
+    "CREATE TABLE IF NOT EXISTS `" SL_SPANS_TABLE_NAME "` (`span_id` INTEGER PRIMARY KEY NOT NULL, `span_parent_id` INTEGER, `span_name` TEXT NOT NULL, `span_tag` TEXT, `span_timestamp` TEXT NOT NULL, `span_start_ns` INTEGER NOT NULL, `span_end_ns` INTEGER NOT NULL, `span_duration_ns` INTEGER NOT NULL)";
+
+//  SQL command to find the last span id used in the log file
+static const char* kSL_SelectLastSpanIdSQLCommandString =
+    "SELECT IFNULL(MAX(span_id), 0) FROM `" SL_SPANS_TABLE_NAME "`";
+
+//  SQL command to insert into spans table
+static const char* kSL_InsertSpanSQLCommandString =
+    "INSERT INTO `" SL_SPANS_TABLE_NAME "` (span_id,span_parent_id,span_name,span_tag,span_timestamp,span_start_ns,span_end_ns,span_duration_ns) VALUES(?,?,?,?,?,?,?,?)";
+
+//  Name of the table of metrics
+#define SL_METRICS_TABLE_NAME               "log metrics"
+
+//  SQL command to create metrics table
+static const char* kSL_CreateMetricsTableSQLCommandString =
+    "CREATE TABLE IF NOT EXISTS `" SL_METRICS_TABLE_NAME "` (`metric_id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, `metric_name` TEXT NOT NULL, `metric_timestamp` TEXT NOT NULL, `metric_interval` INTEGER NOT NULL, `metric_count` INTEGER NOT NULL, `metric_sum` REAL NOT NULL, `metric_min` REAL NOT NULL, `metric_max` REAL NOT NULL, `metric_last` REAL NOT NULL, `metric_histogram` TEXT NOT NULL)";
+
+//  SQL command to insert into metrics table
+static const char* kSL_InsertMetricSQLCommandString =
+    "INSERT INTO `" SL_METRICS_TABLE_NAME "` (metric_name,metric_timestamp,metric_interval,metric_count,metric_sum,metric_min,metric_max,metric_last,metric_histogram) VALUES(?,?,?,?,?,?,?,?,?)";
+
+//  Name of the table of rollups
+#define SL_ROLLUPS_TABLE_NAME               "log rollups"
+
+//  SQL command to create rollups table
+static const char* kSL_CreateRollupsTableSQLCommandString =
+    "CREATE TABLE IF NOT EXISTS `" SL_ROLLUPS_TABLE_NAME "` (`rollup_minute` TEXT NOT NULL, `rollup_level` TEXT NOT NULL, `rollup_tag` TEXT NOT NULL, `rollup_count` INTEGER NOT NULL, `rollup_repeat_count` INTEGER NOT NULL, PRIMARY KEY (`rollup_minute`, `rollup_level`, `rollup_tag`)) WITHOUT ROWID";
+
+//  SQL command to add counts to rollups table
+static const char* kSL_UpsertRollupSQLCommandString =
+    "INSERT INTO `" SL_ROLLUPS_TABLE_NAME "` (rollup_minute,rollup_level,rollup_tag,rollup_count,rollup_repeat_count) VALUES(?,?,?,?,?) "
+    "ON CONFLICT (rollup_minute,rollup_level,rollup_tag) DO UPDATE SET rollup_count = rollup_count + excluded.rollup_count, "
+    "rollup_repeat_count = rollup_repeat_count + excluded.rollup_repeat_count";
+
+//  SQL commands to control the transaction of each batch
+static const char* kSL_BeginTransactionSQLCommandString = "BEGIN TRANSACTION;";
+static const char* kSL_EndTransactionSQLCommandString = "END TRANSACTION;";
+static const char* kSL_RollbackTransactionSQLCommandString = "ROLLBACK;";
 
 //  Fixed string lengths
 #define SL_TIMESTAMP_STRING_LENGTH          32
@@ -68,6 +154,73 @@ static const char* kSL_CreateErrorMessageViewCommandString =
 #define SL_TAG_STRING_LENGTH                128
 #define SL_SUPPLEMENTAL_DATA_STRING_LENGTH  1024
 
+//  Rate limiting (the table is split into sets of buckets, so messages whose hashes map to the
+//  same set don't evict each other)
+#define SL_RATE_LIMIT_TABLE_SIZE            256
+#define SL_RATE_LIMIT_SET_SIZE              4
+#define SL_MICROSECONDS_PER_SECOND          1000000
+
+//  Sampling
+#define SL_MAX_SAMPLED_TAGS                 16
+
+//  Subscriptions (a slot's status is its state and generation in one word, so they change
+//  together; generations wrap so that the slot and generation fit in a subscription id)
+#define SL_MAX_SUBSCRIPTIONS                16
+#define SL_SUBSCRIPTION_FREE                0
+#define SL_SUBSCRIPTION_CLAIMED             1
+#define SL_SUBSCRIPTION_ACTIVE              2
+#define SL_SUBSCRIPTION_STATE_MASK          0x3
+#define SL_SUBSCRIPTION_GENERATION_SHIFT    2
+#define SL_SUBSCRIPTION_GENERATION_COUNT    ((UINT32_MAX / SL_MAX_SUBSCRIPTIONS) + 1)
+#define SL_SUBSCRIPTION_STATUS(generation, state) \
+    (((uint32_t)(generation) << SL_SUBSCRIPTION_GENERATION_SHIFT) | (uint32_t)(state))
+
+//  Thread-local storage (C11's keyword where it's available, and the compiler extension otherwise)
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L)
+#define SL_THREAD_LOCAL                     _Thread_local
+#else
+#define SL_THREAD_LOCAL                     __thread
+#endif
+
+//  Compression
+#define SL_COMPRESSION_BUFFER_SIZE          (SL_COMPRESSED_VALUE_HEADER_SIZE + SL_MESSAGE_STRING_LENGTH + \
+                                             (SL_MESSAGE_STRING_LENGTH / 255) + 16)
+
+//  Dictionary compression
+#define SL_DICTIONARY_COMPRESSION_THRESHOLD 16  // Minimum length of a value to compress
+#define SL_DICTIONARY_TRAINING_INTERVAL     64  // Batches between dictionary retraining
+
+//  Preallocated memory
+#define SL_MINIMUM_MEMORY_BUDGET            (1024 * 1024)
+#define SL_MAXIMUM_MEMORY_BUDGET            (1024 * 1024 * 1024)
+#define SL_PAGE_SIZE                        4096    // SQLite's default page size
+#define SL_LOOKASIDE_SLOT_SIZE              512
+#define SL_HEAP_MINIMUM_ALLOCATION          64
+
+//  Spans
+#define SL_MAX_OPEN_SPANS                   64
+#define SL_SPAN_CACHE_SIZE                  256
+#define SL_NANOSECONDS_PER_SECOND           1000000000
+
+//  Metrics
+#define SL_MAX_METRICS                      64      // Per interval
+#define SL_METRIC_CACHE_SIZE                256
+#define SL_METRIC_BUCKET_COUNT              32
+#define SL_DEFAULT_METRIC_INTERVAL          60      // In seconds
+#define SL_MAXIMUM_METRIC_INTERVAL          86400
+#define SL_HISTOGRAM_STRING_LENGTH          (SL_METRIC_BUCKET_COUNT * 21 + 2)
+
+//  Rollups
+#define SL_ROLLUP_SLOT_COUNT                (2 * SL_LOG_ENTRY_CACHE_SIZE)
+#define SL_ROLLUP_MINUTE_LENGTH             16      // "YYYY-MM-DD HH:MM"
+#define SL_ROLLUP_SECONDS_LENGTH            10      // ":SS.uuuuuu"
+
+//  Memory limit
+#define SL_MINIMUM_MEMORY_LIMIT             (1024 * 1024)   // Left for SQLite, beyond the buffers
+
+//  File growth
+#define SL_MAXIMUM_CHUNK_SIZE               (1024 * 1024 * 1024)
+
 //  Log level strings
 static const char* kSL_DiagnosticLevelString    = "Diagnostic";
 static const char* kSL_DetailLevelString        = "Detail";
@@ -91,19 +244,171 @@ typedef struct tsl_logentry
     uint32_t    lineNumber;
     char        tag[SL_TAG_STRING_LENGTH];
     char        supplementalData[SL_SUPPLEMENTAL_DATA_STRING_LENGTH];
+    uint32_t    repeatCount;
+    char        lastTimestamp[SL_TIMESTAMP_STRING_LENGTH];
+    double      sampleRate;
+    tSL_LogLevel logLevel;
 }
 tSL_LogEntry;
 
+//  Rate limit bucket
+typedef struct tsl_ratelimitbucket
+{
+    uint64_t    hash;
+    double      tokens;
+    uint64_t    lastRefillTime;
+    uint32_t    entryIndex;
+    uint32_t    batchNumber;
+    bool        inUse;
+}
+tSL_RateLimitBucket;
+
+//  Tag sampling rate
+typedef struct tsl_tagsamplingrate
+{
+    char        tag[SL_TAG_STRING_LENGTH];
+    double      rate;
+}
+tSL_TagSamplingRate;
+
+//  Subscription (state, readers and generation are accessed atomically)
+typedef struct tsl_subscription
+{
+    uint32_t                    status;
+    uint32_t                    readers;
+    tSL_LogLevel                level;
+    bool                        hasTag;
+    char                        tag[SL_TAG_STRING_LENGTH];
+    bool                        onWrite;
+    tSL_SubscriptionCallback    callback;
+    void*                       context;
+}
+tSL_Subscription;
+
+//  Ids of the statements in the statement cache
+typedef enum
+{
+    eSL_Statement_BeginTransaction = 0,
+    eSL_Statement_EndTransaction,
+    eSL_Statement_RollbackTransaction,
+    eSL_Statement_Insert,
+    eSL_Statement_InsertDictionary,
+    eSL_Statement_SelectClosedLogTable,
+    eSL_Statement_CreateSpansTable,
+    eSL_Statement_SelectLastSpanId,
+    eSL_Statement_InsertSpan,
+    eSL_Statement_CreateMetricsTable,
+    eSL_Statement_InsertMetric,
+    eSL_Statement_UpsertRollup,
+    eSL_StatementCount
+}
+tSL_StatementId;
+
+//  Timing span
+typedef struct tsl_span
+{
+    tSL_SpanId  id;
+    tSL_SpanId  parentId;
+    char        name[SL_TAG_STRING_LENGTH];
+    char        tag[SL_TAG_STRING_LENGTH];
+    char        timestamp[SL_TIMESTAMP_STRING_LENGTH];
+    uint64_t    start;          // Monotonic, in ns
+    uint64_t    end;
+}
+tSL_Span;
+
+//  Aggregate of the values of a metric in an interval
+typedef struct tsl_metric
+{
+    char        name[SL_TAG_STRING_LENGTH];
+    char        timestamp[SL_TIMESTAMP_STRING_LENGTH];  // Start of the interval
+    uint64_t    count;
+    double      sum;
+    double      min;
+    double      max;
+    double      last;
+    uint64_t    buckets[SL_METRIC_BUCKET_COUNT];
+}
+tSL_Metric;
+
+//  Count of a batch's log entries with the same minute, level and tag (which are those of the
+//  first of them)
+typedef struct tsl_rollup
+{
+    uint32_t    entryIndex;
+    uint32_t    count;
+    uint64_t    repeatCount;
+}
+tSL_Rollup;
+
+//  sl_pending cursor
+typedef struct tsl_pendingcursor
+{
+    sqlite3_vtab_cursor     base;
+    uint32_t                index;
+}
+tSL_PendingCursor;
+
 // =================================================================================================
 //  Private globals
 // =================================================================================================
 
 static sqlite3* gSQLiteDatabase = NULL;
+static sqlite3_stmt* gStatements[eSL_StatementCount];
 static sqlite3_stmt* gInsertStatement = NULL;
 static tSL_LogLevel gLogLevel = eSL_LogLevel_Info;
 static tSL_LogEntry gLogEntries[SL_LOG_ENTRY_CACHE_SIZE];
 static uint32_t gLogEntryCount = 0;
 static char gLogTimestamp[SL_TIMESTAMP_STRING_LENGTH] = {0};
+static uint32_t gBatchNumber = 0;
+static uint32_t gRateLimit = 0;
+static uint32_t gRateLimitBurst = 0;
+static tSL_RateLimitBucket gRateLimitBuckets[SL_RATE_LIMIT_TABLE_SIZE];
+static double gSamplingRates[eSL_LogLevel_None + 1] = {1.0, 1.0, 1.0, 1.0, 1.0, 1.0};
+static tSL_TagSamplingRate gTagSamplingRates[SL_MAX_SAMPLED_TAGS];
+static uint32_t gTagSamplingRateCount = 0;
+static uint64_t gRandomState = 0;
+static SL_THREAD_LOCAL tSL_Subscription* gDeliveringSubscription = NULL;    // Whose callback this thread is in
+static SL_THREAD_LOCAL bool gDeliveringUnsubscribed = false;                // Whether the callback unsubscribed
+static uint32_t gCompressionThreshold = 0;
+static uint8_t gCompressionBuffer[SL_COMPRESSION_BUFFER_SIZE];
+static bool gDictionaryCompression = false;
+static tSL_DictionaryTrainer gDictionaryTrainer;
+static tSL_CompressionDictionary gDictionary;
+static tSL_CompressionDictionary gTrainedDictionary;
+static uint32_t gDictionaryBatchCount = 0;
+static tSL_Subscription gSubscriptions[SL_MAX_SUBSCRIPTIONS];
+static uint32_t gSubscriptionCount = 0;
+static bool gImporting = false;
+static char gImportTimestamp[SL_TIMESTAMP_STRING_LENGTH];   // Of the last imported entry
+static uint64_t gMemoryBudget = 0;
+static bool gMemoryHeap = false;
+static uint8_t* gMemoryArena = NULL;
+static uint32_t gLookasideSlotCount = 0;
+static uint32_t gPageCacheSlotCount = 0;
+static uint64_t gMemoryLimit = 0;
+static bool gMemoryCounted = false;
+static tSL_Span gOpenSpans[SL_MAX_OPEN_SPANS];
+static uint32_t gOpenSpanCount = 0;
+static tSL_Span gEndedSpans[SL_SPAN_CACHE_SIZE];
+static uint32_t gEndedSpanCount = 0;
+static tSL_SpanId gLastSpanId = 0;
+static bool gSpansTableCreated = false;
+static uint32_t gMetricInterval = SL_DEFAULT_METRIC_INTERVAL;
+static time_t gMetricIntervalStart = 0;
+static tSL_Metric gMetrics[SL_MAX_METRICS];
+static uint32_t gMetricCount = 0;
+static tSL_Metric gEndedMetrics[SL_METRIC_CACHE_SIZE];
+static uint32_t gEndedMetricCount = 0;
+static bool gMetricsTableCreated = false;
+static bool gRollups = false;
+static tSL_Rollup gRollupCounts[SL_LOG_ENTRY_CACHE_SIZE];
+static uint32_t gRollupSlots[SL_ROLLUP_SLOT_COUNT];    // Index + 1 of a rollup, or 0 if empty
+static bool gAsyncWrites = false;
+static uint64_t gMemoryMapSize = 0;
+static uint32_t gChunkSize = 0;
+static uint32_t gCheckpointInterval = 0;
+static uint32_t gCheckpointPageThreshold = 0;
 
 // =================================================================================================
 //  Private prototypes
@@ -111,9 +416,107 @@ static char gLogTimestamp[SL_TIMESTAMP_STRING_LENGTH] = {0};
 
 static int32_t SL_GetTimestamp (char* timestamp);
 
-static int32_t SL_CreateTable (void);
+static void SL_FormatTimestamp (const struct timeval* time, char* timestamp);
+
+static uint64_t SL_GetMonotonicTime (void);
+
+static uint64_t SL_HashLogEntry (const char* message,
+                                 tSL_LogLevel level,
+                                 const char* fileName,
+                                 uint32_t lineNumber,
+                                 const char* tag);
+
+static double SL_GetSamplingRate (tSL_LogLevel level, const char* tag);
+
+static bool SL_SampleLogEntry (double rate);
+
+static bool SL_CollapseRepeat (const char* message,
+                               tSL_LogLevel level,
+                               const char* fileName,
+                               uint32_t lineNumber,
+                               const char* tag,
+                               tSL_RateLimitBucket** bucket);
+
+static void SL_NotifySubscribers (const tSL_LogEntry* entry, bool written);
+
+static void SL_FreeSubscription (tSL_Subscription* subscription);
+
+static const char* SL_GetLevelString (tSL_LogLevel level);
+
+static int32_t SL_ConfigureMemory (void);
+
+static void SL_ReleaseMemory (void);
+
+static int32_t SL_LimitMemory (void);
+
+static void SL_UnlimitMemory (void);
+
+static int32_t SL_GetStatement (tSL_StatementId id, sqlite3_stmt** statement);
 
-static int32_t SL_CreateView (const char* createViewCommand);
+static int32_t SL_StepStatement (tSL_StatementId id);
+
+static void SL_FinalizeStatements (void);
+
+static int32_t SL_CreateTable (const char* timestamp);
+
+static int32_t SL_CreateView (const char* createViewCommand, const char* timestamp);
+
+static int32_t SL_CreateViews (const char* timestamp);
+
+static int32_t SL_CreateLiveView (void);
+
+static int SL_PendingConnect (sqlite3* database,
+                              void* aux,
+                              int argc,
+                              const char* const* argv,
+                              sqlite3_vtab** vtab,
+                              char** errMsg);
+
+static int SL_PendingBestIndex (sqlite3_vtab* vtab, sqlite3_index_info* indexInfo);
+
+static int SL_PendingDisconnect (sqlite3_vtab* vtab);
+
+static int SL_PendingOpen (sqlite3_vtab* vtab, sqlite3_vtab_cursor** cursor);
+
+static int SL_PendingClose (sqlite3_vtab_cursor* cursor);
+
+static int SL_PendingFilter (sqlite3_vtab_cursor* cursor,
+                             int indexNumber,
+                             const char* indexString,
+                             int argc,
+                             sqlite3_value** argv);
+
+static int SL_PendingNext (sqlite3_vtab_cursor* cursor);
+
+static int SL_PendingEof (sqlite3_vtab_cursor* cursor);
+
+static int SL_PendingColumn (sqlite3_vtab_cursor* cursor, sqlite3_context* context, int column);
+
+static int SL_PendingRowid (sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid);
+
+static int32_t SL_WriteTransaction (void);
+
+static int32_t SL_WriteBatch (void);
+
+static int32_t SL_OpenSpansTable (void);
+
+static int32_t SL_WriteSpans (void);
+
+static uint64_t SL_GetSpanTime (void);
+
+static int32_t SL_EndMetricInterval (void);
+
+static int32_t SL_WriteMetrics (void);
+
+static void SL_GetRollupMinute (const char* timestamp, char* minute);
+
+static bool SL_MatchRollup (const tSL_LogEntry* entry, const tSL_LogEntry* other);
+
+static int32_t SL_WriteRollups (void);
+
+static int32_t SL_UpdateDictionary (void);
+
+static int32_t SL_BindColumnText (int index, const char* text, bool* dictionaryUsed);
 
 static int32_t SL_AddLogEntry (const char* message,
                                tSL_LogLevel level,
@@ -121,10 +524,45 @@ static int32_t SL_AddLogEntry (const char* message,
                                const char* functionName,
                                uint32_t lineNumber,
                                const char* tag,
-                               const char* supplementalData);
+                               const char* supplementalData,
+                               double sampleRate);
+
+static int32_t SL_AddImportedLogEntry (const tSL_ImportRecord* record);
 
 static int32_t SL_ProcessTransaction (void);
 
+// =================================================================================================
+//  Private modules
+// =================================================================================================
+
+//  sl_pending module (eponymous only, so there's no xCreate or xDestroy)
+static sqlite3_module gSL_PendingModule = {
+    0,                      // iVersion
+    NULL,                   // xCreate
+    SL_PendingConnect,      // xConnect
+    SL_PendingBestIndex,    // xBestIndex
+    SL_PendingDisconnect,   // xDisconnect
+    NULL,                   // xDestroy
+    SL_PendingOpen,         // xOpen
+    SL_PendingClose,        // xClose
+    SL_PendingFilter,       // xFilter
+    SL_PendingNext,         // xNext
+    SL_PendingEof,          // xEof
+    SL_PendingColumn,       // xColumn
+    SL_PendingRowid,        // xRowid
+    NULL,                   // xUpdate
+    NULL,                   // xBegin
+    NULL,                   // xSync
+    NULL,                   // xCommit
+    NULL,                   // xRollback
+    NULL,                   // xFindFunction
+    NULL,                   // xRename
+    NULL,                   // xSavepoint
+    NULL,                   // xRelease
+    NULL,                   // xRollbackTo
+    NULL,                   // xShadowName
+};
+
 // =================================================================================================
 //  SL_GetTimestamp
 // =================================================================================================
@@ -144,659 +582,2967 @@ int32_t SL_GetTimestamp (char* timestamp)
     // Check status
     if (result == SL_RESULT_SUCCESS)
     {
-        char tempStr[64] = {0};
         struct timeval now;
-        struct tm* nowTime;
 
         // Make a timestamp
         gettimeofday(&now, NULL);
-        nowTime = localtime(&now.tv_sec);
-        strftime(timestamp, SL_TIMESTAMP_STRING_LENGTH, 
-                "%Y-%m-%d %H:%M:%S", nowTime);
-        sprintf(tempStr, ".%06d ", now.tv_usec);
-        strcat(timestamp, tempStr);
-        strftime(tempStr, SL_TIMESTAMP_STRING_LENGTH, "%Z", nowTime);
-        strcat(timestamp, tempStr);
+        SL_FormatTimestamp(&now, timestamp);
     }
     return result;
 }
 
 // =================================================================================================
-//  SL_CreateTable
+//  SL_FormatTimestamp
 // =================================================================================================
-int32_t SL_CreateTable (void)
+void SL_FormatTimestamp (const struct timeval* time, char* timestamp)
 {
-    int32_t result = SL_RESULT_SUCCESS;
-    sqlite3_stmt* statement = NULL;
-    char cmdString[1024] = {0};
+    char tempStr[64] = {0};
+    struct tm* localTime = localtime(&(time->tv_sec));
+
+    strftime(timestamp, SL_TIMESTAMP_STRING_LENGTH,
+             "%Y-%m-%d %H:%M:%S", localTime);
+    sprintf(tempStr, ".%06d ", (int)time->tv_usec);
+    strcat(timestamp, tempStr);
+    strftime(tempStr, SL_TIMESTAMP_STRING_LENGTH, "%Z", localTime);
+    strcat(timestamp, tempStr);
+}
+
+// =================================================================================================
+//  SL_GetMonotonicTime
+// =================================================================================================
+uint64_t SL_GetMonotonicTime (void)
+{
+    struct timespec now;
 
-    // Make a timestamp
-    (void)SL_GetTimestamp(gLogTimestamp);
+    // Get monotonic time in microseconds
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * SL_MICROSECONDS_PER_SECOND) + ((uint64_t)now.tv_nsec / 1000);
+}
 
-    // Create the command
-    memset((void*)cmdString, 0, 1024);
-    sprintf(cmdString, kSL_CreateTableSQLCommandString, gLogTimestamp);
-    
-    // Prepare a statement
-    result = sqlite3_prepare_v2(gSQLiteDatabase,
-                                cmdString, (int)strlen(cmdString),
-                                &statement, NULL);
-    if (result == SQLITE_OK)
+// =================================================================================================
+//  SL_HashLogEntry
+// =================================================================================================
+uint64_t SL_HashLogEntry (const char* message,
+                          tSL_LogLevel level,
+                          const char* fileName,
+                          uint32_t lineNumber,
+                          const char* tag)
+{
+    uint64_t hash = 14695981039346656037ULL;    // FNV-1a offset basis
+    const char* strings[3] = {message, fileName, tag};
+    uint_fast32_t i = 0;
+
+    // Hash the strings (a NULL string hashes like an empty one)
+    for (i = 0; i < 3; i++)
     {
-        // Execute the statement
-        result = sqlite3_step(statement);
-        if (result == SQLITE_DONE)
-            result = SQLITE_OK; // Eat this result code
-        if (result != SQLITE_OK)
-            fprintf(SL_TERMINAL, 
-                    "At line %d in function %s, sqlite3_step failed with result %d.\n", 
-                    __LINE__, __FUNCTION__, result);
+        const char* c = strings[i];
 
-        // Clean up
-        (void)sqlite3_finalize(statement);
+        if (c != NULL)
+        {
+            while (*c != '\0')
+            {
+                hash ^= (uint8_t)*c++;
+                hash *= 1099511628211ULL;       // FNV-1a prime
+            }
+        }
+        hash ^= 0xFF;
+        hash *= 1099511628211ULL;
     }
-    else    // sqlite3_prepare_v2 failed
-        fprintf(SL_TERMINAL, 
-                "At line %d in function %s, sqlite3_prepare_v2 failed with result %d.\n", 
-                __LINE__, __FUNCTION__, result);
 
-    return result;
+    // Hash the level and line number
+    hash ^= ((uint64_t)level << 32) | lineNumber;
+    hash *= 1099511628211ULL;
+
+    return hash;
 }
 
 // =================================================================================================
-//  SL_CreateView
+//  SL_GetSamplingRate
 // =================================================================================================
-int32_t SL_CreateView (const char* createViewCommand)
+double SL_GetSamplingRate (tSL_LogLevel level, const char* tag)
 {
-    int32_t result = SL_RESULT_SUCCESS;
-    sqlite3_stmt* statement = NULL;
-    char cmdString[1024] = {0};
+    double rate = gSamplingRates[level];
+    uint_fast32_t i = 0;
 
-    // Create the command
-    memset((void*)cmdString, 0, 1024);
-    sprintf(cmdString, createViewCommand, gLogTimestamp, gLogTimestamp);
-    
-    // Prepare a statement
-    result = sqlite3_prepare_v2(gSQLiteDatabase,
-                                cmdString, (int)strlen(cmdString),
-                                &statement, NULL);
-    if (result == SQLITE_OK)
+    // A tag sampling rate overrides the level sampling rate
+    if (tag != NULL)
     {
-        // Execute the statement
-        result = sqlite3_step(statement);
-        if (result == SQLITE_DONE)
-            result = SQLITE_OK; // Eat this result code
-        if (result != SQLITE_OK)
-            fprintf(SL_TERMINAL, 
-                    "At line %d in function %s, sqlite3_step failed with result %d.\n", 
-                    __LINE__, __FUNCTION__, result);
-
-        // Clean up
-        (void)sqlite3_finalize(statement);
+        for (i = 0; i < gTagSamplingRateCount; i++)
+        {
+            if (strncmp(gTagSamplingRates[i].tag, tag, SL_TAG_STRING_LENGTH - 1) == 0)
+            {
+                rate = gTagSamplingRates[i].rate;
+                break;
+            }
+        }
     }
-    else    // sqlite3_prepare_v2 failed
-        fprintf(SL_TERMINAL, 
-                "At line %d in function %s, sqlite3_prepare_v2 failed with result %d.\n", 
-                __LINE__, __FUNCTION__, result);
+    return rate;
+}
 
-    return result;
+// =================================================================================================
+//  SL_SampleLogEntry
+// =================================================================================================
+bool SL_SampleLogEntry (double rate)
+{
+    bool keep = true;
+
+    if (rate < 1.0)
+    {
+        // Seed the generator on first use (xorshift64* must not be seeded with zero)
+        if (gRandomState == 0)
+            gRandomState = (SL_GetMonotonicTime() ^ (uint64_t)(uintptr_t)&gRandomState) | 1;
+
+        // Advance the generator
+        gRandomState ^= gRandomState >> 12;
+        gRandomState ^= gRandomState << 25;
+        gRandomState ^= gRandomState >> 27;
+
+        // Keep the entry if a uniform value in [0, 1) falls below the rate
+        keep = ((double)((gRandomState * 2685821657736338717ULL) >> 11) / 9007199254740992.0) < rate;
+    }
+    return keep;
 }
 
 // =================================================================================================
-//  SL_AddLogEntry
+//  SL_CollapseRepeat
 // =================================================================================================
-int32_t SL_AddLogEntry (const char* message,
+bool SL_CollapseRepeat (const char* message,
                         tSL_LogLevel level,
                         const char* fileName,
-                        const char* functionName,
                         uint32_t lineNumber,
                         const char* tag,
-                        const char* supplementalData)
+                        tSL_RateLimitBucket** bucket)
 {
-    int32_t result = SL_RESULT_SUCCESS;
-
-    // Timestamp
-    (void)SL_GetTimestamp(gLogEntries[gLogEntryCount].timestamp);
-
-    // Message
-    strncpy(gLogEntries[gLogEntryCount].message, message, 
-            (strlen(message) < (SL_MESSAGE_STRING_LENGTH - 1)) ? 
-                strlen(message) : SL_MESSAGE_STRING_LENGTH);
-
-    // Level
-    if (level == eSL_LogLevel_Diagnostic)
-        strncpy(gLogEntries[gLogEntryCount].level, kSL_DiagnosticLevelString, 
-                (strlen(kSL_DiagnosticLevelString) < (SL_LEVEL_STRING_LENGTH - 1)) ? 
-                    strlen(kSL_DiagnosticLevelString) : SL_LEVEL_STRING_LENGTH);
-    else if (level == eSL_LogLevel_Detail)
-        strncpy(gLogEntries[gLogEntryCount].level, kSL_DetailLevelString, 
-                (strlen(kSL_DetailLevelString) < (SL_LEVEL_STRING_LENGTH - 1)) ? 
-                    strlen(kSL_DetailLevelString) : SL_LEVEL_STRING_LENGTH);
-    else if (level == eSL_LogLevel_Info)
-        strncpy(gLogEntries[gLogEntryCount].level, kSL_InfoLevelString, 
-                (strlen(kSL_InfoLevelString) < (SL_LEVEL_STRING_LENGTH - 1)) ? 
-                    strlen(kSL_InfoLevelString) : SL_LEVEL_STRING_LENGTH);
-    else if (level == eSL_LogLevel_Warning)
-        strncpy(gLogEntries[gLogEntryCount].level, kSL_WarningLevelString, 
-                (strlen(kSL_WarningLevelString) < (SL_LEVEL_STRING_LENGTH - 1)) ? 
-                    strlen(kSL_WarningLevelString) : SL_LEVEL_STRING_LENGTH);
-    else if (level == eSL_LogLevel_Error)
-        strncpy(gLogEntries[gLogEntryCount].level, kSL_ErrorLevelString, 
-                (strlen(kSL_ErrorLevelString) < (SL_LEVEL_STRING_LENGTH - 1)) ? 
-                    strlen(kSL_ErrorLevelString) : SL_LEVEL_STRING_LENGTH);
-    else
-        strncpy(gLogEntries[gLogEntryCount].level, kSL_NoneLevelString, 
-                (strlen(kSL_NoneLevelString) < (SL_LEVEL_STRING_LENGTH - 1)) ? 
-                    strlen(kSL_NoneLevelString) : SL_LEVEL_STRING_LENGTH);
+    bool collapsed = false;
+    uint64_t hash = SL_HashLogEntry(message, level, fileName, lineNumber, tag);
+    uint64_t now = SL_GetMonotonicTime();
+    tSL_RateLimitBucket* set = &(gRateLimitBuckets[(hash % (SL_RATE_LIMIT_TABLE_SIZE / SL_RATE_LIMIT_SET_SIZE)) *
+                                                   SL_RATE_LIMIT_SET_SIZE]);
+    tSL_RateLimitBucket* b = NULL;
+    uint_fast32_t i = 0;
 
-    // File name
-    if (fileName != NULL)
-        strncpy(gLogEntries[gLogEntryCount].fileName, fileName, 
-                (strlen(fileName) < (SL_FILE_NAME_STRING_LENGTH - 1)) ? 
-                    strlen(fileName) : SL_FILE_NAME_STRING_LENGTH);
+    // Find the message's bucket in its set
+    for (i = 0; (i < SL_RATE_LIMIT_SET_SIZE) && (b == NULL); i++)
+    {
+        if (set[i].inUse && (set[i].hash == hash))
+            b = &(set[i]);
+    }
 
-    // Function name
-    if (functionName != NULL)
-        strncpy(gLogEntries[gLogEntryCount].functionName, functionName, 
-                (strlen(functionName) < (SL_FUNCTION_NAME_STRING_LENGTH - 1)) ? 
-                    strlen(functionName) : SL_FUNCTION_NAME_STRING_LENGTH);
+    // Otherwise, claim an empty bucket of the set, or the one used least recently
+    if (b == NULL)
+    {
+        b = &(set[0]);
+        for (i = 1; (i < SL_RATE_LIMIT_SET_SIZE) && b->inUse; i++)
+        {
+            if ((!set[i].inUse) || (set[i].lastRefillTime < b->lastRefillTime))
+                b = &(set[i]);
+        }
+        b->hash = hash;
+        b->tokens = (double)gRateLimitBurst;
+        b->lastRefillTime = now;
+        b->entryIndex = 0;
+        b->batchNumber = gBatchNumber - 1;  // No pending entry yet
+        b->inUse = true;
+    }
 
-    // Line number
-    gLogEntries[gLogEntryCount].lineNumber = lineNumber;
+    // Refill the bucket
+    b->tokens += ((double)(now - b->lastRefillTime) * gRateLimit) / SL_MICROSECONDS_PER_SECOND;
+    if (b->tokens > (double)gRateLimitBurst)
+        b->tokens = (double)gRateLimitBurst;
+    b->lastRefillTime = now;
 
-    // Tag
-    if (tag != NULL)
-        strncpy(gLogEntries[gLogEntryCount].tag, tag, 
-                (strlen(tag) < (SL_TAG_STRING_LENGTH - 1)) ? 
-                    strlen(tag) : SL_TAG_STRING_LENGTH);
+    // Spend a token if there's one available
+    if (b->tokens >= 1.0)
+        b->tokens -= 1.0;
 
-    // Supplemental data
-    if (supplementalData != NULL)
-        strncpy(gLogEntries[gLogEntryCount].supplementalData, supplementalData, 
-                (strlen(supplementalData) < (SL_SUPPLEMENTAL_DATA_STRING_LENGTH - 1)) ? 
-                    strlen(supplementalData) : SL_SUPPLEMENTAL_DATA_STRING_LENGTH);
+    // Otherwise, fold this message into its pending entry (if it hasn't been committed yet)
+    else if ((b->batchNumber == gBatchNumber) && (b->entryIndex < gLogEntryCount))
+    {
+        tSL_LogEntry* entry = &(gLogEntries[b->entryIndex]);
 
-    // Bump entry count
-    gLogEntryCount++;
+        entry->repeatCount++;
+        (void)SL_GetTimestamp(entry->lastTimestamp);
+        collapsed = true;
+    }
 
-    return result;
+    *bucket = b;
+    return collapsed;
 }
 
 // =================================================================================================
-//  SL_ProcessTransaction
+//  SL_NotifySubscribers
 // =================================================================================================
-int32_t SL_ProcessTransaction (void)
+void SL_NotifySubscribers (const tSL_LogEntry* entry, bool written)
 {
-    int32_t result = SL_RESULT_SUCCESS;
-    char* errMsg = NULL;
+    tSL_LogRecord record;
+    bool recordReady = false;
     uint_fast32_t i = 0;
 
-    // Start the transaction
-    result = sqlite3_exec(gSQLiteDatabase, "BEGIN TRANSACTION;", 
-                          NULL, NULL, &errMsg);
-    if (result == SQLITE_OK)
+    for (i = 0; i < SL_MAX_SUBSCRIPTIONS; i++)
     {
-        for (i = 0; i < gLogEntryCount; i++)
+        tSL_Subscription* subscription = &(gSubscriptions[i]);
+        uint32_t status = __atomic_load_n(&(subscription->status), __ATOMIC_ACQUIRE);
+
+        // Slots without an active subscription are skipped with a plain load; for the others,
+        // register as a reader, then check that the slot still has the same subscription, so
+        // SL_Unsubscribe either sees us and waits, or we see it unsubscribed (each side stores,
+        // then loads what the other stores, which only sequentially consistent operations order)
+        if ((status & SL_SUBSCRIPTION_STATE_MASK) == SL_SUBSCRIPTION_ACTIVE)
         {
-            // Timestamp
-            result = sqlite3_bind_text(gInsertStatement, 1, 
-                                        gLogEntries[i].timestamp, 
-                                        strlen(gLogEntries[i].timestamp), 
-                                        SQLITE_STATIC);     
-            if (result != SQLITE_OK)
-                fprintf(SL_TERMINAL, 
-                        "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
-                        __LINE__, __FUNCTION__, result);
-
-            // Message
-            if (result == SQLITE_OK)
+            __atomic_add_fetch(&(subscription->readers), 1, __ATOMIC_SEQ_CST);
+            if ((__atomic_load_n(&(subscription->status), __ATOMIC_SEQ_CST) == status) &&
+                (subscription->onWrite == written) &&
+                (entry->logLevel >= subscription->level) &&
+                (!subscription->hasTag || (strcmp(entry->tag, subscription->tag) == 0)))
             {
-                result = sqlite3_bind_text(gInsertStatement, 2,
-                                            gLogEntries[i].message,
-                                            strlen(gLogEntries[i].message),
-                                            SQLITE_STATIC);
-                if (result != SQLITE_OK)
-                    fprintf(SL_TERMINAL, 
-                            "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
-                            __LINE__, __FUNCTION__, result);
+                if (!recordReady)
+                {
+                    record.timestamp = entry->timestamp;
+                    record.message = entry->message;
+                    record.level = entry->logLevel;
+                    record.fileName = entry->fileName;
+                    record.functionName = entry->functionName;
+                    record.lineNumber = entry->lineNumber;
+                    record.tag = entry->tag;
+                    record.supplementalData = entry->supplementalData;
+                    record.repeatCount = entry->repeatCount;
+                    recordReady = true;
+                }
+                gDeliveringSubscription = subscription;
+                subscription->callback(&record, subscription->context);
+                gDeliveringSubscription = NULL;
             }
+            __atomic_sub_fetch(&(subscription->readers), 1, __ATOMIC_RELEASE);
 
-            // Log level
-            if (result == SQLITE_OK)
+            // A callback that unsubscribed itself left freeing its slot until it returned
+            if (gDeliveringUnsubscribed)
             {
-                result = sqlite3_bind_text(gInsertStatement, 3,
-                                            gLogEntries[i].level,
-                                            strlen(gLogEntries[i].level),
-                                            SQLITE_STATIC);
-                if (result != SQLITE_OK)
-                    fprintf(SL_TERMINAL, 
-                            "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
-                            __LINE__, __FUNCTION__, result);
+                gDeliveringUnsubscribed = false;
+                SL_FreeSubscription(subscription);
             }
+        }
+    }
+}
 
-            // File name
-            if (result == SQLITE_OK)
-            {
-                if (gLogEntries[i].fileName == NULL)
-                {
-                    result = sqlite3_bind_null(gInsertStatement, 4);
+// =================================================================================================
+//  SL_FreeSubscription
+// =================================================================================================
+void SL_FreeSubscription (tSL_Subscription* subscription)
+{
+    uint32_t status = __atomic_load_n(&(subscription->status), __ATOMIC_RELAXED);
+
+    // Wait for deliveries in progress (on other threads) to finish, then free the slot, keeping
+    // its generation
+    while (__atomic_load_n(&(subscription->readers), __ATOMIC_SEQ_CST) != 0)
+        sched_yield();
+    __atomic_store_n(&(subscription->status), status & ~SL_SUBSCRIPTION_STATE_MASK, __ATOMIC_RELEASE);
+}
+
+// =================================================================================================
+//  SL_GetLevelString
+// =================================================================================================
+const char* SL_GetLevelString (tSL_LogLevel level)
+{
+    const char* levelString = kSL_NoneLevelString;
+
+    if (level == eSL_LogLevel_Diagnostic)
+        levelString = kSL_DiagnosticLevelString;
+    else if (level == eSL_LogLevel_Detail)
+        levelString = kSL_DetailLevelString;
+    else if (level == eSL_LogLevel_Info)
+        levelString = kSL_InfoLevelString;
+    else if (level == eSL_LogLevel_Warning)
+        levelString = kSL_WarningLevelString;
+    else if (level == eSL_LogLevel_Error)
+        levelString = kSL_ErrorLevelString;
+
+    return levelString;
+}
+
+// =================================================================================================
+//  SL_ConfigureMemory
+// =================================================================================================
+int32_t SL_ConfigureMemory (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    int headerSize = 0;
+    uint64_t slotSize = 0;
+    uint64_t lookasideSize = 0;
+    uint64_t pageCacheSize = 0;
+
+    // SQLite can only be configured before it's initialized, and it isn't shut down for it,
+    // since that's only safe with no other connection open, so if anything in the process has
+    // used SQLite already (and not shut it down), this fails with SQLITE_MISUSE
+    gMemoryArena = (uint8_t*)malloc((size_t)gMemoryBudget);
+    if (gMemoryArena == NULL)
+    {
+        result = ENOMEM;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, malloc failed to allocate %llu bytes.\n",
+                __LINE__, __FUNCTION__, (unsigned long long)gMemoryBudget);
+    }
+    else
+    {
+        // The arena starts with the lookaside slots, then the page cache slots (each a page and
+        // SQLite's header for it), then the heap (if there is one) that SQLite's other
+        // allocations come from
+        result = sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &headerSize);
+        slotSize = (SL_PAGE_SIZE + (uint64_t)headerSize + 7) & ~(uint64_t)7;
+        gLookasideSlotCount = (uint32_t)((gMemoryBudget / 16) / SL_LOOKASIDE_SLOT_SIZE);
+        lookasideSize = (uint64_t)gLookasideSlotCount * SL_LOOKASIDE_SLOT_SIZE;
+        if (gMemoryHeap)
+            pageCacheSize = gMemoryBudget / 2;
+        else
+            pageCacheSize = gMemoryBudget - lookasideSize;
+        gPageCacheSlotCount = (uint32_t)(pageCacheSize / slotSize);
+        pageCacheSize = (uint64_t)gPageCacheSlotCount * slotSize;
+
+        if (result == SQLITE_OK)
+            result = sqlite3_config(SQLITE_CONFIG_PAGECACHE, (void*)(gMemoryArena + lookasideSize),
+                                    (int)slotSize, (int)gPageCacheSlotCount);
+        if ((result == SQLITE_OK) && gMemoryHeap)
+            result = sqlite3_config(SQLITE_CONFIG_HEAP, (void*)(gMemoryArena + lookasideSize + pageCacheSize),
+                                    (int)(gMemoryBudget - lookasideSize - pageCacheSize),
+                                    SL_HEAP_MINIMUM_ALLOCATION);
+        if (result != SQLITE_OK)
+        {
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, sqlite3_config failed with result %d (preallocated memory has to be set before SQLite is used).\n",
+                    __LINE__, __FUNCTION__, result);
+            SL_ReleaseMemory();
+        }
+    }
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_ReleaseMemory
+// =================================================================================================
+void SL_ReleaseMemory (void)
+{
+    // Called with SQLite shut down (or before it was initialized with the arena), so that the
+    // next initialization goes back to the default allocators
+    (void)sqlite3_config(SQLITE_CONFIG_PAGECACHE, NULL, 0, 0);
+    if (gMemoryHeap)
+        (void)sqlite3_config(SQLITE_CONFIG_HEAP, NULL, 0, 0);
+    free((void*)gMemoryArena);
+    gMemoryArena = NULL;
+    gLookasideSlotCount = 0;
+    gPageCacheSlotCount = 0;
+}
+
+// =================================================================================================
+//  SL_LimitMemory
+// =================================================================================================
+int32_t SL_LimitMemory (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint64_t bufferSize = 0;
+    uint64_t heapLimit = 0;
+
+    // The buffers that log entries are collected and compressed in are allocated statically, and
+    // the preallocated arena is allocated by SL_Initialize, so they count against the limit as a
+    // whole, and SQLite's heap gets the rest
+    bufferSize = sizeof(gLogEntries) + sizeof(gRateLimitBuckets) + sizeof(gCompressionBuffer) +
+        (gDictionaryCompression ?
+            (sizeof(gDictionaryTrainer) + sizeof(gDictionary) + sizeof(gTrainedDictionary)) : 0) +
+        (gRollups ? (sizeof(gRollupCounts) + sizeof(gRollupSlots)) : 0);
+
+    // With io_uring writes, the log file and its WAL each get a ring with its own copies of the
+    // writes in flight, and so do those of the checkpointer's connection (whose SQLite memory
+    // comes out of the heap limit, which applies to the whole process)
+    if (gAsyncWrites)
+        bufferSize += SL_GetAppendAsyncWriteMemory() *
+            (((gCheckpointInterval > 0) || (gCheckpointPageThreshold > 0)) ? 4 : 2);
+    if (gMemoryLimit < (bufferSize + gMemoryBudget + SL_MINIMUM_MEMORY_LIMIT))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, a memory limit of %llu bytes leaves less than %u bytes for SQLite.\n",
+                __LINE__, __FUNCTION__, (unsigned long long)gMemoryLimit, SL_MINIMUM_MEMORY_LIMIT);
+    }
+    else
+    {
+        // With a preallocated heap, all of SQLite's memory is already in the arena; otherwise, the
+        // heap limits are enforced on the allocations that SQLite counts, so counting has to be
+        // turned on in builds that turn it off (tuned builds), which SQLite only allows before
+        // it's initialized; SQLite isn't shut down for it, since that's only safe with no other
+        // connection open, so if anything in the process has used SQLite already, this fails
+        // with SQLITE_MISUSE (counting stays on once it's turned on, so that's only the first time)
+        heapLimit = gMemoryLimit - bufferSize - gMemoryBudget;
+        if (!gMemoryHeap && !gMemoryCounted && sqlite3_compileoption_used("DEFAULT_MEMSTATUS=0"))
+        {
+            result = sqlite3_config(SQLITE_CONFIG_MEMSTATUS, 1);
+            if (result != SQLITE_OK)
+                fprintf(SL_TERMINAL,
+                        "At line %d in function %s, sqlite3_config failed with result %d (a memory limit has to be set before SQLite is used).\n",
+                        __LINE__, __FUNCTION__, result);
+            else
+                gMemoryCounted = true;
+        }
+        if ((result == SQLITE_OK) && !gMemoryHeap)
+        {
+            // Past the soft limit, SQLite reuses its cached pages rather than allocating more, and
+            // an allocation past the hard limit fails with SQLITE_NOMEM
+            (void)sqlite3_hard_heap_limit64((sqlite3_int64)heapLimit);
+            (void)sqlite3_soft_heap_limit64((sqlite3_int64)((heapLimit / 4) * 3));
+        }
+    }
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_UnlimitMemory
+// =================================================================================================
+void SL_UnlimitMemory (void)
+{
+    // The heap limits apply to the whole process
+    (void)sqlite3_soft_heap_limit64(0);
+    (void)sqlite3_hard_heap_limit64(0);
+}
+
+// =================================================================================================
+//  SL_GetStatement
+// =================================================================================================
+int32_t SL_GetStatement (tSL_StatementId id, sqlite3_stmt** statement)
+{
+    int32_t result = SQLITE_OK;
+
+    // Statements are prepared the first time they're used, and kept until the database is closed
+    // (SQLite prepares them again by itself if the schema changes under them)
+    if (gStatements[id] == NULL)
+    {
+        char* cmdString = NULL;
+
+        switch (id)
+        {
+            case eSL_Statement_BeginTransaction:
+                cmdString = sqlite3_mprintf("%s", kSL_BeginTransactionSQLCommandString);
+                break;
+            case eSL_Statement_EndTransaction:
+                cmdString = sqlite3_mprintf("%s", kSL_EndTransactionSQLCommandString);
+                break;
+            case eSL_Statement_RollbackTransaction:
+                cmdString = sqlite3_mprintf("%s", kSL_RollbackTransactionSQLCommandString);
+                break;
+            case eSL_Statement_Insert:
+                cmdString = sqlite3_mprintf(kSL_ParameterizedInsertSQLCommandString, gLogTimestamp);
+                break;
+            case eSL_Statement_InsertDictionary:
+                cmdString = sqlite3_mprintf("%s", kSL_InsertDictionarySQLCommandString);
+                break;
+            case eSL_Statement_SelectClosedLogTable:
+                cmdString = sqlite3_mprintf("%s", kSL_SelectClosedLogTableSQLCommandString);
+                break;
+            case eSL_Statement_CreateSpansTable:
+                cmdString = sqlite3_mprintf("%s", kSL_CreateSpansTableSQLCommandString);
+                break;
+            case eSL_Statement_SelectLastSpanId:
+                cmdString = sqlite3_mprintf("%s", kSL_SelectLastSpanIdSQLCommandString);
+                break;
+            case eSL_Statement_InsertSpan:
+                cmdString = sqlite3_mprintf("%s", kSL_InsertSpanSQLCommandString);
+                break;
+            case eSL_Statement_CreateMetricsTable:
+                cmdString = sqlite3_mprintf("%s", kSL_CreateMetricsTableSQLCommandString);
+                break;
+            case eSL_Statement_InsertMetric:
+                cmdString = sqlite3_mprintf("%s", kSL_InsertMetricSQLCommandString);
+                break;
+            case eSL_Statement_UpsertRollup:
+                cmdString = sqlite3_mprintf("%s", kSL_UpsertRollupSQLCommandString);
+                break;
+            default:
+                break;
+        }
+
+        // Persistent statements are kept out of the lookaside, which is for short-lived allocations
+        result = (cmdString == NULL) ? SQLITE_NOMEM :
+            sqlite3_prepare_v3(gSQLiteDatabase, cmdString, -1, SQLITE_PREPARE_PERSISTENT,
+                               &(gStatements[id]), NULL);
+        if (result != SQLITE_OK)
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, sqlite3_prepare_v3 failed with result %d.\n",
+                    __LINE__, __FUNCTION__, result);
+        sqlite3_free((void*)cmdString);
+    }
+    *statement = gStatements[id];
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_StepStatement
+// =================================================================================================
+int32_t SL_StepStatement (tSL_StatementId id)
+{
+    sqlite3_stmt* statement = NULL;
+    int32_t result = SL_GetStatement(id, &statement);
+
+    if (result == SQLITE_OK)
+    {
+        result = sqlite3_step(statement);
+        if (result == SQLITE_DONE)
+            result = SQLITE_OK; // Eat this result code
+        (void)sqlite3_reset(statement);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_FinalizeStatements
+// =================================================================================================
+void SL_FinalizeStatements (void)
+{
+    uint_fast32_t i = 0;
+
+    for (i = 0; i < eSL_StatementCount; i++)
+    {
+        if (gStatements[i] != NULL)
+        {
+            (void)sqlite3_finalize(gStatements[i]);
+            gStatements[i] = NULL;
+        }
+    }
+    gInsertStatement = NULL;
+}
+
+// =================================================================================================
+//  SL_CreateTable
+// =================================================================================================
+int32_t SL_CreateTable (const char* timestamp)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char* cmdString = NULL;
+
+    // Create and execute the command (DDL runs once per table, so it isn't cached)
+    cmdString = sqlite3_mprintf(kSL_CreateTableSQLCommandString, timestamp);
+    result = (cmdString == NULL) ? SQLITE_NOMEM : sqlite3_exec(gSQLiteDatabase, cmdString, NULL, NULL, NULL);
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, sqlite3_exec failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+    sqlite3_free((void*)cmdString);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_CreateView
+// =================================================================================================
+int32_t SL_CreateView (const char* createViewCommand, const char* timestamp)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char* cmdString = NULL;
+
+    // Create and execute the command
+    cmdString = sqlite3_mprintf(createViewCommand, timestamp,
+                                ((gCompressionThreshold > 0) || gDictionaryCompression) ?
+                                    kSL_CompressedViewColumnsString : kSL_ViewColumnsString,
+                                timestamp);
+    result = (cmdString == NULL) ? SQLITE_NOMEM : sqlite3_exec(gSQLiteDatabase, cmdString, NULL, NULL, NULL);
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, sqlite3_exec failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+    sqlite3_free((void*)cmdString);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_CreateViews
+// =================================================================================================
+int32_t SL_CreateViews (const char* timestamp)
+{
+    int32_t result = SL_CreateView(kSL_CreateDiagnosticMessageViewCommandString, timestamp);
+    if (result == SL_RESULT_SUCCESS)
+    {
+        result = SL_CreateView(kSL_CreateDetailMessageViewCommandString, timestamp);
+        if (result == SL_RESULT_SUCCESS)
+        {
+            result = SL_CreateView(kSL_CreateInfoMessageViewCommandString, timestamp);
+            if (result == SL_RESULT_SUCCESS)
+            {
+                result = SL_CreateView(kSL_CreateWarningMessageViewCommandString, timestamp);
+                if (result == SL_RESULT_SUCCESS)
+                    result = SL_CreateView(kSL_CreateErrorMessageViewCommandString, timestamp);
+            }
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_CreateLiveView
+// =================================================================================================
+int32_t SL_CreateLiveView (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    const char* columns = ((gCompressionThreshold > 0) || gDictionaryCompression) ?
+        kSL_CompressedViewColumnsString : kSL_ViewColumnsString;
+    char* cmdString = NULL;
+
+    // Create and execute the command
+    cmdString = sqlite3_mprintf(kSL_CreateLiveViewCommandString, gLogTimestamp, columns, gLogTimestamp, columns);
+    result = (cmdString == NULL) ? SQLITE_NOMEM : sqlite3_exec(gSQLiteDatabase, cmdString, NULL, NULL, NULL);
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, sqlite3_exec failed with result %d.\n", 
+                __LINE__, __FUNCTION__, result);
+    sqlite3_free((void*)cmdString);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_PendingConnect
+// =================================================================================================
+int SL_PendingConnect (sqlite3* database,
+                       void* aux,
+                       int argc,
+                       const char* const* argv,
+                       sqlite3_vtab** vtab,
+                       char** errMsg)
+{
+    int result = sqlite3_declare_vtab(database, kSL_PendingSchemaString);
+
+    (void)aux;
+    (void)argc;
+    (void)argv;
+    (void)errMsg;
+    if (result == SQLITE_OK)
+    {
+        *vtab = (sqlite3_vtab*)sqlite3_malloc(sizeof(sqlite3_vtab));
+        if (*vtab == NULL)
+            result = SQLITE_NOMEM;
+        else
+        {
+            memset((void*)*vtab, 0, sizeof(sqlite3_vtab));
+
+            // The table is read only, so it's safe to use from views
+            (void)sqlite3_vtab_config(database, SQLITE_VTAB_INNOCUOUS);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_PendingBestIndex
+// =================================================================================================
+int SL_PendingBestIndex (sqlite3_vtab* vtab, sqlite3_index_info* indexInfo)
+{
+    (void)vtab;
+
+    // Always a full scan of the (small) in-memory buffer
+    indexInfo->estimatedCost = (double)SL_LOG_ENTRY_CACHE_SIZE;
+    indexInfo->estimatedRows = SL_LOG_ENTRY_CACHE_SIZE;
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_PendingDisconnect
+// =================================================================================================
+int SL_PendingDisconnect (sqlite3_vtab* vtab)
+{
+    sqlite3_free((void*)vtab);
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_PendingOpen
+// =================================================================================================
+int SL_PendingOpen (sqlite3_vtab* vtab, sqlite3_vtab_cursor** cursor)
+{
+    int result = SQLITE_OK;
+    tSL_PendingCursor* pendingCursor = (tSL_PendingCursor*)sqlite3_malloc(sizeof(tSL_PendingCursor));
+
+    (void)vtab;
+    if (pendingCursor == NULL)
+        result = SQLITE_NOMEM;
+    else
+    {
+        memset((void*)pendingCursor, 0, sizeof(tSL_PendingCursor));
+        *cursor = &(pendingCursor->base);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_PendingClose
+// =================================================================================================
+int SL_PendingClose (sqlite3_vtab_cursor* cursor)
+{
+    sqlite3_free((void*)cursor);
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_PendingFilter
+// =================================================================================================
+int SL_PendingFilter (sqlite3_vtab_cursor* cursor,
+                      int indexNumber,
+                      const char* indexString,
+                      int argc,
+                      sqlite3_value** argv)
+{
+    (void)indexNumber;
+    (void)indexString;
+    (void)argc;
+    (void)argv;
+    ((tSL_PendingCursor*)cursor)->index = 0;
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_PendingNext
+// =================================================================================================
+int SL_PendingNext (sqlite3_vtab_cursor* cursor)
+{
+    ((tSL_PendingCursor*)cursor)->index++;
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_PendingEof
+// =================================================================================================
+int SL_PendingEof (sqlite3_vtab_cursor* cursor)
+{
+    // The buffer is read as it is now, so a flush during the scan ends it
+    return (((tSL_PendingCursor*)cursor)->index >= gLogEntryCount) ? 1 : 0;
+}
+
+// =================================================================================================
+//  SL_PendingColumn
+// =================================================================================================
+int SL_PendingColumn (sqlite3_vtab_cursor* cursor, sqlite3_context* context, int column)
+{
+    const tSL_LogEntry* entry = &(gLogEntries[((tSL_PendingCursor*)cursor)->index]);
+
+    // Same values as SL_ProcessTransaction writes (pending entries have no id yet)
+    switch (column)
+    {
+        case 1:
+            sqlite3_result_text(context, entry->timestamp,
+                                (int)strnlen(entry->timestamp, sizeof(entry->timestamp)), SQLITE_TRANSIENT);
+            break;
+        case 2:
+            sqlite3_result_text(context, entry->message,
+                                (int)strnlen(entry->message, sizeof(entry->message)), SQLITE_TRANSIENT);
+            break;
+        case 3:
+            sqlite3_result_text(context, entry->level,
+                                (int)strnlen(entry->level, sizeof(entry->level)), SQLITE_TRANSIENT);
+            break;
+        case 4:
+            sqlite3_result_text(context, entry->fileName,
+                                (int)strnlen(entry->fileName, sizeof(entry->fileName)), SQLITE_TRANSIENT);
+            break;
+        case 5:
+            sqlite3_result_text(context, entry->functionName,
+                                (int)strnlen(entry->functionName, sizeof(entry->functionName)), SQLITE_TRANSIENT);
+            break;
+        case 6:
+            sqlite3_result_int(context, (int)entry->lineNumber);
+            break;
+        case 7:
+            sqlite3_result_text(context, entry->tag,
+                                (int)strnlen(entry->tag, sizeof(entry->tag)), SQLITE_TRANSIENT);
+            break;
+        case 8:
+            sqlite3_result_text(context, entry->supplementalData,
+                                (int)strnlen(entry->supplementalData, sizeof(entry->supplementalData)), SQLITE_TRANSIENT);
+            break;
+        case 9:
+            sqlite3_result_int(context, (int)entry->repeatCount);
+            break;
+        case 10:
+            if (entry->repeatCount > 1)
+                sqlite3_result_text(context, entry->lastTimestamp,
+                                    (int)strnlen(entry->lastTimestamp, sizeof(entry->lastTimestamp)), SQLITE_TRANSIENT);
+            else
+                sqlite3_result_null(context);
+            break;
+        case 11:
+            sqlite3_result_double(context, entry->sampleRate);
+            break;
+        default:    // log_id and log_dictionary_id
+            sqlite3_result_null(context);
+            break;
+    }
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_PendingRowid
+// =================================================================================================
+int SL_PendingRowid (sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid)
+{
+    *rowid = ((tSL_PendingCursor*)cursor)->index;
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_WriteBatch
+// =================================================================================================
+int32_t SL_WriteBatch (void)
+{
+    int32_t result = SL_ProcessTransaction();
+
+    if (result == SL_RESULT_SUCCESS)
+    {
+        gLogEntryCount = 0;
+        gBatchNumber++;
+
+        // Initialize log entry list
+        memset((void*)gLogEntries, 0, sizeof(tSL_LogEntry) * SL_LOG_ENTRY_CACHE_SIZE);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_OpenSpansTable
+// =================================================================================================
+int32_t SL_OpenSpansTable (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    sqlite3_stmt* statement = NULL;
+
+    // The spans table is only created once spans are used, and span ids carry on from the last
+    // one in the log file, so they're unique across sessions (the select is prepared after the
+    // table exists)
+    result = SL_StepStatement(eSL_Statement_CreateSpansTable);
+    if (result == SQLITE_OK)
+        result = SL_GetStatement(eSL_Statement_SelectLastSpanId, &statement);
+    if (result == SQLITE_OK)
+    {
+        result = sqlite3_step(statement);
+        if (result == SQLITE_ROW)
+        {
+            gLastSpanId = (tSL_SpanId)sqlite3_column_int64(statement, 0);
+            gSpansTableCreated = true;
+            result = SQLITE_OK;
+        }
+        (void)sqlite3_reset(statement);
+    }
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, opening the spans table failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_WriteSpans
+// =================================================================================================
+int32_t SL_WriteSpans (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    sqlite3_stmt* statement = NULL;
+    uint_fast32_t i = 0;
+
+    result = SL_GetStatement(eSL_Statement_InsertSpan, &statement);
+    for (i = 0; (i < gEndedSpanCount) && (result == SQLITE_OK); i++)
+    {
+        const tSL_Span* span = &(gEndedSpans[i]);
+
+        result = sqlite3_bind_int64(statement, 1, (sqlite3_int64)span->id);
+        if (result == SQLITE_OK)
+        {
+            if (span->parentId == SL_NO_PARENT_SPAN)
+                result = sqlite3_bind_null(statement, 2);
+            else
+                result = sqlite3_bind_int64(statement, 2, (sqlite3_int64)span->parentId);
+        }
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_text(statement, 3, span->name, -1, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+        {
+            if (span->tag[0] == '\0')
+                result = sqlite3_bind_null(statement, 4);
+            else
+                result = sqlite3_bind_text(statement, 4, span->tag, -1, SQLITE_STATIC);
+        }
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_text(statement, 5, span->timestamp, -1, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int64(statement, 6, (sqlite3_int64)span->start);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int64(statement, 7, (sqlite3_int64)span->end);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int64(statement, 8, (sqlite3_int64)(span->end - span->start));
+        if (result == SQLITE_OK)
+        {
+            result = sqlite3_step(statement);
+            if (result == SQLITE_DONE)
+                result = SQLITE_OK; // Eat this result code
+        }
+        (void)sqlite3_reset(statement);
+    }
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, writing spans failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_GetSpanTime
+// =================================================================================================
+uint64_t SL_GetSpanTime (void)
+{
+    struct timespec now;
+
+    // Get monotonic time in nanoseconds
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * SL_NANOSECONDS_PER_SECOND) + (uint64_t)now.tv_nsec;
+}
+
+// =================================================================================================
+//  SL_EndMetricInterval
+// =================================================================================================
+int32_t SL_EndMetricInterval (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Make room for the interval's metrics, by writing those of earlier intervals (with the log
+    // entries so far)
+    if ((gEndedMetricCount + gMetricCount) > SL_METRIC_CACHE_SIZE)
+        result = SL_WriteBatch();
+    if (result == SL_RESULT_SUCCESS)
+    {
+        memcpy((void*)&(gEndedMetrics[gEndedMetricCount]), (const void*)gMetrics,
+               sizeof(tSL_Metric) * gMetricCount);
+        gEndedMetricCount += gMetricCount;
+        gMetricCount = 0;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_WriteMetrics
+// =================================================================================================
+int32_t SL_WriteMetrics (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    sqlite3_stmt* statement = NULL;
+    char histogram[SL_HISTOGRAM_STRING_LENGTH] = {0};
+    uint_fast32_t i = 0;
+    uint_fast32_t j = 0;
+
+    result = SL_GetStatement(eSL_Statement_InsertMetric, &statement);
+    for (i = 0; (i < gEndedMetricCount) && (result == SQLITE_OK); i++)
+    {
+        const tSL_Metric* metric = &(gEndedMetrics[i]);
+        size_t length = 0;
+
+        // The histogram is a JSON array of the bucket counts
+        histogram[length++] = '[';
+        for (j = 0; j < SL_METRIC_BUCKET_COUNT; j++)
+            length += (size_t)snprintf(histogram + length, sizeof(histogram) - length, "%s%llu",
+                                       (j == 0) ? "" : ",", (unsigned long long)metric->buckets[j]);
+        histogram[length++] = ']';
+        histogram[length] = '\0';
+
+        result = sqlite3_bind_text(statement, 1, metric->name, -1, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_text(statement, 2, metric->timestamp, -1, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int(statement, 3, (int)gMetricInterval);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int64(statement, 4, (sqlite3_int64)metric->count);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_double(statement, 5, metric->sum);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_double(statement, 6, metric->min);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_double(statement, 7, metric->max);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_double(statement, 8, metric->last);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_text(statement, 9, histogram, (int)length, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+        {
+            result = sqlite3_step(statement);
+            if (result == SQLITE_DONE)
+                result = SQLITE_OK; // Eat this result code
+        }
+        (void)sqlite3_reset(statement);
+    }
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, writing metrics failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_GetRollupMinute
+// =================================================================================================
+void SL_GetRollupMinute (const char* timestamp, char* minute)
+{
+    size_t length = strnlen(timestamp, SL_TIMESTAMP_STRING_LENGTH - 1);
+
+    // Drop the seconds from a timestamp made by SL_GetTimestamp, keeping its time zone; other
+    // (imported) timestamps are cut after the minute
+    if ((length >= (SL_ROLLUP_MINUTE_LENGTH + SL_ROLLUP_SECONDS_LENGTH)) &&
+        (timestamp[SL_ROLLUP_MINUTE_LENGTH] == ':') && (timestamp[SL_ROLLUP_MINUTE_LENGTH + 3] == '.'))
+    {
+        memcpy(minute, timestamp, SL_ROLLUP_MINUTE_LENGTH);
+        memcpy(minute + SL_ROLLUP_MINUTE_LENGTH,
+               timestamp + SL_ROLLUP_MINUTE_LENGTH + SL_ROLLUP_SECONDS_LENGTH,
+               length - SL_ROLLUP_MINUTE_LENGTH - SL_ROLLUP_SECONDS_LENGTH);
+        minute[length - SL_ROLLUP_SECONDS_LENGTH] = '\0';
+    }
+    else
+    {
+        if (length > SL_ROLLUP_MINUTE_LENGTH)
+            length = SL_ROLLUP_MINUTE_LENGTH;
+        memcpy(minute, timestamp, length);
+        minute[length] = '\0';
+    }
+}
+
+// =================================================================================================
+//  SL_MatchRollup
+// =================================================================================================
+bool SL_MatchRollup (const tSL_LogEntry* entry, const tSL_LogEntry* other)
+{
+    char minute[SL_TIMESTAMP_STRING_LENGTH] = {0};
+    char otherMinute[SL_TIMESTAMP_STRING_LENGTH] = {0};
+
+    SL_GetRollupMinute(entry->timestamp, minute);
+    SL_GetRollupMinute(other->timestamp, otherMinute);
+
+    return (strcmp(minute, otherMinute) == 0) && (strcmp(entry->level, other->level) == 0) &&
+           (strcmp(entry->tag, other->tag) == 0);
+}
+
+// =================================================================================================
+//  SL_WriteRollups
+// =================================================================================================
+int32_t SL_WriteRollups (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    sqlite3_stmt* statement = NULL;
+    char minute[SL_TIMESTAMP_STRING_LENGTH] = {0};
+    uint32_t rollupCount = 0;
+    uint_fast32_t i = 0;
+
+    // Count the batch's entries per minute, level and tag in memory first, so each count only
+    // costs one upsert
+    memset((void*)gRollupSlots, 0, sizeof(gRollupSlots));
+    for (i = 0; i < gLogEntryCount; i++)
+    {
+        const tSL_LogEntry* entry = &(gLogEntries[i]);
+        uint32_t slot = 0;
+
+        SL_GetRollupMinute(entry->timestamp, minute);
+        slot = (uint32_t)(SL_HashLogEntry(minute, entry->logLevel, NULL, 0, entry->tag) % SL_ROLLUP_SLOT_COUNT);
+        while ((gRollupSlots[slot] != 0) &&
+               !SL_MatchRollup(entry, &(gLogEntries[gRollupCounts[gRollupSlots[slot] - 1].entryIndex])))
+            slot = (slot + 1) % SL_ROLLUP_SLOT_COUNT;
+        if (gRollupSlots[slot] == 0)
+        {
+            gRollupCounts[rollupCount].entryIndex = (uint32_t)i;
+            gRollupCounts[rollupCount].count = 0;
+            gRollupCounts[rollupCount].repeatCount = 0;
+            gRollupSlots[slot] = ++rollupCount;
+        }
+        gRollupCounts[gRollupSlots[slot] - 1].count++;
+        gRollupCounts[gRollupSlots[slot] - 1].repeatCount += entry->repeatCount;
+    }
+
+    // Then add the counts to the rollups table
+    result = SL_GetStatement(eSL_Statement_UpsertRollup, &statement);
+    for (i = 0; (i < rollupCount) && (result == SQLITE_OK); i++)
+    {
+        const tSL_LogEntry* entry = &(gLogEntries[gRollupCounts[i].entryIndex]);
+
+        SL_GetRollupMinute(entry->timestamp, minute);
+        result = sqlite3_bind_text(statement, 1, minute, -1, SQLITE_TRANSIENT);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_text(statement, 2, entry->level, -1, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_text(statement, 3, entry->tag, -1, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int64(statement, 4, (sqlite3_int64)gRollupCounts[i].count);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int64(statement, 5, (sqlite3_int64)gRollupCounts[i].repeatCount);
+        if (result == SQLITE_OK)
+        {
+            result = sqlite3_step(statement);
+            if (result == SQLITE_DONE)
+                result = SQLITE_OK; // Eat this result code
+        }
+        (void)sqlite3_reset(statement);
+    }
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, writing rollups failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_UpdateDictionary
+// =================================================================================================
+int32_t SL_UpdateDictionary (void)
+{
+    int32_t result = SQLITE_OK;
+    uint_fast32_t i = 0;
+
+    // Sample the batch
+    for (i = 0; i < gLogEntryCount; i++)
+    {
+        SL_AddDictionarySample(&gDictionaryTrainer, gLogEntries[i].message, 
+                               strlen(gLogEntries[i].message));
+        if (gLogEntries[i].supplementalData[0] != 0)
+            SL_AddDictionarySample(&gDictionaryTrainer, gLogEntries[i].supplementalData,
+                                   strlen(gLogEntries[i].supplementalData));
+    }
+
+    // Train a dictionary if there isn't one yet, and periodically retrain to follow the logs
+    gDictionaryBatchCount++;
+    if (((gDictionary.size == 0) || (gDictionaryBatchCount >= SL_DICTIONARY_TRAINING_INTERVAL)) &&
+        (SL_TrainDictionary(&gDictionaryTrainer, &gTrainedDictionary) == SL_RESULT_SUCCESS))
+    {
+        gDictionaryBatchCount = 0;
+
+        // Only store a dictionary if it's changed
+        if ((gTrainedDictionary.size != gDictionary.size) ||
+            (memcmp((const void*)gTrainedDictionary.content, (const void*)gDictionary.content, 
+                    gDictionary.size) != 0))
+        {
+            char timestamp[SL_TIMESTAMP_STRING_LENGTH] = {0};
+            sqlite3_stmt* statement = NULL;
+
+            (void)SL_GetTimestamp(timestamp);
+            result = SL_GetStatement(eSL_Statement_InsertDictionary, &statement);
+            if (result == SQLITE_OK)
+                result = sqlite3_bind_text(statement, 1, timestamp, strlen(timestamp), SQLITE_STATIC);
+            if (result == SQLITE_OK)
+                result = sqlite3_bind_blob(statement, 2,
+                                           gTrainedDictionary.content, (int)gTrainedDictionary.size,
+                                           SQLITE_STATIC);
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_step(statement);
+                if (result == SQLITE_DONE)
+                    result = SQLITE_OK; // Eat this result code
+            }
+            if (result == SQLITE_OK)
+                result = sqlite3_reset(statement);
+            else if (statement != NULL)
+                (void)sqlite3_reset(statement);
+
+            // Compress the rest of the batch with the new dictionary
+            if (result == SQLITE_OK)
+            {
+                gTrainedDictionary.id = sqlite3_last_insert_rowid(gSQLiteDatabase);
+                memcpy((void*)&gDictionary, (const void*)&gTrainedDictionary, 
+                       sizeof(tSL_CompressionDictionary));
+            }
+            else
+                fprintf(SL_TERMINAL, 
+                        "At line %d in function %s, dictionary insert failed with result %d.\n", 
+                        __LINE__, __FUNCTION__, result);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_BindColumnText
+// =================================================================================================
+int32_t SL_BindColumnText (int index, const char* text, bool* dictionaryUsed)
+{
+    int32_t result = SQLITE_OK;
+    size_t length = strlen(text);
+    size_t compressedLength = 0;
+    uint32_t threshold = gCompressionThreshold;
+    const tSL_CompressionDictionary* dictionary = NULL;
+
+    // A dictionary makes even short text worth compressing
+    if (gDictionaryCompression && (gDictionary.size > 0))
+    {
+        dictionary = &gDictionary;
+        threshold = SL_DICTIONARY_COMPRESSION_THRESHOLD;
+    }
+
+    // Store text at or above the compression threshold as a compressed BLOB, if that's smaller
+    if ((threshold > 0) && (length >= threshold) &&
+        (SL_CompressValue(dictionary, (const uint8_t*)text, length, 
+                          gCompressionBuffer, SL_COMPRESSION_BUFFER_SIZE,
+                          &compressedLength) == SL_RESULT_SUCCESS) &&
+        (compressedLength < length))
+    {
+        if (dictionary != NULL)
+            *dictionaryUsed = true;
+
+        // SQLite copies the BLOB, so the compression buffer can be reused for the next column
+        result = sqlite3_bind_blob(gInsertStatement, index,
+                                   gCompressionBuffer, (int)compressedLength,
+                                   SQLITE_TRANSIENT);
+        if (result != SQLITE_OK)
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, sqlite3_bind_blob failed with result %d.\n", 
+                    __LINE__, __FUNCTION__, result);
+    }
+    else
+    {
+        result = sqlite3_bind_text(gInsertStatement, index, text, length, SQLITE_STATIC);
+        if (result != SQLITE_OK)
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
+                    __LINE__, __FUNCTION__, result);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_AddLogEntry
+// =================================================================================================
+int32_t SL_AddLogEntry (const char* message,
+                        tSL_LogLevel level,
+                        const char* fileName,
+                        const char* functionName,
+                        uint32_t lineNumber,
+                        const char* tag,
+                        const char* supplementalData,
+                        double sampleRate)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Timestamp
+    (void)SL_GetTimestamp(gLogEntries[gLogEntryCount].timestamp);
+
+    // Message
+    strncpy(gLogEntries[gLogEntryCount].message, message, 
+            (strlen(message) < (SL_MESSAGE_STRING_LENGTH - 1)) ? 
+                strlen(message) : SL_MESSAGE_STRING_LENGTH);
+
+    // Level
+    strncpy(gLogEntries[gLogEntryCount].level, SL_GetLevelString(level), SL_LEVEL_STRING_LENGTH - 1);
+
+    // File name
+    if (fileName != NULL)
+        strncpy(gLogEntries[gLogEntryCount].fileName, fileName, 
+                (strlen(fileName) < (SL_FILE_NAME_STRING_LENGTH - 1)) ? 
+                    strlen(fileName) : SL_FILE_NAME_STRING_LENGTH);
+
+    // Function name
+    if (functionName != NULL)
+        strncpy(gLogEntries[gLogEntryCount].functionName, functionName, 
+                (strlen(functionName) < (SL_FUNCTION_NAME_STRING_LENGTH - 1)) ? 
+                    strlen(functionName) : SL_FUNCTION_NAME_STRING_LENGTH);
+
+    // Line number
+    gLogEntries[gLogEntryCount].lineNumber = lineNumber;
+
+    // Tag
+    if (tag != NULL)
+        strncpy(gLogEntries[gLogEntryCount].tag, tag, 
+                (strlen(tag) < (SL_TAG_STRING_LENGTH - 1)) ? 
+                    strlen(tag) : SL_TAG_STRING_LENGTH);
+
+    // Supplemental data
+    if (supplementalData != NULL)
+        strncpy(gLogEntries[gLogEntryCount].supplementalData, supplementalData, 
+                (strlen(supplementalData) < (SL_SUPPLEMENTAL_DATA_STRING_LENGTH - 1)) ? 
+                    strlen(supplementalData) : SL_SUPPLEMENTAL_DATA_STRING_LENGTH);
+
+    // Repeat count
+    gLogEntries[gLogEntryCount].repeatCount = 1;
+
+    // Sample rate
+    gLogEntries[gLogEntryCount].sampleRate = sampleRate;
+
+    // Level (for subscribers)
+    gLogEntries[gLogEntryCount].logLevel = level;
+
+    // Bump entry count
+    gLogEntryCount++;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AddImportedLogEntry
+// =================================================================================================
+int32_t SL_AddImportedLogEntry (const tSL_ImportRecord* record)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_LogEntry* entry = &(gLogEntries[gLogEntryCount]);
+
+    // Imported values are truncated the same way logged values are (the entry is zeroed, so
+    // the strings stay terminated); an entry without a timestamp (like the lines of a stack
+    // trace after the line that logged it) gets the one before it, so it stays in place when
+    // entries are merged or queried by time
+    if (record->timestamp != NULL)
+    {
+        strncpy(entry->timestamp, record->timestamp, SL_TIMESTAMP_STRING_LENGTH - 1);
+        memcpy((void*)gImportTimestamp, (void*)entry->timestamp, SL_TIMESTAMP_STRING_LENGTH);
+    }
+    else
+        memcpy((void*)entry->timestamp, (void*)gImportTimestamp, SL_TIMESTAMP_STRING_LENGTH);
+    strncpy(entry->message, record->message, SL_MESSAGE_STRING_LENGTH - 1);
+    strncpy(entry->level, SL_GetLevelString(record->level), SL_LEVEL_STRING_LENGTH - 1);
+    if (record->fileName != NULL)
+        strncpy(entry->fileName, record->fileName, SL_FILE_NAME_STRING_LENGTH - 1);
+    if (record->functionName != NULL)
+        strncpy(entry->functionName, record->functionName, SL_FUNCTION_NAME_STRING_LENGTH - 1);
+    entry->lineNumber = record->lineNumber;
+    if (record->tag != NULL)
+        strncpy(entry->tag, record->tag, SL_TAG_STRING_LENGTH - 1);
+    if (record->supplementalData != NULL)
+        strncpy(entry->supplementalData, record->supplementalData, SL_SUPPLEMENTAL_DATA_STRING_LENGTH - 1);
+    entry->repeatCount = record->repeatCount;
+    if (record->lastTimestamp != NULL)
+        strncpy(entry->lastTimestamp, record->lastTimestamp, SL_TIMESTAMP_STRING_LENGTH - 1);
+    else
+        strncpy(entry->lastTimestamp, entry->timestamp, SL_TIMESTAMP_STRING_LENGTH - 1);
+    entry->sampleRate = record->sampleRate;
+    entry->logLevel = record->level;
+
+    // Bump entry count
+    gLogEntryCount++;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_ProcessTransaction
+// =================================================================================================
+int32_t SL_ProcessTransaction (void)
+{
+    int32_t result = SL_WriteTransaction();
+
+    // Under a memory limit, SQLite gives back what it has cached and the batch is tried once
+    // more; if it still doesn't fit, the entries stay in the buffer, and logging fails with
+    // SQLITE_NOMEM until a batch is written, instead of using more memory
+    if ((result == SQLITE_NOMEM) && (gMemoryLimit > 0))
+    {
+        (void)sqlite3_db_release_memory(gSQLiteDatabase);
+        result = SL_WriteTransaction();
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_WriteTransaction
+// =================================================================================================
+int32_t SL_WriteTransaction (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint_fast32_t i = 0;
+    bool dictionaryUsed = false;
+
+    // Start the transaction
+    result = SL_StepStatement(eSL_Statement_BeginTransaction);
+    if (result == SQLITE_OK)
+    {
+        // The dictionary is stored in the same transaction as the rows that use it
+        if (gDictionaryCompression)
+            result = SL_UpdateDictionary();
+
+        for (i = 0; (i < gLogEntryCount) && (result == SQLITE_OK); i++)
+        {
+            // Timestamp
+            result = sqlite3_bind_text(gInsertStatement, 1, 
+                                        gLogEntries[i].timestamp, 
+                                        strlen(gLogEntries[i].timestamp), 
+                                        SQLITE_STATIC);     
+            if (result != SQLITE_OK)
+                fprintf(SL_TERMINAL, 
+                        "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
+                        __LINE__, __FUNCTION__, result);
+
+            // Message
+            dictionaryUsed = false;
+            if (result == SQLITE_OK)
+                result = SL_BindColumnText(2, gLogEntries[i].message, &dictionaryUsed);
+
+            // Log level
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_bind_text(gInsertStatement, 3,
+                                            gLogEntries[i].level,
+                                            strlen(gLogEntries[i].level),
+                                            SQLITE_STATIC);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL, 
+                            "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // File name
+            if (result == SQLITE_OK)
+            {
+                if (gLogEntries[i].fileName == NULL)
+                {
+                    result = sqlite3_bind_null(gInsertStatement, 4);
+                    if (result != SQLITE_OK)
+                        fprintf(SL_TERMINAL, 
+                                "At line %d in function %s, sqlite3_bind_null failed with result %d.\n", 
+                                __LINE__, __FUNCTION__, result);
+                }
+                else
+                {
+                    result = sqlite3_bind_text(gInsertStatement, 4,
+                                                gLogEntries[i].fileName,
+                                                strlen(gLogEntries[i].fileName),
+                                                SQLITE_STATIC);
+                    if (result != SQLITE_OK)
+                        fprintf(SL_TERMINAL, 
+                                "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
+                                __LINE__, __FUNCTION__, result);
+                }
+            }
+
+            // Function name
+            if (result == SQLITE_OK)
+            {
+                if (gLogEntries[i].functionName == NULL)
+                {
+                    result = sqlite3_bind_null(gInsertStatement, 5);
+                    if (result != SQLITE_OK)
+                        fprintf(SL_TERMINAL, 
+                                "At line %d in function %s, sqlite3_bind_null failed with result %d.\n", 
+                                __LINE__, __FUNCTION__, result);
+                }
+                else
+                {
+                    result = sqlite3_bind_text(gInsertStatement, 5,
+                                                gLogEntries[i].functionName,
+                                                strlen(gLogEntries[i].functionName),
+                                                SQLITE_STATIC);
+                    if (result != SQLITE_OK)
+                        fprintf(SL_TERMINAL, 
+                                "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
+                                __LINE__, __FUNCTION__, result);
+                }
+            }
+
+            // Line number
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_bind_int(gInsertStatement, 6,
+                                            gLogEntries[i].lineNumber);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL, 
+                            "At line %d in function %s, sqlite3_bind_int failed with result %d.\n", 
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Tag
+            if (result == SQLITE_OK)
+            {
+                if (gLogEntries[i].tag == NULL)
+                {
+                    result = sqlite3_bind_null(gInsertStatement, 7);
+                    if (result != SQLITE_OK)
+                        fprintf(SL_TERMINAL, 
+                                "At line %d in function %s, sqlite3_bind_null failed with result %d.\n", 
+                                __LINE__, __FUNCTION__, result);
+                }
+                else
+                {
+                    result = sqlite3_bind_text(gInsertStatement, 7,
+                                                gLogEntries[i].tag,
+                                                strlen(gLogEntries[i].tag),
+                                                SQLITE_STATIC);
+                    if (result != SQLITE_OK)
+                        fprintf(SL_TERMINAL, 
+                                "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
+                                __LINE__, __FUNCTION__, result);
+                }
+            }
+
+            // Supplemental data
+            if (result == SQLITE_OK)
+            {
+                if (gLogEntries[i].supplementalData == NULL)
+                {
+                    result = sqlite3_bind_null(gInsertStatement, 8);
                     if (result != SQLITE_OK)
                         fprintf(SL_TERMINAL, 
                                 "At line %d in function %s, sqlite3_bind_null failed with result %d.\n", 
                                 __LINE__, __FUNCTION__, result);
                 }
                 else
+                    result = SL_BindColumnText(8, gLogEntries[i].supplementalData, &dictionaryUsed);
+            }
+
+            // Repeat count
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_bind_int(gInsertStatement, 9,
+                                            gLogEntries[i].repeatCount);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, sqlite3_bind_int failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Last timestamp
+            if (result == SQLITE_OK)
+            {
+                if (gLogEntries[i].repeatCount <= 1)
+                {
+                    result = sqlite3_bind_null(gInsertStatement, 10);
+                    if (result != SQLITE_OK)
+                        fprintf(SL_TERMINAL,
+                                "At line %d in function %s, sqlite3_bind_null failed with result %d.\n",
+                                __LINE__, __FUNCTION__, result);
+                }
+                else
+                {
+                    result = sqlite3_bind_text(gInsertStatement, 10,
+                                                gLogEntries[i].lastTimestamp,
+                                                strlen(gLogEntries[i].lastTimestamp),
+                                                SQLITE_STATIC);
+                    if (result != SQLITE_OK)
+                        fprintf(SL_TERMINAL,
+                                "At line %d in function %s, sqlite3_bind_text failed with result %d.\n",
+                                __LINE__, __FUNCTION__, result);
+                }
+            }
+
+            // Sample rate
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_bind_double(gInsertStatement, 11,
+                                             gLogEntries[i].sampleRate);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, sqlite3_bind_double failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Dictionary id
+            if (result == SQLITE_OK)
+            {
+                if (dictionaryUsed)
+                    result = sqlite3_bind_int64(gInsertStatement, 12, gDictionary.id);
+                else
+                    result = sqlite3_bind_null(gInsertStatement, 12);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, sqlite3_bind failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Perform the insert
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_step(gInsertStatement);
+                if (result == SQLITE_DONE)
+                    result = SQLITE_OK; // Eat this result code
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL, 
+                            "At line %d in function %s, sqlite3_step failed with result %d.\n", 
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Reset the statement
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_reset(gInsertStatement);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL, 
+                            "At line %d in function %s, sqlite3_reset failed with result %d.\n", 
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // If there was an error, break
+            if (result != SQLITE_OK)
+                break;
+        }
+
+        // Ended spans and metric intervals are written with the batch, including an interval that
+        // has ended since its last value was recorded (if there's no room for it, it's written
+        // with a later batch)
+        if ((result == SQLITE_OK) && (gMetricCount > 0) && (gMetricIntervalStart != 0) &&
+            (time(NULL) >= (gMetricIntervalStart + (time_t)gMetricInterval)) &&
+            ((gEndedMetricCount + gMetricCount) <= SL_METRIC_CACHE_SIZE))
+        {
+            result = SL_EndMetricInterval();
+            gMetricIntervalStart = 0;
+        }
+        if ((result == SQLITE_OK) && (gEndedSpanCount > 0))
+            result = SL_WriteSpans();
+        if ((result == SQLITE_OK) && (gEndedMetricCount > 0))
+            result = SL_WriteMetrics();
+
+        // The rollups are kept up to date with the log entries
+        if ((result == SQLITE_OK) && gRollups && (gLogEntryCount > 0))
+            result = SL_WriteRollups();
+
+        // End (commit) the transaction
+        if (result == SQLITE_OK)
+        {
+            result = SL_StepStatement(eSL_Statement_EndTransaction);
+            if (result != SQLITE_OK)
+                fprintf(SL_TERMINAL, 
+                        "At line %d in function %s, ending the transaction failed with result %d.\n",
+                        __LINE__, __FUNCTION__, result);
+            else
+            {
+                gEndedSpanCount = 0;
+                gEndedMetricCount = 0;
+
+                // Deliver the written entries to subscribers (imported entries are history)
+                if (!gImporting && (__atomic_load_n(&gSubscriptionCount, __ATOMIC_RELAXED) > 0))
+                {
+                    for (i = 0; i < gLogEntryCount; i++)
+                        SL_NotifySubscribers(&(gLogEntries[i]), true);
+                }
+            }
+        }
+
+        // Rollback the transaction if anything failed (the commit included); an insert that
+        // failed can't be bound again until it's reset, and its bindings point into the entries,
+        // which are kept for the next try
+        if (result != SQLITE_OK)
+        {
+            if (gInsertStatement != NULL)
+            {
+                (void)sqlite3_reset(gInsertStatement);
+                (void)sqlite3_clear_bindings(gInsertStatement);
+            }
+            (void)SL_StepStatement(eSL_Statement_RollbackTransaction);
+
+            // The dictionary may have been rolled back too, so train a new one
+            memset((void*)&gDictionary, 0, sizeof(tSL_CompressionDictionary));
+        }
+    }
+    else    // Starting the transaction failed
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, starting the transaction failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_Initialize
+// =================================================================================================
+int32_t SL_Initialize (const char* path)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Check arguments
+    if (path == NULL)
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_Initialize argument 'path' is NULL.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (strlen(path) == 0)
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_Initialize argument 'path' is empty.\n",
+                __LINE__, __FUNCTION__);
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        // Make sure we're not already initialized
+        if (gSQLiteDatabase != NULL)
+        {
+            result = SL_RESULT_ALREADY_INITIALIZED;
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, calling SL_Initialize more than once.\n",
+                    __LINE__, __FUNCTION__);
+        }
+    }
+
+    // Hand SQLite its preallocated memory before it's used, and limit the rest
+    if ((result == SL_RESULT_SUCCESS) && (gMemoryBudget > 0))
+        result = SL_ConfigureMemory();
+    if ((result == SL_RESULT_SUCCESS) && (gMemoryLimit > 0))
+    {
+        result = SL_LimitMemory();
+        if ((result != SL_RESULT_SUCCESS) && (gMemoryArena != NULL))
+            SL_ReleaseMemory();
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        result = SL_RegisterAppendVFS();
+        SL_SetAppendAsyncWrites(gAsyncWrites);
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        // Initialize SQLite
+        result = sqlite3_open_v2(path, &gSQLiteDatabase, 
+                                 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, SL_APPEND_VFS_NAME);
+        if (result == SQLITE_OK)
+        {
+            // Give the connection its lookaside slots, and keep its page cache within the
+            // preallocated pages
+            if (gMemoryArena != NULL)
+            {
+                result = sqlite3_db_config(gSQLiteDatabase, SQLITE_DBCONFIG_LOOKASIDE,
+                                           (void*)gMemoryArena, SL_LOOKASIDE_SLOT_SIZE,
+                                           (int)gLookasideSlotCount);
+                if (result == SQLITE_OK)
+                {
+                    char cmdString[64] = {0};
+
+                    snprintf(cmdString, sizeof(cmdString), "PRAGMA cache_size = %u;", gPageCacheSlotCount);
+                    result = sqlite3_exec(gSQLiteDatabase, cmdString, NULL, NULL, NULL);
+                }
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, configuring the preallocated memory failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Map the log file into memory, if asked to
+            if ((result == SQLITE_OK) && (gMemoryMapSize > 0))
+            {
+                result = SL_SetDatabaseMemoryMapSize(gSQLiteDatabase, gMemoryMapSize);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, SL_SetDatabaseMemoryMapSize failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Grow the log file in chunks, if asked to
+            if ((result == SQLITE_OK) && (gChunkSize > 0))
+            {
+                int chunkSize = (int)gChunkSize;
+
+                result = sqlite3_file_control(gSQLiteDatabase, "main", SQLITE_FCNTL_CHUNK_SIZE, (void*)&chunkSize);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, sqlite3_file_control failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Switch to WAL mode, with checkpoints on their own thread, before anything's written
+            if ((result == SQLITE_OK) && ((gCheckpointInterval > 0) || (gCheckpointPageThreshold > 0)))
+                result = SL_StartCheckpointer(gSQLiteDatabase, path, SL_APPEND_VFS_NAME,
+                                              gCheckpointInterval, gCheckpointPageThreshold);
+
+            // Register SQL functions and modules
+            if (result == SQLITE_OK)
+                result = SL_RegisterCompressionFunctions(gSQLiteDatabase);
+            if (result == SQLITE_OK)
+                result = SL_RegisterArchiveModule(gSQLiteDatabase);
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_create_module(gSQLiteDatabase, SL_PENDING_MODULE_NAME,
+                                               &gSL_PendingModule, NULL);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL, 
+                            "At line %d in function %s, sqlite3_create_module failed with result %d.\n", 
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Create the dictionary table
+            if ((result == SQLITE_OK) && gDictionaryCompression)
+            {
+                result = sqlite3_exec(gSQLiteDatabase, kSL_CreateDictionaryTableSQLCommandString,
+                                      NULL, NULL, NULL);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL, 
+                            "At line %d in function %s, sqlite3_exec failed with result %d.\n", 
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Create the rollups table
+            if ((result == SQLITE_OK) && gRollups)
+            {
+                result = sqlite3_exec(gSQLiteDatabase, kSL_CreateRollupsTableSQLCommandString,
+                                      NULL, NULL, NULL);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, sqlite3_exec failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+
+            // Create the logging table
+            if (result == SQLITE_OK)
+            {
+                (void)SL_GetTimestamp(gLogTimestamp);
+                result = SL_CreateTable(gLogTimestamp);
+            }
+            if (result == SL_RESULT_SUCCESS)
+            {
+                // Create the views
+                result = SL_CreateViews(gLogTimestamp);
+                if (result == SL_RESULT_SUCCESS)
+                    result = SL_CreateLiveView();
+
+                // Check status
+                if (result == SL_RESULT_SUCCESS)
+                {
+                    // Initialize log entry list
+                    memset((void*)gLogEntries, 0, sizeof(tSL_LogEntry) * SL_LOG_ENTRY_CACHE_SIZE);
+
+                    // Initialize rate limit buckets
+                    memset((void*)gRateLimitBuckets, 0, sizeof(tSL_RateLimitBucket) * SL_RATE_LIMIT_TABLE_SIZE);
+
+                    // Initialize the prepared statement for inserts (the other statements are
+                    // prepared when they're first used)
+                    result = SL_GetStatement(eSL_Statement_Insert, &gInsertStatement);
+
+                    // Initialize dictionary training
+                    if ((result == SQLITE_OK) && gDictionaryCompression)
+                    {
+                        memset((void*)&gDictionaryTrainer, 0, sizeof(tSL_DictionaryTrainer));
+                        memset((void*)&gDictionary, 0, sizeof(tSL_CompressionDictionary));
+                        gDictionaryBatchCount = 0;
+                    }
+                }
+            }
+        }
+        else    // sqlite3_open_v2 failed
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, sqlite3_open_v2 failed with result %d.\n", 
+                    __LINE__, __FUNCTION__, result);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_Terminate
+// =================================================================================================
+int32_t SL_Terminate (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Make sure we're initialized
+    if (gSQLiteDatabase != NULL)
+    {
+        // Make sure there aren't any uncommitted log entries (or ended spans, or metrics, which
+        // are written up to now)
+        if (gMetricCount > 0)
+            result = SL_EndMetricInterval();
+        if ((result == SL_RESULT_SUCCESS) &&
+            ((gLogEntryCount > 0) || (gEndedSpanCount > 0) || (gEndedMetricCount > 0)))
+            result = SL_WriteBatch();
+
+        // Stop checkpointing (closing the database checkpoints the rest of the WAL)
+        SL_StopCheckpointer();
+
+        // Spans that weren't ended are dropped
+        gOpenSpanCount = 0;
+        gEndedSpanCount = 0;
+        gLastSpanId = 0;
+        gSpansTableCreated = false;
+        gMetricIntervalStart = 0;
+        gMetricCount = 0;
+        gEndedMetricCount = 0;
+        gMetricsTableCreated = false;
+
+        // Finalize (free) the cached prepared statements
+        SL_FinalizeStatements();
+
+        // Close the database
+        (void)sqlite3_close_v2(gSQLiteDatabase);
+        gSQLiteDatabase = NULL;
+
+        // Take back the preallocated memory, and lift the memory limit; SQLite has to be shut
+        // down to stop using the arena, which is why no other connection can be open
+        if (gMemoryArena != NULL)
+        {
+            (void)sqlite3_shutdown();
+            SL_ReleaseMemory();
+        }
+        if (gMemoryLimit > 0)
+            SL_UnlimitMemory();
+    }
+    else
+    {
+        result = SL_RESULT_NOT_INITIALIZED;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, calling SL_Terminate when SQLite Logger not initialized.\n",
+                __LINE__, __FUNCTION__);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetLogLevel
+// =================================================================================================
+int32_t SL_SetLogLevel (tSL_LogLevel level)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Check argument
+    if ((level >= eSL_LogLevel_Diagnostic) && (level <= eSL_LogLevel_None))
+        gLogLevel = level;
+    else
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_SetLogLevel argument 'level' with value %d is invalid.\n",
+                __LINE__, __FUNCTION__, (int32_t)level);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_GetLogLevel
+// =================================================================================================
+int32_t SL_GetLogLevel (tSL_LogLevel* level)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Check argument
+    if (level == NULL)
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_GetLogLevel argument 'level' is NULL.\n",
+                __LINE__, __FUNCTION__);
+    }
+    
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+        *level = gLogLevel;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_Log
+// =================================================================================================
+int32_t SL_Log (const char* message,
+                tSL_LogLevel level,
+                const char* fileName,
+                const char* functionName,
+                uint32_t lineNumber,
+                const char* tag,
+                const char* supplementalData)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Check arguments
+    if (message == NULL)
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_Log argument 'message' is NULL.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (strlen(message) == 0)
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_Log argument 'message' is empty.\n",
+                __LINE__, __FUNCTION__);
+    }
+
+    if ((level < eSL_LogLevel_Diagnostic) || (level > eSL_LogLevel_None))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_Log argument 'level' with value %d is invalid.\n",
+                __LINE__, __FUNCTION__, (int32_t)level);
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        // Make sure we're initialized
+        if (gSQLiteDatabase == NULL)
+        {
+            result = SL_RESULT_NOT_INITIALIZED;
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, SQLite Logger is not initialized.\n",
+                    __LINE__, __FUNCTION__);
+        }
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        tSL_RateLimitBucket* bucket = NULL;
+        double sampleRate = SL_GetSamplingRate(level, tag);
+
+        // Check log level, sampling rate and rate limit
+        if ((level >= gLogLevel) &&
+            SL_SampleLogEntry(sampleRate) &&
+            ((gRateLimit == 0) || 
+             !SL_CollapseRepeat(message, level, fileName, lineNumber, tag, &bucket)))
+        {
+            if (gLogEntryCount < (SL_LOG_ENTRY_CACHE_SIZE - 1))
+            {
+                // Add a new log entry
+                result = SL_AddLogEntry(message, level, fileName, functionName,
+                                        lineNumber, tag, supplementalData, sampleRate);
+            }
+            else
+            {
+                // Process a transaction
+                result = SL_WriteBatch();
+                if (result == SL_RESULT_SUCCESS)
                 {
-                    result = sqlite3_bind_text(gInsertStatement, 4,
-                                                gLogEntries[i].fileName,
-                                                strlen(gLogEntries[i].fileName),
-                                                SQLITE_STATIC);
-                    if (result != SQLITE_OK)
-                        fprintf(SL_TERMINAL, 
-                                "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
-                                __LINE__, __FUNCTION__, result);
+                    // Add a new log entry
+                    result = SL_AddLogEntry(message, level, fileName, functionName,
+                                            lineNumber, tag, supplementalData, sampleRate);
                 }
             }
 
-            // Function name
-            if (result == SQLITE_OK)
-            {
-                if (gLogEntries[i].functionName == NULL)
-                {
-                    result = sqlite3_bind_null(gInsertStatement, 5);
-                    if (result != SQLITE_OK)
-                        fprintf(SL_TERMINAL, 
-                                "At line %d in function %s, sqlite3_bind_null failed with result %d.\n", 
-                                __LINE__, __FUNCTION__, result);
-                }
-                else
-                {
-                    result = sqlite3_bind_text(gInsertStatement, 5,
-                                                gLogEntries[i].functionName,
-                                                strlen(gLogEntries[i].functionName),
-                                                SQLITE_STATIC);
-                    if (result != SQLITE_OK)
-                        fprintf(SL_TERMINAL, 
-                                "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
-                                __LINE__, __FUNCTION__, result);
-                }
-            }
+            // Remember where repeats of this message should be collapsed to
+            if ((result == SL_RESULT_SUCCESS) && (bucket != NULL))
+            {
+                bucket->entryIndex = gLogEntryCount - 1;
+                bucket->batchNumber = gBatchNumber;
+            }
+
+            // Deliver the entry to subscribers
+            if ((result == SL_RESULT_SUCCESS) && 
+                (__atomic_load_n(&gSubscriptionCount, __ATOMIC_RELAXED) > 0))
+                SL_NotifySubscribers(&(gLogEntries[gLogEntryCount - 1]), false);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_SpanBegin
+// =================================================================================================
+int32_t SL_SpanBegin (const char* name, const char* tag, tSL_SpanId parentId, tSL_SpanId* spanId)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Check arguments
+    if ((name == NULL) || (spanId == NULL))
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_SpanBegin has a NULL argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (gSQLiteDatabase == NULL)
+    {
+        result = SL_RESULT_NOT_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_SpanBegin when SQLite Logger not initialized.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (gOpenSpanCount == SL_MAX_OPEN_SPANS)
+    {
+        result = ENOSPC;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, there are already %d spans open.\n",
+                __LINE__, __FUNCTION__, SL_MAX_OPEN_SPANS);
+    }
+    else if (!gSpansTableCreated)
+        result = SL_OpenSpansTable();
+
+    // Open the span, with the clock read last
+    if (result == SL_RESULT_SUCCESS)
+    {
+        tSL_Span* span = &(gOpenSpans[gOpenSpanCount++]);
+
+        span->id = ++gLastSpanId;
+        span->parentId = parentId;
+        strncpy(span->name, name, SL_TAG_STRING_LENGTH - 1);
+        span->name[SL_TAG_STRING_LENGTH - 1] = '\0';
+        if (tag != NULL)
+        {
+            strncpy(span->tag, tag, SL_TAG_STRING_LENGTH - 1);
+            span->tag[SL_TAG_STRING_LENGTH - 1] = '\0';
+        }
+        else
+            span->tag[0] = '\0';
+        (void)SL_GetTimestamp(span->timestamp);
+        *spanId = span->id;
+        span->start = SL_GetSpanTime();
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_SpanEnd
+// =================================================================================================
+int32_t SL_SpanEnd (tSL_SpanId spanId)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint64_t end = SL_GetSpanTime();
+    uint_fast32_t i = 0;
+
+    // Make sure we're initialized
+    if (gSQLiteDatabase == NULL)
+    {
+        result = SL_RESULT_NOT_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_SpanEnd when SQLite Logger not initialized.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else
+    {
+        // Spans usually end in the reverse order they began
+        for (i = gOpenSpanCount; (i > 0) && (gOpenSpans[i - 1].id != spanId); i--)
+            ;
+        if (i == 0)
+        {
+            result = ENOENT;
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, span %llu isn't open.\n",
+                    __LINE__, __FUNCTION__, (unsigned long long)spanId);
+        }
+    }
+
+    // Write a full cache of ended spans (with the log entries so far) before adding this one
+    if ((result == SL_RESULT_SUCCESS) && (gEndedSpanCount == SL_SPAN_CACHE_SIZE))
+        result = SL_WriteBatch();
+
+    // Move the span from the open spans to the ended spans
+    if (result == SL_RESULT_SUCCESS)
+    {
+        gOpenSpans[i - 1].end = end;
+        gEndedSpans[gEndedSpanCount++] = gOpenSpans[i - 1];
+        gOpenSpans[i - 1] = gOpenSpans[--gOpenSpanCount];
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_RecordMetric
+// =================================================================================================
+int32_t SL_RecordMetric (const char* name, double value)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    time_t now = time(NULL);
+    tSL_Metric* metric = NULL;
+    uint_fast32_t i = 0;
+
+    // Check arguments
+    if (name == NULL)
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_RecordMetric argument 'name' is NULL.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if ((name[0] == '\0') || (value != value))   // NaN isn't equal to itself
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_RecordMetric has an invalid argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (gSQLiteDatabase == NULL)
+    {
+        result = SL_RESULT_NOT_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_RecordMetric when SQLite Logger not initialized.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (!gMetricsTableCreated)
+    {
+        // The metrics table is only created once metrics are used
+        result = SL_StepStatement(eSL_Statement_CreateMetricsTable);
+        if (result == SQLITE_OK)
+            gMetricsTableCreated = true;
+        else
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, creating the metrics table failed with result %d.\n",
+                    __LINE__, __FUNCTION__, result);
+    }
+
+    // Intervals start at multiples of the interval (in seconds since the epoch); one that has ended
+    // and wasn't written with a batch yet ends here, before this value starts the next one
+    if ((result == SL_RESULT_SUCCESS) && (gMetricIntervalStart != 0) &&
+        (now >= (gMetricIntervalStart + (time_t)gMetricInterval)))
+    {
+        result = SL_EndMetricInterval();
+        if (result == SL_RESULT_SUCCESS)
+            gMetricIntervalStart = 0;
+    }
+    if ((result == SL_RESULT_SUCCESS) && (gMetricIntervalStart == 0))
+        gMetricIntervalStart = now - (now % (time_t)gMetricInterval);
+
+    // Find the metric's aggregate for the interval, or start one
+    if (result == SL_RESULT_SUCCESS)
+    {
+        for (i = 0; (i < gMetricCount) && (metric == NULL); i++)
+        {
+            if (strncmp(gMetrics[i].name, name, SL_TAG_STRING_LENGTH - 1) == 0)
+                metric = &(gMetrics[i]);
+        }
+        if ((metric == NULL) && (gMetricCount < SL_MAX_METRICS))
+        {
+            struct timeval start = {gMetricIntervalStart, 0};
+
+            metric = &(gMetrics[gMetricCount++]);
+            memset((void*)metric, 0, sizeof(tSL_Metric));
+            strncpy(metric->name, name, SL_TAG_STRING_LENGTH - 1);
+            SL_FormatTimestamp(&start, metric->timestamp);
+            metric->min = value;
+            metric->max = value;
+        }
+        else if (metric == NULL)
+        {
+            result = ENOSPC;
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, there are already %d metrics in this interval.\n",
+                    __LINE__, __FUNCTION__, SL_MAX_METRICS);
+        }
+    }
+
+    // Aggregate the value; bucket 0 counts values below 1, bucket i values from 2^(i-1) up to
+    // 2^i, and the last bucket everything above that
+    if (result == SL_RESULT_SUCCESS)
+    {
+        double bound = 1.0;
+
+        metric->count++;
+        metric->sum += value;
+        if (value < metric->min)
+            metric->min = value;
+        if (value > metric->max)
+            metric->max = value;
+        metric->last = value;
+        for (i = 0; (i < (SL_METRIC_BUCKET_COUNT - 1)) && (value >= bound); i++)
+            bound *= 2.0;
+        metric->buckets[i]++;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetMetricInterval
+// =================================================================================================
+int32_t SL_SetMetricInterval (uint32_t interval)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Intervals can't change length while metrics are being recorded
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_RESULT_ALREADY_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_SetMetricInterval after SL_Initialize.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if ((interval == 0) || (interval > SL_MAXIMUM_METRIC_INTERVAL))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_SetMetricInterval argument 'interval' with value %u is invalid.\n",
+                __LINE__, __FUNCTION__, interval);
+    }
+    else
+        gMetricInterval = interval;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetRateLimit
+// =================================================================================================
+int32_t SL_SetRateLimit (uint32_t messagesPerSecond, uint32_t burstSize)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Check argument
+    if ((messagesPerSecond > 0) && (burstSize == 0))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_SetRateLimit argument 'burstSize' is zero.\n",
+                __LINE__, __FUNCTION__);
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        gRateLimit = messagesPerSecond;
+        gRateLimitBurst = burstSize;
+
+        // Start over with full buckets
+        memset((void*)gRateLimitBuckets, 0, sizeof(tSL_RateLimitBucket) * SL_RATE_LIMIT_TABLE_SIZE);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetSamplingRate
+// =================================================================================================
+int32_t SL_SetSamplingRate (tSL_LogLevel level, double rate)
+{
+    int32_t result = SL_RESULT_SUCCESS;
 
-            // Line number
-            if (result == SQLITE_OK)
-            {
-                result = sqlite3_bind_int(gInsertStatement, 6,
-                                            gLogEntries[i].lineNumber);
-                if (result != SQLITE_OK)
-                    fprintf(SL_TERMINAL, 
-                            "At line %d in function %s, sqlite3_bind_int failed with result %d.\n", 
-                            __LINE__, __FUNCTION__, result);
-            }
+    // Check arguments
+    if ((level < eSL_LogLevel_Diagnostic) || (level > eSL_LogLevel_None))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_SetSamplingRate argument 'level' with value %d is invalid.\n",
+                __LINE__, __FUNCTION__, (int32_t)level);
+    }
+    else if (!((rate > 0.0) && (rate <= 1.0)))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_SetSamplingRate argument 'rate' with value %f is invalid.\n",
+                __LINE__, __FUNCTION__, rate);
+    }
 
-            // Tag
-            if (result == SQLITE_OK)
-            {
-                if (gLogEntries[i].tag == NULL)
-                {
-                    result = sqlite3_bind_null(gInsertStatement, 7);
-                    if (result != SQLITE_OK)
-                        fprintf(SL_TERMINAL, 
-                                "At line %d in function %s, sqlite3_bind_null failed with result %d.\n", 
-                                __LINE__, __FUNCTION__, result);
-                }
-                else
-                {
-                    result = sqlite3_bind_text(gInsertStatement, 7,
-                                                gLogEntries[i].tag,
-                                                strlen(gLogEntries[i].tag),
-                                                SQLITE_STATIC);
-                    if (result != SQLITE_OK)
-                        fprintf(SL_TERMINAL, 
-                                "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
-                                __LINE__, __FUNCTION__, result);
-                }
-            }
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+        gSamplingRates[level] = rate;
 
-            // Supplemental data
-            if (result == SQLITE_OK)
-            {
-                if (gLogEntries[i].supplementalData == NULL)
-                {
-                    result = sqlite3_bind_null(gInsertStatement, 8);
-                    if (result != SQLITE_OK)
-                        fprintf(SL_TERMINAL, 
-                                "At line %d in function %s, sqlite3_bind_null failed with result %d.\n", 
-                                __LINE__, __FUNCTION__, result);
-                }
-                else
-                {
-                    result = sqlite3_bind_text(gInsertStatement, 8,
-                                                gLogEntries[i].supplementalData,
-                                                strlen(gLogEntries[i].supplementalData),
-                                                SQLITE_STATIC);
-                    if (result != SQLITE_OK)
-                        fprintf(SL_TERMINAL, 
-                                "At line %d in function %s, sqlite3_bind_text failed with result %d.\n", 
-                                __LINE__, __FUNCTION__, result);
-                }
-            }
+    return result;
+}
 
-            // Perform the insert
-            if (result == SQLITE_OK)
+// =================================================================================================
+//  SL_SetTagSamplingRate
+// =================================================================================================
+int32_t SL_SetTagSamplingRate (const char* tag, double rate)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint_fast32_t i = 0;
+
+    // Check arguments
+    if (tag == NULL)
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_SetTagSamplingRate argument 'tag' is NULL.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (strlen(tag) == 0)
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_SetTagSamplingRate argument 'tag' is empty.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (!((rate > 0.0) && (rate <= 1.0)))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_SetTagSamplingRate argument 'rate' with value %f is invalid.\n",
+                __LINE__, __FUNCTION__, rate);
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        // Look for an existing rate for this tag
+        for (i = 0; i < gTagSamplingRateCount; i++)
+        {
+            if (strncmp(gTagSamplingRates[i].tag, tag, SL_TAG_STRING_LENGTH - 1) == 0)
+                break;
+        }
+
+        // A rate of 1 removes the tag (it then follows its level sampling rate)
+        if (rate == 1.0)
+        {
+            if (i < gTagSamplingRateCount)
             {
-                result = sqlite3_step(gInsertStatement);
-                if (result == SQLITE_DONE)
-                    result = SQLITE_OK; // Eat this result code
-                if (result != SQLITE_OK)
-                    fprintf(SL_TERMINAL, 
-                            "At line %d in function %s, sqlite3_step failed with result %d.\n", 
-                            __LINE__, __FUNCTION__, result);
+                gTagSamplingRateCount--;
+                gTagSamplingRates[i] = gTagSamplingRates[gTagSamplingRateCount];
             }
+        }
+        else if (i < gTagSamplingRateCount)
+            gTagSamplingRates[i].rate = rate;
+        else if (gTagSamplingRateCount < SL_MAX_SAMPLED_TAGS)
+        {
+            memset((void*)gTagSamplingRates[i].tag, 0, SL_TAG_STRING_LENGTH);
+            strncpy(gTagSamplingRates[i].tag, tag, SL_TAG_STRING_LENGTH - 1);
+            gTagSamplingRates[i].rate = rate;
+            gTagSamplingRateCount++;
+        }
+        else
+        {
+            result = ENOSPC;
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, SL_SetTagSamplingRate can't track more than %d tags.\n",
+                    __LINE__, __FUNCTION__, SL_MAX_SAMPLED_TAGS);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetCompressionThreshold
+// =================================================================================================
+int32_t SL_SetCompressionThreshold (uint32_t threshold)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Views depend on this, so it has to be set before initialization
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_RESULT_ALREADY_INITIALIZED;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, calling SL_SetCompressionThreshold after SL_Initialize.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else
+        gCompressionThreshold = threshold;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetDictionaryCompression
+// =================================================================================================
+int32_t SL_SetDictionaryCompression (bool enable)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Views and the dictionary table depend on this, so it has to be set before initialization
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_RESULT_ALREADY_INITIALIZED;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, calling SL_SetDictionaryCompression after SL_Initialize.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else
+        gDictionaryCompression = enable;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetRollups
+// =================================================================================================
+int32_t SL_SetRollups (bool enable)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // The rollups table has to count every entry of a session, so it's set before initialization
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_RESULT_ALREADY_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_SetRollups after SL_Initialize.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else
+        gRollups = enable;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetPreallocatedMemory
+// =================================================================================================
+int32_t SL_SetPreallocatedMemory (uint64_t budget, bool useHeap)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // SQLite can only be configured before it's initialized
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_RESULT_ALREADY_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_SetPreallocatedMemory after SL_Initialize.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if ((budget != 0) && ((budget < SL_MINIMUM_MEMORY_BUDGET) || (budget > SL_MAXIMUM_MEMORY_BUDGET)))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_SetPreallocatedMemory argument 'budget' with value %llu is invalid.\n",
+                __LINE__, __FUNCTION__, (unsigned long long)budget);
+    }
+    else
+    {
+        gMemoryBudget = budget;
+        gMemoryHeap = useHeap;
+    }
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetMemoryLimit
+// =================================================================================================
+int32_t SL_SetMemoryLimit (uint64_t limit)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // The limit is checked against the buffers and the memory budget by SL_Initialize
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_RESULT_ALREADY_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_SetMemoryLimit after SL_Initialize.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if ((limit != 0) && (limit < SL_MINIMUM_MEMORY_LIMIT))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_SetMemoryLimit argument 'limit' with value %llu is invalid.\n",
+                __LINE__, __FUNCTION__, (unsigned long long)limit);
+    }
+    else
+        gMemoryLimit = limit;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetAsyncWrites
+// =================================================================================================
+int32_t SL_SetAsyncWrites (bool enable)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // The log file is opened with or without io_uring, so it has to be set before initialization
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_RESULT_ALREADY_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_SetAsyncWrites after SL_Initialize.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else
+        gAsyncWrites = enable;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetMemoryMapSize
+// =================================================================================================
+int32_t SL_SetMemoryMapSize (uint64_t size)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Connections opened from now on use the new size, and so does the logger's own connection
+    gMemoryMapSize = size;
+    SL_SetExportMemoryMapSize(size);
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_SetDatabaseMemoryMapSize(gSQLiteDatabase, size);
+        if (result != SQLITE_OK)
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, SL_SetDatabaseMemoryMapSize failed with result %d.\n",
+                    __LINE__, __FUNCTION__, result);
+    }
 
-            // Reset the statement
-            if (result == SQLITE_OK)
-            {
-                result = sqlite3_reset(gInsertStatement);
-                if (result != SQLITE_OK)
-                    fprintf(SL_TERMINAL, 
-                            "At line %d in function %s, sqlite3_reset failed with result %d.\n", 
-                            __LINE__, __FUNCTION__, result);
-            }
+    return result;
+}
 
-            // If there was an error, break
-            if (result != SQLITE_OK)
-                break;
-        }
+// =================================================================================================
+//  SL_SetChunkSize
+// =================================================================================================
+int32_t SL_SetChunkSize (uint32_t size)
+{
+    int32_t result = SL_RESULT_SUCCESS;
 
-        // End (commit) the transaction
-        if (result == SQLITE_OK)
+    // Check argument
+    if (size > SL_MAXIMUM_CHUNK_SIZE)
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_SetChunkSize argument 'size' with value %u is invalid.\n",
+                __LINE__, __FUNCTION__, size);
+    }
+    else
+    {
+        // The log file uses the new size from its next growth on
+        gChunkSize = size;
+        if (gSQLiteDatabase != NULL)
         {
-            result = sqlite3_exec(gSQLiteDatabase, "END TRANSACTION;", 
-                                  NULL, NULL, &errMsg);
+            int chunkSize = (int)size;
+
+            result = sqlite3_file_control(gSQLiteDatabase, "main", SQLITE_FCNTL_CHUNK_SIZE, (void*)&chunkSize);
             if (result != SQLITE_OK)
-                fprintf(SL_TERMINAL, 
-                        "At line %d in function %s, sqlite3_exec failed with result %d.\n", 
+                fprintf(SL_TERMINAL,
+                        "At line %d in function %s, sqlite3_file_control failed with result %d.\n",
                         __LINE__, __FUNCTION__, result);
         }
-        else    // Rollback the transaction
-        {
-            (void)sqlite3_exec(gSQLiteDatabase, "ROLLBACK;", 
-                               NULL, NULL, &errMsg);
-        }
     }
-    else    // sqlite3_exec failed
-        fprintf(SL_TERMINAL, 
-                "At line %d in function %s, sqlite3_exec failed with result %d.\n", 
-                __LINE__, __FUNCTION__, result);
 
-    // Clean up
-    if (errMsg != NULL)
-        sqlite3_free((void*)errMsg);
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetWALCheckpointing
+// =================================================================================================
+int32_t SL_SetWALCheckpointing (uint32_t interval, uint32_t pageThreshold)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // The journal mode is set when the log file is opened, so it has to be set before
+    // initialization
+    if (gSQLiteDatabase != NULL)
+    {
+        result = SL_RESULT_ALREADY_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_SetWALCheckpointing after SL_Initialize.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else
+    {
+        gCheckpointInterval = interval;
+        gCheckpointPageThreshold = pageThreshold;
+    }
 
     return result;
 }
 
 // =================================================================================================
-//  SL_Initialize
+//  SL_GetCheckpointStats
 // =================================================================================================
-int32_t SL_Initialize (const char* path)
+int32_t SL_GetCheckpointStats (tSL_CheckpointStats* stats)
 {
     int32_t result = SL_RESULT_SUCCESS;
 
-    // Check arguments
-    if (path == NULL)
+    // Check argument
+    if (stats == NULL)
     {
         result = EFAULT;
-        fprintf(SL_TERMINAL, 
-                "At line %d in function %s, SL_Initialize argument 'path' is NULL.\n",
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_GetCheckpointStats argument 'stats' is NULL.\n",
                 __LINE__, __FUNCTION__);
     }
-    else if (strlen(path) == 0)
+    else if (gSQLiteDatabase == NULL)
     {
-        result = EINVAL;
-        fprintf(SL_TERMINAL, 
-                "At line %d in function %s, SL_Initialize argument 'path' is empty.\n",
+        result = SL_RESULT_NOT_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_GetCheckpointStats when SQLite Logger not initialized.\n",
                 __LINE__, __FUNCTION__);
     }
+    else
+        SL_GetCheckpointerStats(stats);
 
-    // Check status
-    if (result == SL_RESULT_SUCCESS)
+    return result;
+}
+
+// =================================================================================================
+//  SL_ArchiveClosedLogs
+// =================================================================================================
+int32_t SL_ArchiveClosedLogs (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    sqlite3_stmt* statement = NULL;
+    char tableName[SL_TIMESTAMP_STRING_LENGTH + 8] = {0};
+
+    // Make sure we're initialized
+    if (gSQLiteDatabase == NULL)
     {
-        // Make sure we're not already initialized
-        if (gSQLiteDatabase != NULL)
-        {
-            result = SL_RESULT_ALREADY_INITIALIZED;
-            fprintf(SL_TERMINAL, 
-                    "At line %d in function %s, calling SL_Initialize more than once.\n",
-                    __LINE__, __FUNCTION__);
-        }
+        result = SL_RESULT_NOT_INITIALIZED;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, calling SL_ArchiveClosedLogs when SQLite Logger not initialized.\n",
+                __LINE__, __FUNCTION__);
     }
-
-    // Check status
-    if (result == SL_RESULT_SUCCESS)
+    else
     {
-        // Initialize SQLite
-        result = sqlite3_open_v2(path, &gSQLiteDatabase, 
-                                 SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+        // Everything but the current session's table is closed
+        snprintf(tableName, sizeof(tableName), "log at %s", gLogTimestamp);
+        result = SL_GetStatement(eSL_Statement_SelectClosedLogTable, &statement);
         if (result == SQLITE_OK)
         {
-            // Create the logging table
-            result = SL_CreateTable();
-            if (result == SL_RESULT_SUCCESS)
-            {
-                // Create the views
-                result = SL_CreateView(kSL_CreateDiagnosticMessageViewCommandString);
-                if (result == SL_RESULT_SUCCESS)
-                {
-                    result = SL_CreateView(kSL_CreateDetailMessageViewCommandString);
-                    if (result == SL_RESULT_SUCCESS)
-                    {
-                        result = SL_CreateView(kSL_CreateInfoMessageViewCommandString);
-                        if (result == SL_RESULT_SUCCESS)
-                        {
-                            result = SL_CreateView(kSL_CreateWarningMessageViewCommandString);
-                            if (result == SL_RESULT_SUCCESS)
-                                result = SL_CreateView(kSL_CreateErrorMessageViewCommandString);
-                        }
-                    }
-                }
-
-                // Check status
-                if (result == SL_RESULT_SUCCESS)
-                {
-                    char cmdString[1024] = {0};
+            result = sqlite3_bind_text(statement, 1, tableName, -1, SQLITE_TRANSIENT);
+            if (result != SQLITE_OK)
+                fprintf(SL_TERMINAL,
+                        "At line %d in function %s, sqlite3_bind_text failed with result %d.\n",
+                        __LINE__, __FUNCTION__, result);
+        }
 
-                    // Initialize log entry list
-                    memset((void*)gLogEntries, 0, sizeof(tSL_LogEntry) * SL_LOG_ENTRY_CACHE_SIZE);
+        // Archived tables become views, so keep going until there are no closed tables left
+        while ((result == SQLITE_OK) && (sqlite3_step(statement) == SQLITE_ROW))
+        {
+            char* closedTableName = sqlite3_mprintf("%s", (const char*)sqlite3_column_text(statement, 0));
 
-                    // Initialize the prepared statement for inserts
-                    memset((void*)cmdString, 0, 1024);
-                    sprintf(cmdString, kSL_ParameterizedInsertSQLCommandString, gLogTimestamp);
-                    result = sqlite3_prepare_v2(gSQLiteDatabase,
-                                                cmdString, strlen(cmdString),
-                                                &gInsertStatement, NULL);
-                    if (result != SQLITE_OK)
-                        fprintf(SL_TERMINAL, 
-                                "At line %d in function %s, sqlite_prepare_v2 failed with result %d.\n", 
-                                __LINE__, __FUNCTION__, result);
-                }
-            }
+            (void)sqlite3_reset(statement);
+            result = (closedTableName == NULL) ? SQLITE_NOMEM :
+                SL_ArchiveLogTable(gSQLiteDatabase, closedTableName);
+            sqlite3_free((void*)closedTableName);
         }
-        else    // sqlite3_open_v2 failed
-            fprintf(SL_TERMINAL, 
-                    "At line %d in function %s, sqlite3_open_v2 failed with result %d.\n", 
-                    __LINE__, __FUNCTION__, result);
+        if (statement != NULL)
+            (void)sqlite3_reset(statement);
     }
     return result;
 }
 
 // =================================================================================================
-//  SL_Terminate
+//  SL_Query
 // =================================================================================================
-int32_t SL_Terminate (void)
+int32_t SL_Query (const char* sql, tSL_QueryCallback callback, void* context)
 {
     int32_t result = SL_RESULT_SUCCESS;
+    char* errMsg = NULL;
 
-    // Make sure we're initialized
-    if (gSQLiteDatabase != NULL)
+    // Check arguments
+    if (sql == NULL)
     {
-        // Make sure there aren't any uncommitted log entries
-        if (gLogEntryCount > 0)
-        {
-            result = SL_ProcessTransaction();
-            if (result == SL_RESULT_SUCCESS)
-            {
-                gLogEntryCount = 0;
-
-                // Initialize log entry list
-                memset((void*)gLogEntries, 0, sizeof(tSL_LogEntry) * SL_LOG_ENTRY_CACHE_SIZE);
-            }
-        }
-
-        // Finalize (free) the insert prepared statement
-        if (gInsertStatement != NULL)
-        {
-            (void)sqlite3_finalize(gInsertStatement);
-            gInsertStatement = NULL;
-        }
-
-        // Close the database
-        (void)sqlite3_close_v2(gSQLiteDatabase);
-        gSQLiteDatabase = NULL;
+        result = EFAULT;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_Query argument 'sql' is NULL.\n",
+                __LINE__, __FUNCTION__);
     }
-    else
+    else if (gSQLiteDatabase == NULL)
     {
         result = SL_RESULT_NOT_INITIALIZED;
         fprintf(SL_TERMINAL, 
-                "At line %d in function %s, calling SL_Terminate when SQLite Logger not initialized.\n",
+                "At line %d in function %s, calling SL_Query when SQLite Logger not initialized.\n",
                 __LINE__, __FUNCTION__);
     }
+    else
+    {
+        result = sqlite3_exec(gSQLiteDatabase, sql, callback, context, &errMsg);
+        if ((result != SQLITE_OK) && (result != SQLITE_ABORT))
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, sqlite3_exec failed with result %d (%s).\n", 
+                    __LINE__, __FUNCTION__, result, (errMsg != NULL) ? errMsg : "");
+        if (errMsg != NULL)
+            sqlite3_free((void*)errMsg);
+    }
     return result;
 }
 
 // =================================================================================================
-//  SL_SetLogLevel
+//  SL_Subscribe
 // =================================================================================================
-int32_t SL_SetLogLevel (tSL_LogLevel level)
+int32_t SL_Subscribe (const tSL_SubscriptionFilter* filter, 
+                      tSL_SubscriptionCallback callback, 
+                      void* context, 
+                      uint32_t* subscriptionId)
 {
     int32_t result = SL_RESULT_SUCCESS;
+    uint_fast32_t i = 0;
 
-    // Check argument
-    if ((level >= eSL_LogLevel_Diagnostic) && (level <= eSL_LogLevel_None))
-        gLogLevel = level;
-    else
+    // Check arguments
+    if ((filter == NULL) || (callback == NULL) || (subscriptionId == NULL))
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL, 
+                "At line %d in function %s, SL_Subscribe has a NULL argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if ((filter->level < eSL_LogLevel_Diagnostic) || (filter->level > eSL_LogLevel_None))
     {
         result = EINVAL;
         fprintf(SL_TERMINAL, 
-                "At line %d in function %s, SL_SetLogLevel argument 'level' with value %d is invalid.\n",
-                __LINE__, __FUNCTION__, (int32_t)level);
+                "At line %d in function %s, SL_Subscribe filter level with value %d is invalid.\n",
+                __LINE__, __FUNCTION__, (int32_t)filter->level);
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        result = ENOSPC;
+        for (i = 0; i < SL_MAX_SUBSCRIPTIONS; i++)
+        {
+            tSL_Subscription* subscription = &(gSubscriptions[i]);
+            uint32_t status = __atomic_load_n(&(subscription->status), __ATOMIC_ACQUIRE);
+            uint32_t generation = ((status >> SL_SUBSCRIPTION_GENERATION_SHIFT) + 1) % SL_SUBSCRIPTION_GENERATION_COUNT;
+
+            // Claim a free slot for the next generation, fill it in, then publish it; ids encode
+            // the slot and the generation, so stale ids don't match a reused slot
+            if (((status & SL_SUBSCRIPTION_STATE_MASK) == SL_SUBSCRIPTION_FREE) &&
+                __atomic_compare_exchange_n(&(subscription->status), &status,
+                                            SL_SUBSCRIPTION_STATUS(generation, SL_SUBSCRIPTION_CLAIMED),
+                                            false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            {
+                subscription->level = filter->level;
+                subscription->hasTag = (filter->tag != NULL);
+                memset((void*)subscription->tag, 0, SL_TAG_STRING_LENGTH);
+                if (filter->tag != NULL)
+                    strncpy(subscription->tag, filter->tag, SL_TAG_STRING_LENGTH - 1);
+                subscription->onWrite = filter->onWrite;
+                subscription->callback = callback;
+                subscription->context = context;
+
+                *subscriptionId = (generation * SL_MAX_SUBSCRIPTIONS) + (uint32_t)i;
+                __atomic_store_n(&(subscription->status),
+                                 SL_SUBSCRIPTION_STATUS(generation, SL_SUBSCRIPTION_ACTIVE), __ATOMIC_RELEASE);
+                __atomic_add_fetch(&gSubscriptionCount, 1, __ATOMIC_SEQ_CST);
+                result = SL_RESULT_SUCCESS;
+                break;
+            }
+        }
+        if (result == ENOSPC)
+            fprintf(SL_TERMINAL, 
+                    "At line %d in function %s, SL_Subscribe can't have more than %d subscriptions.\n",
+                    __LINE__, __FUNCTION__, SL_MAX_SUBSCRIPTIONS);
     }
     return result;
 }
 
 // =================================================================================================
-//  SL_GetLogLevel
+//  SL_Unsubscribe
 // =================================================================================================
-int32_t SL_GetLogLevel (tSL_LogLevel* level)
+int32_t SL_Unsubscribe (uint32_t subscriptionId)
 {
     int32_t result = SL_RESULT_SUCCESS;
-
-    // Check argument
-    if (level == NULL)
+    tSL_Subscription* subscription = &(gSubscriptions[subscriptionId % SL_MAX_SUBSCRIPTIONS]);
+    uint32_t generation = subscriptionId / SL_MAX_SUBSCRIPTIONS;
+    uint32_t expected = SL_SUBSCRIPTION_STATUS(generation, SL_SUBSCRIPTION_ACTIVE);
+
+    // Take the subscription out of service, if the slot still has it (the generation and state
+    // are compared and changed together, so the slot can't be reused in between)
+    if (!__atomic_compare_exchange_n(&(subscription->status), &expected,
+                                     SL_SUBSCRIPTION_STATUS(generation, SL_SUBSCRIPTION_CLAIMED),
+                                     false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
     {
-        result = EFAULT;
+        result = ENOENT;
         fprintf(SL_TERMINAL, 
-                "At line %d in function %s, SL_GetLogLevel argument 'level' is NULL.\n",
-                __LINE__, __FUNCTION__);
+                "At line %d in function %s, SL_Unsubscribe subscription %u doesn't exist.\n",
+                __LINE__, __FUNCTION__, subscriptionId);
+    }
+    else
+    {
+        __atomic_sub_fetch(&gSubscriptionCount, 1, __ATOMIC_SEQ_CST);
+
+        // A callback unsubscribing itself is one of the readers that would be waited for, so its
+        // slot is freed once it returns
+        if (subscription == gDeliveringSubscription)
+            gDeliveringUnsubscribed = true;
+        else
+            SL_FreeSubscription(subscription);
     }
-    
-    // Check status
-    if (result == SL_RESULT_SUCCESS)
-        *level = gLogLevel;
-
     return result;
 }
 
 // =================================================================================================
-//  SL_Log
+//  SL_Import
 // =================================================================================================
-int32_t SL_Log (const char* message,
-                tSL_LogLevel level,
-                const char* fileName,
-                const char* functionName,
-                uint32_t lineNumber,
-                const char* tag,
-                const char* supplementalData)
+int32_t SL_Import (const char* inputPath, const tSL_ImportOptions* options, uint64_t* entryCount)
 {
     int32_t result = SL_RESULT_SUCCESS;
+    char importTimestamp[SL_TIMESTAMP_STRING_LENGTH] = {0};
+    char* cmdString = NULL;
+    sqlite3_stmt* importStatement = NULL;
+    sqlite3_stmt* sessionStatement = gInsertStatement;
+    tSL_ImportReader* reader = NULL;
+    const tSL_ImportRecord* records = NULL;
+    uint32_t recordCount = 0;
+    uint32_t batchCount = 0;
+    uint64_t importedCount = 0;
+    uint_fast32_t i = 0;
 
     // Check arguments
-    if (message == NULL)
+    if ((inputPath == NULL) || (options == NULL))
     {
         result = EFAULT;
-        fprintf(SL_TERMINAL, 
-                "At line %d in function %s, SL_Log argument 'message' is NULL.\n",
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_Import has a NULL argument.\n",
                 __LINE__, __FUNCTION__);
     }
-    else if (strlen(message) == 0)
+    else if ((options->format != eSL_ImportFormat_Text) && (options->format != eSL_ImportFormat_NDJSON))
     {
         result = EINVAL;
         fprintf(SL_TERMINAL,
-                "At line %d in function %s, SL_Log argument 'message' is empty.\n",
-                __LINE__, __FUNCTION__);
+                "At line %d in function %s, import format %d is invalid.\n",
+                __LINE__, __FUNCTION__, (int32_t)options->format);
     }
-
-    if ((level < eSL_LogLevel_Diagnostic) || (level > eSL_LogLevel_None))
+    else if (gSQLiteDatabase == NULL)
     {
-        result = EINVAL;
-        fprintf(SL_TERMINAL, 
-                "At line %d in function %s, SL_Log argument 'level' with value %d is invalid.\n",
-                __LINE__, __FUNCTION__, (int32_t)level);
+        result = SL_RESULT_NOT_INITIALIZED;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, calling SL_Import when SQLite Logger not initialized.\n",
+                __LINE__, __FUNCTION__);
     }
 
-    // Check status
+    // Write the entries logged so far, so they stay in the current log table
+    if ((result == SL_RESULT_SUCCESS) && (gLogEntryCount > 0))
+        result = SL_WriteBatch();
+
+    // Create a log table (and views) for the imported entries, and start parsing
     if (result == SL_RESULT_SUCCESS)
     {
-        // Make sure we're initialized
-        if (gSQLiteDatabase == NULL)
+        (void)SL_GetTimestamp(importTimestamp);
+        memcpy((void*)gImportTimestamp, (void*)importTimestamp, SL_TIMESTAMP_STRING_LENGTH);
+        result = SL_CreateTable(importTimestamp);
+        if (result == SL_RESULT_SUCCESS)
+            result = SL_CreateViews(importTimestamp);
+        if (result == SL_RESULT_SUCCESS)
         {
-            result = SL_RESULT_NOT_INITIALIZED;
-            fprintf(SL_TERMINAL, 
-                    "At line %d in function %s, SQLite Logger is not initialized.\n",
-                    __LINE__, __FUNCTION__);
+            cmdString = sqlite3_mprintf(kSL_ParameterizedInsertSQLCommandString, importTimestamp);
+            result = (cmdString == NULL) ? SQLITE_NOMEM :
+                sqlite3_prepare_v2(gSQLiteDatabase, cmdString, -1, &importStatement, NULL);
+            if (result != SQLITE_OK)
+                fprintf(SL_TERMINAL,
+                        "At line %d in function %s, sqlite3_prepare_v2 failed with result %d.\n",
+                        __LINE__, __FUNCTION__, result);
+            sqlite3_free((void*)cmdString);
         }
+        if (result == SL_RESULT_SUCCESS)
+            result = SL_OpenImportReader(inputPath, options->format, options->threadCount, &reader);
     }
 
-    // Check status
+    // Write the parsed entries in batches, through the insert statement of the new table
     if (result == SL_RESULT_SUCCESS)
     {
-        // Check log level
-        if (level >= gLogLevel)
+        gInsertStatement = importStatement;
+        gImporting = true;
+        while ((result == SL_RESULT_SUCCESS) &&
+               ((result = SL_ReadImportBlock(reader, &records, &recordCount)) == SL_RESULT_SUCCESS))
         {
-            if (gLogEntryCount < (SL_LOG_ENTRY_CACHE_SIZE - 1))
-            {
-                // Add a new log entry
-                result = SL_AddLogEntry(message, level, fileName, functionName,
-                                        lineNumber, tag, supplementalData);
-            }
-            else
+            for (i = 0; (i < recordCount) && (result == SL_RESULT_SUCCESS); i++)
             {
-                // Process a transaction
-                result = SL_ProcessTransaction();
-                if (result == SL_RESULT_SUCCESS)
+                result = SL_AddImportedLogEntry(&(records[i]));
+                if ((result == SL_RESULT_SUCCESS) && (gLogEntryCount == (SL_LOG_ENTRY_CACHE_SIZE - 1)))
                 {
-                    gLogEntryCount = 0;
-
-                    // Initialize log entry list
-                    memset((void*)gLogEntries, 0, sizeof(tSL_LogEntry) * SL_LOG_ENTRY_CACHE_SIZE);
-
-                    // Add a new log entry
-                    result = SL_AddLogEntry(message, level, fileName, functionName,
-                                            lineNumber, tag, supplementalData);
+                    batchCount = gLogEntryCount;
+                    result = SL_WriteBatch();
+                    if (result == SL_RESULT_SUCCESS)
+                        importedCount += batchCount;
                 }
             }
         }
+        if (result == ENODATA)
+            result = SL_RESULT_SUCCESS; // Eat this result code
+        if ((result == SL_RESULT_SUCCESS) && (gLogEntryCount > 0))
+        {
+            batchCount = gLogEntryCount;
+            result = SL_WriteBatch();
+            if (result == SL_RESULT_SUCCESS)
+                importedCount += batchCount;
+        }
+
+        // Imported entries that weren't written (when the import failed) are dropped, rather than
+        // written to the session
+        if (gLogEntryCount > 0)
+        {
+            gLogEntryCount = 0;
+            gBatchNumber++;
+            memset((void*)gLogEntries, 0, sizeof(tSL_LogEntry) * SL_LOG_ENTRY_CACHE_SIZE);
+        }
+        gImporting = false;
+        gInsertStatement = sessionStatement;
+
+        if (SL_GetImportSkippedLineCount(reader) > 0)
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, skipped %llu lines of %s that couldn't be parsed.\n",
+                    __LINE__, __FUNCTION__,
+                    (unsigned long long)SL_GetImportSkippedLineCount(reader), inputPath);
     }
+    SL_CloseImportReader(reader);
+    if (importStatement != NULL)
+        (void)sqlite3_finalize(importStatement);
+
+    if (entryCount != NULL)
+        *entryCount = importedCount;
+
     return result;
 }
 
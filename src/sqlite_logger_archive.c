@@ -0,0 +1,960 @@
+// =================================================================================================
+//! @file sqlite_logger_archive.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the implementation of the SQLite Logger columnar archive.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-14
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sqlite_logger_archive.h"
+#include "sqlite_logger_compression.h"
+#include <string.h>
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Where to direct fprintf output
+#define SL_TERMINAL                 stderr
+
+//  Archived columns (the hidden table name column follows them)
+#define SL_ARCHIVE_COLUMN_COUNT     SL_LOG_COLUMN_COUNT
+#define SL_ARCHIVE_TABLE_COLUMN     SL_ARCHIVE_COLUMN_COUNT
+
+//  Initial size of a column chunk buffer
+#define SL_ARCHIVE_BUFFER_SIZE      4096
+
+//  Names of archived columns, in log table order
+static const char* kSL_ArchiveColumnNames[SL_ARCHIVE_COLUMN_COUNT] = {
+    "log_id",
+    "log_timestamp",
+    "log_message",
+    "log_level",
+    "log_filename",
+    "log_functionname",
+    "log_linenumber",
+    "log_tag",
+    "log_supplementaldata",
+    "log_repeat_count",
+    "log_last_timestamp",
+    "log_sample_rate",
+    "log_dictionary_id",
+};
+
+//  Columns that may hold compressed values in a log table
+#define SL_ARCHIVE_MESSAGE_COLUMN               2
+#define SL_ARCHIVE_SUPPLEMENTAL_DATA_COLUMN     8
+
+//  Schema of the sl_archive table-valued function
+static const char* kSL_ArchiveSchemaString =
+    "CREATE TABLE x(log_id INTEGER, log_timestamp TEXT, log_message TEXT, log_level TEXT, log_filename TEXT, log_functionname TEXT, log_linenumber INTEGER, log_tag TEXT, log_supplementaldata TEXT, log_repeat_count INTEGER, log_last_timestamp TEXT, log_sample_rate REAL, log_dictionary_id INTEGER, archive_table HIDDEN)";
+
+//  SQL command to create archive table
+static const char* kSL_CreateArchiveTableSQLCommandString =
+    "CREATE TABLE IF NOT EXISTS `" SL_ARCHIVE_TABLE_NAME "` (`archive_table` TEXT NOT NULL, `archive_column` INTEGER NOT NULL, `archive_chunk` INTEGER NOT NULL, `archive_row_count` INTEGER NOT NULL, `archive_data` BLOB NOT NULL, PRIMARY KEY (`archive_table`, `archive_column`, `archive_chunk`)) WITHOUT ROWID";
+
+//  SQL command to remove a table from the archive
+static const char* kSL_DeleteArchiveSQLCommandString =
+    "DELETE FROM `" SL_ARCHIVE_TABLE_NAME "` WHERE archive_table = ?";
+
+//  SQL command to insert a column chunk
+static const char* kSL_InsertArchiveChunkSQLCommandString =
+    "INSERT INTO `" SL_ARCHIVE_TABLE_NAME "` (archive_table,archive_column,archive_chunk,archive_row_count,archive_data) VALUES(?,?,?,?,?)";
+
+//  SQL command to list the columns of a log table
+static const char* kSL_SelectTableColumnsSQLCommandString =
+    "SELECT name FROM pragma_table_info(?)";
+
+//  SQL command to list the chunks of an archived table
+static const char* kSL_SelectArchiveChunksSQLCommandString =
+    "SELECT archive_chunk, archive_row_count FROM `" SL_ARCHIVE_TABLE_NAME "` WHERE archive_table = ?1 AND archive_column = 0 ORDER BY archive_chunk";
+
+//  SQL command to read a column chunk
+static const char* kSL_SelectArchiveChunkSQLCommandString =
+    "SELECT archive_data FROM `" SL_ARCHIVE_TABLE_NAME "` WHERE archive_table = ?1 AND archive_column = ?2 AND archive_chunk = ?3";
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+//  Column chunk being written
+typedef struct tsl_archivebuffer
+{
+    uint8_t*    data;
+    size_t      size;
+    size_t      capacity;
+    int64_t     lastInteger;
+}
+tSL_ArchiveBuffer;
+
+//  Column chunk being read
+typedef struct tsl_archivecolumn
+{
+    char*           data;
+    size_t          size;
+    size_t          position;
+    int             type;
+    int64_t         integer;
+    double          real;
+    const uint8_t*  bytes;
+    size_t          length;
+}
+tSL_ArchiveColumn;
+
+//  sl_archive virtual table
+typedef struct tsl_archivetable
+{
+    sqlite3_vtab    base;
+    sqlite3*        database;
+}
+tSL_ArchiveTable;
+
+//  sl_archive cursor
+typedef struct tsl_archivecursor
+{
+    sqlite3_vtab_cursor     base;
+    sqlite3_stmt*           chunkStatement;
+    sqlite3_stmt*           columnStatement;
+    char*                   tableName;
+    uint32_t                columnsUsed;
+    int64_t                 chunk;
+    uint32_t                rowCount;
+    uint32_t                row;
+    sqlite3_int64           rowid;
+    bool                    eof;
+    tSL_ArchiveColumn       columns[SL_ARCHIVE_COLUMN_COUNT];
+}
+tSL_ArchiveCursor;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+static int32_t SL_AppendBytes (tSL_ArchiveBuffer* buffer, const void* bytes, size_t size);
+
+static int32_t SL_AppendValue (tSL_ArchiveBuffer* buffer, sqlite3_stmt* statement, int column);
+
+static int32_t SL_WriteArchiveChunk (sqlite3_stmt* statement,
+                                     int64_t chunk,
+                                     uint32_t rowCount,
+                                     tSL_ArchiveBuffer* buffers);
+
+static int32_t SL_WriteArchive (sqlite3* database, const char* tableName);
+
+static int32_t SL_ReadArchiveValue (tSL_ArchiveColumn* column);
+
+static int32_t SL_LoadArchiveChunk (tSL_ArchiveCursor* cursor);
+
+static int32_t SL_ReadArchiveRow (tSL_ArchiveCursor* cursor);
+
+static void SL_ResetArchiveCursor (tSL_ArchiveCursor* cursor);
+
+static int SL_ArchiveConnect (sqlite3* database,
+                              void* aux,
+                              int argc,
+                              const char* const* argv,
+                              sqlite3_vtab** vtab,
+                              char** errMsg);
+
+static int SL_ArchiveBestIndex (sqlite3_vtab* vtab, sqlite3_index_info* indexInfo);
+
+static int SL_ArchiveDisconnect (sqlite3_vtab* vtab);
+
+static int SL_ArchiveOpen (sqlite3_vtab* vtab, sqlite3_vtab_cursor** cursor);
+
+static int SL_ArchiveClose (sqlite3_vtab_cursor* cursor);
+
+static int SL_ArchiveFilter (sqlite3_vtab_cursor* cursor,
+                             int indexNumber,
+                             const char* indexString,
+                             int argc,
+                             sqlite3_value** argv);
+
+static int SL_ArchiveNext (sqlite3_vtab_cursor* cursor);
+
+static int SL_ArchiveEof (sqlite3_vtab_cursor* cursor);
+
+static int SL_ArchiveColumnValue (sqlite3_vtab_cursor* cursor, sqlite3_context* context, int column);
+
+static int SL_ArchiveRowid (sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid);
+
+// =================================================================================================
+//  Private globals
+// =================================================================================================
+
+//  sl_archive module (eponymous only, so there's no xCreate or xDestroy)
+static sqlite3_module gSL_ArchiveModule = {
+    0,                      // iVersion
+    NULL,                   // xCreate
+    SL_ArchiveConnect,      // xConnect
+    SL_ArchiveBestIndex,    // xBestIndex
+    SL_ArchiveDisconnect,   // xDisconnect
+    NULL,                   // xDestroy
+    SL_ArchiveOpen,         // xOpen
+    SL_ArchiveClose,        // xClose
+    SL_ArchiveFilter,       // xFilter
+    SL_ArchiveNext,         // xNext
+    SL_ArchiveEof,          // xEof
+    SL_ArchiveColumnValue,  // xColumn
+    SL_ArchiveRowid,        // xRowid
+    NULL,                   // xUpdate
+    NULL,                   // xBegin
+    NULL,                   // xSync
+    NULL,                   // xCommit
+    NULL,                   // xRollback
+    NULL,                   // xFindFunction
+    NULL,                   // xRename
+    NULL,                   // xSavepoint
+    NULL,                   // xRelease
+    NULL,                   // xRollbackTo
+    NULL,                   // xShadowName
+};
+
+// =================================================================================================
+//  SL_AppendBytes
+// =================================================================================================
+int32_t SL_AppendBytes (tSL_ArchiveBuffer* buffer, const void* bytes, size_t size)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Grow the buffer if necessary
+    if ((buffer->size + size) > buffer->capacity)
+    {
+        size_t capacity = (buffer->capacity == 0) ? SL_ARCHIVE_BUFFER_SIZE : buffer->capacity;
+        uint8_t* data = NULL;
+
+        while (capacity < (buffer->size + size))
+            capacity *= 2;
+        data = (uint8_t*)sqlite3_realloc64((void*)buffer->data, (sqlite3_uint64)capacity);
+        if (data == NULL)
+            result = ENOMEM;
+        else
+        {
+            buffer->data = data;
+            buffer->capacity = capacity;
+        }
+    }
+
+    // Append
+    if ((result == SL_RESULT_SUCCESS) && (size > 0))
+    {
+        memcpy((void*)(buffer->data + buffer->size), bytes, size);
+        buffer->size += size;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendValue
+// =================================================================================================
+int32_t SL_AppendValue (tSL_ArchiveBuffer* buffer, sqlite3_stmt* statement, int column)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint8_t header[16] = {0};
+    size_t headerSize = 0;
+    int type = sqlite3_column_type(statement, column);
+
+    // Each value is its type, followed by its data
+    header[headerSize++] = (uint8_t)type;
+    if (type == SQLITE_INTEGER)
+    {
+        // Integers are stored as zigzag encoded deltas, so ids and counts take a byte or so
+        int64_t value = sqlite3_column_int64(statement, column);
+        uint64_t delta = (uint64_t)value - (uint64_t)buffer->lastInteger;
+
+        headerSize += SL_WriteVarint(header + headerSize,
+                                     (delta << 1) ^ (uint64_t)((int64_t)delta >> 63));
+        buffer->lastInteger = value;
+        result = SL_AppendBytes(buffer, header, headerSize);
+    }
+    else if (type == SQLITE_FLOAT)
+    {
+        double value = sqlite3_column_double(statement, column);
+
+        result = SL_AppendBytes(buffer, header, headerSize);
+        if (result == SL_RESULT_SUCCESS)
+            result = SL_AppendBytes(buffer, &value, sizeof(value));
+    }
+    else if ((type == SQLITE_TEXT) || (type == SQLITE_BLOB))
+    {
+        const void* value = (type == SQLITE_TEXT) ?
+            (const void*)sqlite3_column_text(statement, column) : sqlite3_column_blob(statement, column);
+        size_t size = (size_t)sqlite3_column_bytes(statement, column);
+
+        headerSize += SL_WriteVarint(header + headerSize, (uint64_t)size);
+        result = SL_AppendBytes(buffer, header, headerSize);
+        if ((result == SL_RESULT_SUCCESS) && (size > 0))
+            result = SL_AppendBytes(buffer, value, size);
+    }
+    else    // SQLITE_NULL
+        result = SL_AppendBytes(buffer, header, headerSize);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_WriteArchiveChunk
+// =================================================================================================
+int32_t SL_WriteArchiveChunk (sqlite3_stmt* statement,
+                              int64_t chunk,
+                              uint32_t rowCount,
+                              tSL_ArchiveBuffer* buffers)
+{
+    int32_t result = SQLITE_OK;
+    uint_fast32_t i = 0;
+
+    for (i = 0; (i < SL_ARCHIVE_COLUMN_COUNT) && (result == SQLITE_OK); i++)
+    {
+        size_t capacity = SL_CompressBound(buffers[i].size);
+        size_t compressedSize = 0;
+        uint8_t* compressed = (uint8_t*)sqlite3_malloc64((sqlite3_uint64)capacity);
+
+        // Compress the column chunk
+        if (compressed == NULL)
+            result = SQLITE_NOMEM;
+        else if (SL_CompressValue(NULL, buffers[i].data, buffers[i].size,
+                                  compressed, capacity, &compressedSize) != SL_RESULT_SUCCESS)
+            result = SQLITE_ERROR;
+
+        // Store it (the table name is already bound)
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int(statement, 2, (int)i);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int64(statement, 3, chunk);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int(statement, 4, (int)rowCount);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_blob(statement, 5, compressed, (int)compressedSize, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+        {
+            result = sqlite3_step(statement);
+            if (result == SQLITE_DONE)
+                result = SQLITE_OK; // Eat this result code
+        }
+        (void)sqlite3_reset(statement);
+        sqlite3_free((void*)compressed);
+
+        // Start the next chunk
+        buffers[i].size = 0;
+        buffers[i].lastInteger = 0;
+    }
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, writing archive chunk failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_GetLogColumnName
+// =================================================================================================
+const char* SL_GetLogColumnName (uint32_t column)
+{
+    return (column < SL_ARCHIVE_COLUMN_COUNT) ? kSL_ArchiveColumnNames[column] : NULL;
+}
+
+// =================================================================================================
+//  SL_BuildLogColumnList
+// =================================================================================================
+int32_t SL_BuildLogColumnList (sqlite3* database, const char* tableName, char** columns)
+{
+    int32_t result = SQLITE_OK;
+    sqlite3_stmt* statement = NULL;
+    bool present[SL_ARCHIVE_COLUMN_COUNT] = {false};
+    uint_fast32_t i = 0;
+
+    // Find the columns the table has (tables from older versions lack the newer columns)
+    result = sqlite3_prepare_v2(database, kSL_SelectTableColumnsSQLCommandString, -1,
+                                &statement, NULL);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(statement, 1, tableName, -1, SQLITE_STATIC);
+    while ((result == SQLITE_OK) && ((result = sqlite3_step(statement)) == SQLITE_ROW))
+    {
+        const char* name = (const char*)sqlite3_column_text(statement, 0);
+
+        result = SQLITE_OK;
+        for (i = 0; (name != NULL) && (i < SL_ARCHIVE_COLUMN_COUNT); i++)
+        {
+            if (strcmp(name, kSL_ArchiveColumnNames[i]) == 0)
+                present[i] = true;
+        }
+    }
+    if (result == SQLITE_DONE)
+        result = present[0] ? SQLITE_OK : SQLITE_MISMATCH;
+    (void)sqlite3_finalize(statement);
+
+    // List the columns in log table order, with missing columns as NULL and compressed values
+    // decompressed
+    if (result == SQLITE_OK)
+    {
+        *columns = sqlite3_mprintf("");
+        for (i = 0; (i < SL_ARCHIVE_COLUMN_COUNT) && (*columns != NULL); i++)
+        {
+            const char* separator = (i == 0) ? "" : ",";
+
+            if (!present[i])
+                *columns = sqlite3_mprintf("%z%sNULL", *columns, separator);
+            else if ((i == SL_ARCHIVE_MESSAGE_COLUMN) || (i == SL_ARCHIVE_SUPPLEMENTAL_DATA_COLUMN))
+                *columns = sqlite3_mprintf("%z%s" SL_DECOMPRESS_FUNCTION_NAME "(\"%w\")",
+                                           *columns, separator, kSL_ArchiveColumnNames[i]);
+            else
+                *columns = sqlite3_mprintf("%z%s\"%w\"", *columns, separator, kSL_ArchiveColumnNames[i]);
+        }
+        if (*columns == NULL)
+            result = SQLITE_NOMEM;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ReadArchiveValue
+// =================================================================================================
+int32_t SL_ReadArchiveValue (tSL_ArchiveColumn* column)
+{
+    int32_t result = SQLITE_OK;
+    const uint8_t* data = (const uint8_t*)column->data;
+    uint64_t value = 0;
+
+    if (column->position >= column->size)
+        result = SQLITE_CORRUPT;
+    else
+    {
+        column->type = data[column->position++];
+        if (column->type == SQLITE_INTEGER)
+        {
+            if (SL_ReadVarint(data, column->size, &(column->position), &value) != SL_RESULT_SUCCESS)
+                result = SQLITE_CORRUPT;
+            else
+                column->integer = (int64_t)((uint64_t)column->integer +
+                                            ((value >> 1) ^ (~(value & 1) + 1)));
+        }
+        else if (column->type == SQLITE_FLOAT)
+        {
+            if ((column->size - column->position) < sizeof(double))
+                result = SQLITE_CORRUPT;
+            else
+            {
+                memcpy((void*)&(column->real), (const void*)(data + column->position), sizeof(double));
+                column->position += sizeof(double);
+            }
+        }
+        else if ((column->type == SQLITE_TEXT) || (column->type == SQLITE_BLOB))
+        {
+            if ((SL_ReadVarint(data, column->size, &(column->position), &value) != SL_RESULT_SUCCESS) ||
+                (value > (column->size - column->position)))
+                result = SQLITE_CORRUPT;
+            else
+            {
+                column->bytes = data + column->position;
+                column->length = (size_t)value;
+                column->position += (size_t)value;
+            }
+        }
+        else if (column->type != SQLITE_NULL)
+            result = SQLITE_CORRUPT;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_LoadArchiveChunk
+// =================================================================================================
+int32_t SL_LoadArchiveChunk (tSL_ArchiveCursor* cursor)
+{
+    int32_t result = SQLITE_OK;
+    uint_fast32_t i = 0;
+
+    // Find the next chunk (skipping any empty ones)
+    cursor->row = 0;
+    cursor->rowCount = 0;
+    while ((result == SQLITE_OK) && !cursor->eof && (cursor->rowCount == 0))
+    {
+        result = sqlite3_step(cursor->chunkStatement);
+        if (result == SQLITE_ROW)
+        {
+            cursor->chunk = sqlite3_column_int64(cursor->chunkStatement, 0);
+            cursor->rowCount = (uint32_t)sqlite3_column_int(cursor->chunkStatement, 1);
+            result = SQLITE_OK;
+        }
+        else if (result == SQLITE_DONE)
+        {
+            cursor->eof = true;
+            result = SQLITE_OK;
+        }
+    }
+
+    // Load only the columns the query uses
+    for (i = 0; (i < SL_ARCHIVE_COLUMN_COUNT) && (result == SQLITE_OK) && !cursor->eof; i++)
+    {
+        tSL_ArchiveColumn* column = &(cursor->columns[i]);
+
+        sqlite3_free((void*)column->data);
+        memset((void*)column, 0, sizeof(tSL_ArchiveColumn));
+        if (cursor->columnsUsed & (1U << i))
+        {
+            result = sqlite3_bind_int(cursor->columnStatement, 2, (int)i);
+            if (result == SQLITE_OK)
+                result = sqlite3_bind_int64(cursor->columnStatement, 3, cursor->chunk);
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_step(cursor->columnStatement);
+                if (result == SQLITE_ROW)
+                {
+                    int32_t status = SL_DecompressValue(NULL, 0,
+                                                        (const uint8_t*)sqlite3_column_blob(cursor->columnStatement, 0),
+                                                        (size_t)sqlite3_column_bytes(cursor->columnStatement, 0),
+                                                        &(column->data), &(column->size));
+                    if (status == ENOMEM)
+                        result = SQLITE_NOMEM;
+                    else
+                        result = (status == SL_RESULT_SUCCESS) ? SQLITE_OK : SQLITE_CORRUPT;
+                }
+                else if (result == SQLITE_DONE)
+                    result = SQLITE_CORRUPT;    // Every column has every chunk
+            }
+            (void)sqlite3_reset(cursor->columnStatement);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ReadArchiveRow
+// =================================================================================================
+int32_t SL_ReadArchiveRow (tSL_ArchiveCursor* cursor)
+{
+    int32_t result = SQLITE_OK;
+    uint_fast32_t i = 0;
+
+    for (i = 0; (i < SL_ARCHIVE_COLUMN_COUNT) && (result == SQLITE_OK); i++)
+    {
+        if (cursor->columnsUsed & (1U << i))
+            result = SL_ReadArchiveValue(&(cursor->columns[i]));
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ResetArchiveCursor
+// =================================================================================================
+void SL_ResetArchiveCursor (tSL_ArchiveCursor* cursor)
+{
+    uint_fast32_t i = 0;
+
+    (void)sqlite3_finalize(cursor->chunkStatement);
+    (void)sqlite3_finalize(cursor->columnStatement);
+    sqlite3_free((void*)cursor->tableName);
+    for (i = 0; i < SL_ARCHIVE_COLUMN_COUNT; i++)
+        sqlite3_free((void*)cursor->columns[i].data);
+    memset((void*)cursor, 0, sizeof(tSL_ArchiveCursor));
+}
+
+// =================================================================================================
+//  SL_ArchiveConnect
+// =================================================================================================
+int SL_ArchiveConnect (sqlite3* database,
+                       void* aux,
+                       int argc,
+                       const char* const* argv,
+                       sqlite3_vtab** vtab,
+                       char** errMsg)
+{
+    int result = sqlite3_declare_vtab(database, kSL_ArchiveSchemaString);
+
+    (void)aux;
+    (void)argc;
+    (void)argv;
+    (void)errMsg;
+    if (result == SQLITE_OK)
+    {
+        tSL_ArchiveTable* table = (tSL_ArchiveTable*)sqlite3_malloc(sizeof(tSL_ArchiveTable));
+
+        if (table == NULL)
+            result = SQLITE_NOMEM;
+        else
+        {
+            memset((void*)table, 0, sizeof(tSL_ArchiveTable));
+            table->database = database;
+            *vtab = &(table->base);
+
+            // The archive is read only, so it's safe to use from views
+            (void)sqlite3_vtab_config(database, SQLITE_VTAB_INNOCUOUS);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ArchiveBestIndex
+// =================================================================================================
+int SL_ArchiveBestIndex (sqlite3_vtab* vtab, sqlite3_index_info* indexInfo)
+{
+    int result = SQLITE_OK;
+    int tableConstraint = -1;
+    int i = 0;
+
+    (void)vtab;
+
+    // The table name argument is required
+    for (i = 0; i < indexInfo->nConstraint; i++)
+    {
+        const struct sqlite3_index_constraint* constraint = &(indexInfo->aConstraint[i]);
+
+        if ((constraint->iColumn == SL_ARCHIVE_TABLE_COLUMN) &&
+            (constraint->op == SQLITE_INDEX_CONSTRAINT_EQ))
+        {
+            if (!constraint->usable)
+                result = SQLITE_CONSTRAINT;
+            else
+                tableConstraint = i;
+        }
+    }
+    if (tableConstraint >= 0)
+    {
+        uint32_t columnsUsed = (uint32_t)(indexInfo->colUsed & ((1U << SL_ARCHIVE_COLUMN_COUNT) - 1));
+        uint32_t columnCount = 0;
+
+        // Cost grows with the number of column chunks the query has to read
+        for (i = 0; i < SL_ARCHIVE_COLUMN_COUNT; i++)
+            columnCount += (columnsUsed >> i) & 1;
+        indexInfo->aConstraintUsage[tableConstraint].argvIndex = 1;
+        indexInfo->aConstraintUsage[tableConstraint].omit = 1;
+        indexInfo->idxNum = (int)columnsUsed;
+        indexInfo->estimatedCost = 1000.0 * (1 + columnCount);
+
+        // Rows come back in log id order (the order they were archived in), so ordering by log
+        // id doesn't need a sort
+        if ((indexInfo->nOrderBy == 1) && (indexInfo->aOrderBy[0].iColumn == 0) &&
+            !indexInfo->aOrderBy[0].desc)
+            indexInfo->orderByConsumed = 1;
+        result = SQLITE_OK;
+    }
+    else if (result == SQLITE_OK)
+    {
+        indexInfo->idxNum = 0;
+        indexInfo->estimatedCost = 1e99;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ArchiveDisconnect
+// =================================================================================================
+int SL_ArchiveDisconnect (sqlite3_vtab* vtab)
+{
+    sqlite3_free((void*)vtab);
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_ArchiveOpen
+// =================================================================================================
+int SL_ArchiveOpen (sqlite3_vtab* vtab, sqlite3_vtab_cursor** cursor)
+{
+    int result = SQLITE_OK;
+    tSL_ArchiveCursor* archiveCursor = (tSL_ArchiveCursor*)sqlite3_malloc(sizeof(tSL_ArchiveCursor));
+
+    (void)vtab;
+    if (archiveCursor == NULL)
+        result = SQLITE_NOMEM;
+    else
+    {
+        memset((void*)archiveCursor, 0, sizeof(tSL_ArchiveCursor));
+        archiveCursor->eof = true;
+        *cursor = &(archiveCursor->base);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ArchiveClose
+// =================================================================================================
+int SL_ArchiveClose (sqlite3_vtab_cursor* cursor)
+{
+    SL_ResetArchiveCursor((tSL_ArchiveCursor*)cursor);
+    sqlite3_free((void*)cursor);
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_ArchiveFilter
+// =================================================================================================
+int SL_ArchiveFilter (sqlite3_vtab_cursor* cursor,
+                      int indexNumber,
+                      const char* indexString,
+                      int argc,
+                      sqlite3_value** argv)
+{
+    int result = SQLITE_OK;
+    tSL_ArchiveCursor* archiveCursor = (tSL_ArchiveCursor*)cursor;
+    sqlite3* database = ((tSL_ArchiveTable*)cursor->pVtab)->database;
+    sqlite3_vtab_cursor base = archiveCursor->base;
+
+    (void)indexString;
+
+    // Start over
+    SL_ResetArchiveCursor(archiveCursor);
+    archiveCursor->base = base;
+    archiveCursor->eof = true;
+
+    // Without a table name there's nothing to read
+    if ((argc == 1) && (sqlite3_value_type(argv[0]) != SQLITE_NULL))
+    {
+        archiveCursor->eof = false;
+        archiveCursor->columnsUsed = (uint32_t)indexNumber;
+        archiveCursor->tableName = sqlite3_mprintf("%s", (const char*)sqlite3_value_text(argv[0]));
+        if (archiveCursor->tableName == NULL)
+            result = SQLITE_NOMEM;
+        if (result == SQLITE_OK)
+            result = sqlite3_prepare_v2(database, kSL_SelectArchiveChunksSQLCommandString, -1,
+                                        &(archiveCursor->chunkStatement), NULL);
+        if (result == SQLITE_OK)
+            result = sqlite3_prepare_v2(database, kSL_SelectArchiveChunkSQLCommandString, -1,
+                                        &(archiveCursor->columnStatement), NULL);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_text(archiveCursor->chunkStatement, 1,
+                                       archiveCursor->tableName, -1, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_text(archiveCursor->columnStatement, 1,
+                                       archiveCursor->tableName, -1, SQLITE_STATIC);
+        if (result == SQLITE_OK)
+            result = SL_LoadArchiveChunk(archiveCursor);
+        if ((result == SQLITE_OK) && !archiveCursor->eof)
+            result = SL_ReadArchiveRow(archiveCursor);
+        if (result != SQLITE_OK)
+        {
+            sqlite3_free((void*)cursor->pVtab->zErrMsg);
+            cursor->pVtab->zErrMsg = sqlite3_mprintf("can't read archive of %s: %s",
+                                                     archiveCursor->tableName,
+                                                     sqlite3_errstr(result));
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ArchiveNext
+// =================================================================================================
+int SL_ArchiveNext (sqlite3_vtab_cursor* cursor)
+{
+    int result = SQLITE_OK;
+    tSL_ArchiveCursor* archiveCursor = (tSL_ArchiveCursor*)cursor;
+
+    archiveCursor->rowid++;
+    archiveCursor->row++;
+    if (archiveCursor->row >= archiveCursor->rowCount)
+        result = SL_LoadArchiveChunk(archiveCursor);
+    if ((result == SQLITE_OK) && !archiveCursor->eof)
+        result = SL_ReadArchiveRow(archiveCursor);
+    if (result != SQLITE_OK)
+    {
+        sqlite3_free((void*)cursor->pVtab->zErrMsg);
+        cursor->pVtab->zErrMsg = sqlite3_mprintf("can't read archive of %s: %s",
+                                                 archiveCursor->tableName,
+                                                 sqlite3_errstr(result));
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ArchiveEof
+// =================================================================================================
+int SL_ArchiveEof (sqlite3_vtab_cursor* cursor)
+{
+    return ((tSL_ArchiveCursor*)cursor)->eof ? 1 : 0;
+}
+
+// =================================================================================================
+//  SL_ArchiveColumnValue
+// =================================================================================================
+int SL_ArchiveColumnValue (sqlite3_vtab_cursor* cursor, sqlite3_context* context, int column)
+{
+    tSL_ArchiveCursor* archiveCursor = (tSL_ArchiveCursor*)cursor;
+
+    if (column == SL_ARCHIVE_TABLE_COLUMN)
+        sqlite3_result_text(context, archiveCursor->tableName, -1, SQLITE_TRANSIENT);
+    else if ((column >= 0) && (column < SL_ARCHIVE_COLUMN_COUNT) &&
+             (archiveCursor->columnsUsed & (1U << column)))
+    {
+        const tSL_ArchiveColumn* value = &(archiveCursor->columns[column]);
+
+        if (value->type == SQLITE_INTEGER)
+            sqlite3_result_int64(context, value->integer);
+        else if (value->type == SQLITE_FLOAT)
+            sqlite3_result_double(context, value->real);
+        else if (value->type == SQLITE_TEXT)
+            sqlite3_result_text(context, (const char*)value->bytes, (int)value->length, SQLITE_TRANSIENT);
+        else if (value->type == SQLITE_BLOB)
+            sqlite3_result_blob(context, value->bytes, (int)value->length, SQLITE_TRANSIENT);
+        else
+            sqlite3_result_null(context);
+    }
+    else
+        sqlite3_result_null(context);
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_ArchiveRowid
+// =================================================================================================
+int SL_ArchiveRowid (sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid)
+{
+    *rowid = ((tSL_ArchiveCursor*)cursor)->rowid;
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_WriteArchive
+// =================================================================================================
+int32_t SL_WriteArchive (sqlite3* database, const char* tableName)
+{
+    int32_t result = SQLITE_OK;
+    sqlite3_stmt* selectStatement = NULL;
+    sqlite3_stmt* insertStatement = NULL;
+    sqlite3_stmt* deleteStatement = NULL;
+    tSL_ArchiveBuffer buffers[SL_ARCHIVE_COLUMN_COUNT];
+    char* columns = NULL;
+    char* select = NULL;
+    char* cmdString = NULL;
+    int64_t chunk = 0;
+    uint32_t rowCount = 0;
+    uint_fast32_t i = 0;
+
+    memset((void*)buffers, 0, sizeof(buffers));
+    result = sqlite3_exec(database, kSL_CreateArchiveTableSQLCommandString, NULL, NULL, NULL);
+
+    // Remove anything left over from an earlier archive of a table with the same name
+    if (result == SQLITE_OK)
+        result = sqlite3_prepare_v2(database, kSL_DeleteArchiveSQLCommandString, -1,
+                                    &deleteStatement, NULL);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(deleteStatement, 1, tableName, -1, SQLITE_STATIC);
+    if (result == SQLITE_OK)
+    {
+        result = sqlite3_step(deleteStatement);
+        if (result == SQLITE_DONE)
+            result = SQLITE_OK; // Eat this result code
+    }
+
+    // Prepare the statements
+    if (result == SQLITE_OK)
+        result = SL_BuildLogColumnList(database, tableName, &columns);
+    if (result == SQLITE_OK)
+    {
+        // Values compress better as part of a column chunk, so they're archived decompressed
+        select = sqlite3_mprintf("SELECT %s FROM \"%w\" ORDER BY log_id", columns, tableName);
+        if (select == NULL)
+            result = SQLITE_NOMEM;
+    }
+    if (result == SQLITE_OK)
+        result = sqlite3_prepare_v2(database, select, -1, &selectStatement, NULL);
+    if (result == SQLITE_OK)
+        result = sqlite3_prepare_v2(database, kSL_InsertArchiveChunkSQLCommandString, -1,
+                                    &insertStatement, NULL);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(insertStatement, 1, tableName, -1, SQLITE_STATIC);
+
+    // Split the rows into column chunks
+    while ((result == SQLITE_OK) && ((result = sqlite3_step(selectStatement)) == SQLITE_ROW))
+    {
+        result = SQLITE_OK;
+        for (i = 0; (i < SL_ARCHIVE_COLUMN_COUNT) && (result == SQLITE_OK); i++)
+        {
+            if (SL_AppendValue(&(buffers[i]), selectStatement, (int)i) != SL_RESULT_SUCCESS)
+                result = SQLITE_NOMEM;
+        }
+        if ((result == SQLITE_OK) && (++rowCount == SL_ARCHIVE_CHUNK_ROW_COUNT))
+        {
+            result = SL_WriteArchiveChunk(insertStatement, chunk++, rowCount, buffers);
+            rowCount = 0;
+        }
+    }
+    if (result == SQLITE_DONE)
+        result = (rowCount > 0) ? SL_WriteArchiveChunk(insertStatement, chunk, rowCount, buffers) : SQLITE_OK;
+    (void)sqlite3_finalize(selectStatement);
+    (void)sqlite3_finalize(insertStatement);
+    (void)sqlite3_finalize(deleteStatement);
+
+    // Replace the table with a view of the archive
+    if (result == SQLITE_OK)
+    {
+        cmdString = sqlite3_mprintf("DROP TABLE \"%w\"; CREATE VIEW \"%w\" AS SELECT",
+                                    tableName, tableName);
+        for (i = 0; (i < SL_ARCHIVE_COLUMN_COUNT) && (cmdString != NULL); i++)
+            cmdString = sqlite3_mprintf("%z%s%s", cmdString, (i == 0) ? " " : ",",
+                                        kSL_ArchiveColumnNames[i]);
+        if (cmdString != NULL)
+            cmdString = sqlite3_mprintf("%z FROM " SL_ARCHIVE_MODULE_NAME "(%Q);", cmdString, tableName);
+        result = (cmdString == NULL) ? SQLITE_NOMEM : sqlite3_exec(database, cmdString, NULL, NULL, NULL);
+    }
+
+    // Clean up
+    for (i = 0; i < SL_ARCHIVE_COLUMN_COUNT; i++)
+        sqlite3_free((void*)buffers[i].data);
+    sqlite3_free((void*)select);
+    sqlite3_free((void*)columns);
+    sqlite3_free((void*)cmdString);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_ArchiveLogTable
+// =================================================================================================
+int32_t SL_ArchiveLogTable (sqlite3* database, const char* tableName)
+{
+    int32_t result = SQLITE_OK;
+
+    // Check arguments
+    if ((database == NULL) || (tableName == NULL))
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_ArchiveLogTable has a NULL argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else
+    {
+        // The conversion is all or nothing
+        result = sqlite3_exec(database, "SAVEPOINT sl_archive;", NULL, NULL, NULL);
+        if (result == SQLITE_OK)
+        {
+            result = SL_WriteArchive(database, tableName);
+            if (result == SQLITE_OK)
+                result = sqlite3_exec(database, "RELEASE sl_archive;", NULL, NULL, NULL);
+            else
+            {
+                fprintf(SL_TERMINAL,
+                        "At line %d in function %s, archiving %s failed with result %d.\n",
+                        __LINE__, __FUNCTION__, tableName, result);
+                (void)sqlite3_exec(database, "ROLLBACK TO sl_archive; RELEASE sl_archive;",
+                                   NULL, NULL, NULL);
+            }
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_RegisterArchiveModule
+// =================================================================================================
+int32_t SL_RegisterArchiveModule (sqlite3* database)
+{
+    int32_t result = sqlite3_create_module(database, SL_ARCHIVE_MODULE_NAME, &gSL_ArchiveModule, NULL);
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, sqlite3_create_module failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
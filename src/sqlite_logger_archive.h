@@ -0,0 +1,55 @@
+// =================================================================================================
+//! @file sqlite_logger_archive.h
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the private interface for the SQLite Logger columnar archive.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-14
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#ifndef __SQLITE_LOGGER_ARCHIVE_H__
+#define __SQLITE_LOGGER_ARCHIVE_H__
+
+#include "sqlite_logger.h"
+#include "sqlite3.h"
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+//  Name of the table that holds archived column chunks
+#define SL_ARCHIVE_TABLE_NAME           "log archive"
+
+//  Name of the table-valued function that reads archived log tables
+#define SL_ARCHIVE_MODULE_NAME          "sl_archive"
+
+//  Number of rows in each column chunk
+#define SL_ARCHIVE_CHUNK_ROW_COUNT      4096
+
+//  Number of columns in a log table (tables from older versions may have fewer)
+#define SL_LOG_COLUMN_COUNT             13
+
+// =================================================================================================
+//  Prototypes
+// =================================================================================================
+
+//  Rewrites a closed log table as compressed column chunks, and replaces the table with a view
+//  of the archive (so existing queries and views keep working)
+int32_t SL_ArchiveLogTable (sqlite3* database, const char* tableName);
+
+//  Registers the sl_archive table-valued function with a database connection
+int32_t SL_RegisterArchiveModule (sqlite3* database);
+
+//  Gets the name of a log table column (NULL if out of range)
+const char* SL_GetLogColumnName (uint32_t column);
+
+//  Builds the list of log table columns to select from a log table (or an archived log table
+//  view), in column order, with missing columns as NULL and compressed values decompressed;
+//  the caller frees the list with sqlite3_free
+int32_t SL_BuildLogColumnList (sqlite3* database, const char* tableName, char** columns);
+
+// =================================================================================================
+#endif	// __SQLITE_LOGGER_ARCHIVE_H__
+// =================================================================================================
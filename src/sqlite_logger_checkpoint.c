@@ -0,0 +1,312 @@
+// =================================================================================================
+//! @file sqlite_logger_checkpoint.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the implementation of SQLite Logger WAL checkpointing.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-28
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sqlite_logger_checkpoint.h"
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Where to direct fprintf output
+#define SL_TERMINAL                 stderr
+
+//  Time conversions
+#define SL_MICROSECONDS_PER_SECOND  1000000
+#define SL_NANOSECONDS_PER_SECOND   1000000000
+#define SL_NANOSECONDS_PER_MILLISECOND  1000000
+
+//  The clock that the checkpointer's waits are timed by (only Linux can time a condition
+//  variable's waits by the monotonic clock, and Darwin's waits are relative)
+#if defined(__linux__)
+#define SL_CHECKPOINT_WAIT_CLOCK    CLOCK_MONOTONIC
+#else
+#define SL_CHECKPOINT_WAIT_CLOCK    CLOCK_REALTIME
+#endif
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+//  The checkpointer thread, and what it shares with the logging thread (under the mutex)
+typedef struct
+{
+    sqlite3*            database;           // The checkpointer's own connection
+    pthread_t           thread;
+    pthread_mutex_t     mutex;
+    pthread_cond_t      wake;
+    bool                running;
+    bool                stopping;
+    bool                requested;          // A commit left the WAL over the page threshold
+    uint64_t            commitCount;
+    uint32_t            interval;
+    uint32_t            pageThreshold;
+    tSL_CheckpointStats stats;
+} tSL_Checkpointer;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+static int SL_CheckpointWALHook (void* context, sqlite3* database, const char* databaseName, int pageCount);
+
+static void* SL_CheckpointThread (void* argument);
+
+static uint64_t SL_GetCheckpointTime (void);
+
+// =================================================================================================
+//  Private globals
+// =================================================================================================
+
+static tSL_Checkpointer gCheckpointer;
+
+// =================================================================================================
+//  SL_StartCheckpointer
+// =================================================================================================
+int32_t SL_StartCheckpointer (sqlite3* database,
+                              const char* path,
+                              const char* vfsName,
+                              uint32_t interval,
+                              uint32_t pageThreshold)
+{
+    int32_t result = SQLITE_OK;
+#if defined(__linux__)
+    pthread_condattr_t attributes;
+#endif
+
+    memset((void*)&gCheckpointer, 0, sizeof(tSL_Checkpointer));
+    gCheckpointer.interval = interval;
+    gCheckpointer.pageThreshold = pageThreshold;
+
+    // Turn off automatic checkpoints (which would run in the committing thread), have the first
+    // commit after a checkpoint that emptied the WAL truncate it as it starts the WAL over, and
+    // give the logger connection time to wait out the WAL index locks that checkpoints take
+    // briefly; the WAL hook takes the place of the automatic checkpoints, so it's set after them
+    result = sqlite3_exec(database,
+                          "PRAGMA journal_mode = WAL; PRAGMA wal_autocheckpoint = 0; PRAGMA journal_size_limit = 0;",
+                          NULL, NULL, NULL);
+    if (result == SQLITE_OK)
+        result = sqlite3_busy_timeout(database, SL_CHECKPOINT_BUSY_TIMEOUT);
+    if (result == SQLITE_OK)
+        result = sqlite3_open_v2(path, &(gCheckpointer.database), SQLITE_OPEN_READWRITE, vfsName);
+
+    // A connection only opens the WAL once it has read the log file, and until then it has no
+    // WAL to checkpoint
+    if (result == SQLITE_OK)
+        result = sqlite3_exec(gCheckpointer.database, "PRAGMA journal_mode = WAL;", NULL, NULL, NULL);
+    if (result == SQLITE_OK)
+    {
+        (void)pthread_mutex_init(&(gCheckpointer.mutex), NULL);
+#if defined(__linux__)
+        (void)pthread_condattr_init(&attributes);
+        (void)pthread_condattr_setclock(&attributes, SL_CHECKPOINT_WAIT_CLOCK);
+        (void)pthread_cond_init(&(gCheckpointer.wake), &attributes);
+        (void)pthread_condattr_destroy(&attributes);
+#else
+        (void)pthread_cond_init(&(gCheckpointer.wake), NULL);
+#endif
+        (void)sqlite3_wal_hook(database, SL_CheckpointWALHook, (void*)&gCheckpointer);
+
+        result = pthread_create(&(gCheckpointer.thread), NULL, SL_CheckpointThread, (void*)&gCheckpointer);
+        if (result == 0)
+            gCheckpointer.running = true;
+        else
+        {
+            (void)sqlite3_wal_hook(database, NULL, NULL);
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, pthread_create failed with result %d.\n",
+                    __LINE__, __FUNCTION__, result);
+        }
+    }
+    else
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, setting up checkpointing failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    if (!gCheckpointer.running && (gCheckpointer.database != NULL))
+    {
+        (void)sqlite3_close_v2(gCheckpointer.database);
+        gCheckpointer.database = NULL;
+    }
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_StopCheckpointer
+// =================================================================================================
+void SL_StopCheckpointer (void)
+{
+    if (gCheckpointer.running)
+    {
+        (void)pthread_mutex_lock(&(gCheckpointer.mutex));
+        gCheckpointer.stopping = true;
+        (void)pthread_cond_signal(&(gCheckpointer.wake));
+        (void)pthread_mutex_unlock(&(gCheckpointer.mutex));
+        (void)pthread_join(gCheckpointer.thread, NULL);
+        gCheckpointer.running = false;
+
+        (void)sqlite3_close_v2(gCheckpointer.database);
+        gCheckpointer.database = NULL;
+        (void)pthread_cond_destroy(&(gCheckpointer.wake));
+        (void)pthread_mutex_destroy(&(gCheckpointer.mutex));
+    }
+}
+
+// =================================================================================================
+//  SL_GetCheckpointerStats
+// =================================================================================================
+void SL_GetCheckpointerStats (tSL_CheckpointStats* stats)
+{
+    if (gCheckpointer.running)
+    {
+        (void)pthread_mutex_lock(&(gCheckpointer.mutex));
+        *stats = gCheckpointer.stats;
+        (void)pthread_mutex_unlock(&(gCheckpointer.mutex));
+    }
+    else
+        memset((void*)stats, 0, sizeof(tSL_CheckpointStats));
+}
+
+// =================================================================================================
+//  SL_CheckpointWALHook
+// =================================================================================================
+int SL_CheckpointWALHook (void* context, sqlite3* database, const char* databaseName, int pageCount)
+{
+    tSL_Checkpointer* checkpointer = (tSL_Checkpointer*)context;
+
+    // Called on the logging thread after each commit, so it only wakes the checkpointer
+    (void)database;
+    (void)databaseName;
+    (void)pthread_mutex_lock(&(checkpointer->mutex));
+    checkpointer->commitCount++;
+    if ((checkpointer->pageThreshold > 0) && ((uint32_t)pageCount >= checkpointer->pageThreshold) &&
+        !checkpointer->requested)
+    {
+        checkpointer->requested = true;
+        (void)pthread_cond_signal(&(checkpointer->wake));
+    }
+    (void)pthread_mutex_unlock(&(checkpointer->mutex));
+
+    return SQLITE_OK;
+}
+
+// =================================================================================================
+//  SL_CheckpointThread
+// =================================================================================================
+void* SL_CheckpointThread (void* argument)
+{
+    tSL_Checkpointer* checkpointer = (tSL_Checkpointer*)argument;
+    uint64_t lastCommitCount = 0;
+    int walFrameCount = 0;
+
+    (void)pthread_mutex_lock(&(checkpointer->mutex));
+    while (!checkpointer->stopping)
+    {
+        // Wait for the next interval, or for a commit over the page threshold
+        if (!checkpointer->requested)
+        {
+            if (checkpointer->interval > 0)
+            {
+#if defined(__APPLE__)
+                struct timespec timeout;
+
+                timeout.tv_sec = checkpointer->interval / 1000;
+                timeout.tv_nsec = (long)(checkpointer->interval % 1000) * SL_NANOSECONDS_PER_MILLISECOND;
+                (void)pthread_cond_timedwait_relative_np(&(checkpointer->wake), &(checkpointer->mutex), &timeout);
+#else
+                struct timespec deadline;
+
+                (void)clock_gettime(SL_CHECKPOINT_WAIT_CLOCK, &deadline);
+                deadline.tv_sec += checkpointer->interval / 1000;
+                deadline.tv_nsec += (long)(checkpointer->interval % 1000) * SL_NANOSECONDS_PER_MILLISECOND;
+                if (deadline.tv_nsec >= SL_NANOSECONDS_PER_SECOND)
+                {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= SL_NANOSECONDS_PER_SECOND;
+                }
+                (void)pthread_cond_timedwait(&(checkpointer->wake), &(checkpointer->mutex), &deadline);
+#endif
+            }
+            else
+                (void)pthread_cond_wait(&(checkpointer->wake), &(checkpointer->mutex));
+        }
+        if (!checkpointer->stopping)
+        {
+            // Checkpoints are all PASSIVE, so they never take the write lock and never hold up a
+            // commit (a TRUNCATE checkpoint would, and could make SL_Log wait, or fail with
+            // SQLITE_BUSY); once nothing has been committed for an interval, what's left of the
+            // WAL is checkpointed, and the next commit starts the WAL over and truncates it
+            bool idle = (checkpointer->commitCount == lastCommitCount) && !checkpointer->requested;
+
+            lastCommitCount = checkpointer->commitCount;
+            checkpointer->requested = false;
+            if (!idle || (walFrameCount > 0))
+            {
+                uint64_t start = 0;
+                uint64_t elapsed = 0;
+                int checkpointedFrameCount = 0;
+                int result = SQLITE_OK;
+
+                (void)pthread_mutex_unlock(&(checkpointer->mutex));
+                start = SL_GetCheckpointTime();
+                result = sqlite3_wal_checkpoint_v2(checkpointer->database, NULL, SQLITE_CHECKPOINT_PASSIVE,
+                                                   &walFrameCount, &checkpointedFrameCount);
+                elapsed = SL_GetCheckpointTime() - start;
+                (void)pthread_mutex_lock(&(checkpointer->mutex));
+                if ((walFrameCount < 0) || (checkpointedFrameCount < 0))
+                    walFrameCount = 1;  // Unknown, so the WAL is checked again at the next interval
+                else
+                    walFrameCount -= checkpointedFrameCount;
+
+                // A busy checkpoint is tried again at the next interval
+                if (result == SQLITE_OK)
+                {
+                    checkpointer->stats.checkpointCount++;
+                    if (walFrameCount == 0)
+                        checkpointer->stats.truncateCount++;
+                    checkpointer->stats.totalTime += elapsed;
+                    if (elapsed > checkpointer->stats.maxTime)
+                        checkpointer->stats.maxTime = elapsed;
+                    checkpointer->stats.walFrameCount = (uint32_t)walFrameCount;
+                }
+                else if (result == SQLITE_BUSY)
+                    checkpointer->stats.busyCount++;
+                else
+                {
+                    checkpointer->stats.errorCount++;
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, sqlite3_wal_checkpoint_v2 failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+                }
+            }
+        }
+    }
+    (void)pthread_mutex_unlock(&(checkpointer->mutex));
+
+    return NULL;
+}
+
+// =================================================================================================
+//  SL_GetCheckpointTime
+// =================================================================================================
+uint64_t SL_GetCheckpointTime (void)
+{
+    struct timespec now;
+
+    // Get monotonic time in microseconds
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * SL_MICROSECONDS_PER_SECOND) + ((uint64_t)now.tv_nsec / 1000);
+}
+
+// =================================================================================================
@@ -0,0 +1,48 @@
+// =================================================================================================
+//! @file sqlite_logger_checkpoint.h
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the private interface for SQLite Logger WAL checkpointing.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-28
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#ifndef __SQLITE_LOGGER_CHECKPOINT_H__
+#define __SQLITE_LOGGER_CHECKPOINT_H__
+
+#include "sqlite_logger.h"
+#include "sqlite3.h"
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+//  How long the logger connection waits for a WAL index lock that a checkpoint holds (in ms)
+#define SL_CHECKPOINT_BUSY_TIMEOUT      1000
+
+// =================================================================================================
+//  Prototypes
+// =================================================================================================
+
+//  Starts checkpointing the WAL of the logger connection's log file on a thread with its own
+//  connection, every interval (in ms, if not 0) and whenever a commit leaves at least
+//  pageThreshold pages in the WAL (if not 0); the logger connection's automatic checkpoints are
+//  turned off
+int32_t SL_StartCheckpointer (sqlite3* database,
+                              const char* path,
+                              const char* vfsName,
+                              uint32_t interval,
+                              uint32_t pageThreshold);
+
+//  Stops the checkpointer thread and closes its connection (the logger connection checkpoints
+//  what's left when it's closed)
+void SL_StopCheckpointer (void);
+
+//  Gets the statistics of the checkpoints since the checkpointer was started
+void SL_GetCheckpointerStats (tSL_CheckpointStats* stats);
+
+// =================================================================================================
+#endif	// __SQLITE_LOGGER_CHECKPOINT_H__
+// =================================================================================================
@@ -0,0 +1,862 @@
+// =================================================================================================
+//! @file sqlite_logger_compression.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the implementation of SQLite Logger column compression.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-10
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sqlite_logger_compression.h"
+#include <string.h>
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Where to direct fprintf output
+#define SL_TERMINAL             stderr
+
+//  Compressed data uses the LZ4 block format, so these limits are the same as LZ4's
+#define SL_MIN_MATCH            4
+#define SL_LAST_LITERALS        5
+#define SL_MATCH_FIND_LIMIT     12
+#define SL_MAX_OFFSET           65535
+#define SL_RUN_MASK             15
+
+//  Smallest useful dictionary
+#define SL_MIN_DICTIONARY_SIZE  64
+
+//  Number of dictionaries cached by the sl_decompress SQL function
+#define SL_DICTIONARY_CACHE_SIZE    4
+
+//  SQL command to load a dictionary
+static const char* kSL_SelectDictionarySQLCommandString =
+    "SELECT dictionary_content FROM `" SL_DICTIONARY_TABLE_NAME "` WHERE dictionary_id = ?";
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+//  Dictionary loaded by the sl_decompress SQL function
+typedef struct tsl_cacheddictionary
+{
+    int64_t     id;
+    size_t      size;
+    uint8_t*    content;
+}
+tSL_CachedDictionary;
+
+//  Dictionaries loaded by the sl_decompress SQL function
+typedef struct tsl_dictionarycache
+{
+    tSL_CachedDictionary    entries[SL_DICTIONARY_CACHE_SIZE];
+    uint32_t                next;
+}
+tSL_DictionaryCache;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+static uint32_t SL_Read32 (const uint8_t* p);
+
+static uint32_t SL_Hash (uint32_t value);
+
+static uint8_t* SL_WriteLength (uint8_t* op, size_t length);
+
+static uint64_t SL_HashSampleShape (const char* sample, size_t length);
+
+static int32_t SL_CompressBlock (const tSL_CompressionDictionary* dictionary,
+                                 const uint8_t* source,
+                                 size_t sourceSize,
+                                 uint8_t* destination,
+                                 size_t destinationCapacity,
+                                 size_t* compressedSize);
+
+static int32_t SL_DecompressBlock (const uint8_t* dictionary,
+                                   size_t dictionarySize,
+                                   const uint8_t* source,
+                                   size_t sourceSize,
+                                   uint8_t* destination,
+                                   size_t destinationSize);
+
+static int32_t SL_LoadDictionary (sqlite3* database,
+                                  tSL_DictionaryCache* cache,
+                                  int64_t dictionaryId,
+                                  const tSL_CachedDictionary** dictionary);
+
+static void SL_DestroyDictionaryCache (void* cache);
+
+static void SL_DecompressFunction (sqlite3_context* context,
+                                   int argc,
+                                   sqlite3_value** argv);
+
+// =================================================================================================
+//  SL_Read32
+// =================================================================================================
+uint32_t SL_Read32 (const uint8_t* p)
+{
+    uint32_t value = 0;
+
+    memcpy((void*)&value, (const void*)p, sizeof(value));
+    return value;
+}
+
+// =================================================================================================
+//  SL_Hash
+// =================================================================================================
+uint32_t SL_Hash (uint32_t value)
+{
+    return (value * 2654435761U) >> (32 - SL_COMPRESSION_HASH_LOG);
+}
+
+// =================================================================================================
+//  SL_WriteLength
+// =================================================================================================
+uint8_t* SL_WriteLength (uint8_t* op, size_t length)
+{
+    // Lengths that don't fit in a token nibble continue in 255-valued bytes
+    while (length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+
+    return op;
+}
+
+// =================================================================================================
+//  SL_WriteVarint
+// =================================================================================================
+size_t SL_WriteVarint (uint8_t* op, uint64_t value)
+{
+    size_t size = 0;
+
+    do
+    {
+        op[size++] = (uint8_t)((value & 0x7F) | ((value > 0x7F) ? 0x80 : 0));
+        value >>= 7;
+    }
+    while (value != 0);
+
+    return size;
+}
+
+// =================================================================================================
+//  SL_ReadVarint
+// =================================================================================================
+int32_t SL_ReadVarint (const uint8_t* source, size_t sourceSize, size_t* position, uint64_t* value)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint32_t shift = 0;
+    uint8_t b = 0x80;
+
+    *value = 0;
+    while ((b & 0x80) && (result == SL_RESULT_SUCCESS))
+    {
+        if ((*position >= sourceSize) || (shift > 63))
+            result = EILSEQ;
+        else
+        {
+            b = source[(*position)++];
+            *value |= (uint64_t)(b & 0x7F) << shift;
+            shift += 7;
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_HashSampleShape
+// =================================================================================================
+uint64_t SL_HashSampleShape (const char* sample, size_t length)
+{
+    uint64_t hash = 14695981039346656037ULL;    // FNV-1a offset basis
+    size_t i = 0;
+
+    // Digits hash alike, so messages that differ only in their numbers have the same shape
+    for (i = 0; i < length; i++)
+    {
+        uint8_t c = (uint8_t)sample[i];
+
+        hash ^= ((c >= '0') && (c <= '9')) ? '0' : c;
+        hash *= 1099511628211ULL;               // FNV-1a prime
+    }
+    return hash;
+}
+
+// =================================================================================================
+//  SL_CompressBlock
+// =================================================================================================
+int32_t SL_CompressBlock (const tSL_CompressionDictionary* dictionary,
+                          const uint8_t* source,
+                          size_t sourceSize,
+                          uint8_t* destination,
+                          size_t destinationCapacity,
+                          size_t* compressedSize)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint32_t table[SL_COMPRESSION_HASH_TABLE_SIZE];
+    const uint8_t* dict = NULL;
+    size_t dictSize = 0;
+    const uint8_t* ip = source;
+    const uint8_t* anchor = source;
+    const uint8_t* iend = source + sourceSize;
+    uint8_t* op = destination;
+    uint8_t* oend = destination + destinationCapacity;
+    size_t literalLength = 0;
+
+    // Positions in the table index the dictionary followed by the source
+    if ((dictionary != NULL) && (dictionary->size > 0))
+    {
+        dict = dictionary->content;
+        dictSize = dictionary->size;
+        memcpy((void*)table, (const void*)dictionary->hashTable, sizeof(table));
+    }
+    else
+        memset((void*)table, 0, sizeof(table));
+
+    // Find matches (inputs too short to hold a match are stored as literals)
+    if (sourceSize > SL_MATCH_FIND_LIMIT)
+    {
+        const uint8_t* mflimit = iend - SL_MATCH_FIND_LIMIT;
+        const uint8_t* matchlimit = iend - SL_LAST_LITERALS;
+
+        ip++;
+        while ((ip < mflimit) && (result == SL_RESULT_SUCCESS))
+        {
+            uint32_t h = SL_Hash(SL_Read32(ip));
+            size_t position = dictSize + (size_t)(ip - source);
+            size_t candidate = table[h];
+            const uint8_t* ref = NULL;
+            const uint8_t* refStart = NULL;
+            const uint8_t* refEnd = NULL;
+
+            table[h] = (uint32_t)position;
+
+            // Locate the candidate in the dictionary or the source
+            if ((candidate < position) && ((position - candidate) <= SL_MAX_OFFSET))
+            {
+                if (candidate >= dictSize)
+                {
+                    ref = source + (candidate - dictSize);
+                    refStart = source;
+                    refEnd = iend;
+                }
+                else if ((candidate + SL_MIN_MATCH) <= dictSize)
+                {
+                    ref = dict + candidate;
+                    refStart = dict;
+                    refEnd = dict + dictSize;
+                }
+            }
+
+            if ((ref != NULL) && (SL_Read32(ref) == SL_Read32(ip)))
+            {
+                const uint8_t* mp = NULL;
+                const uint8_t* rp = NULL;
+                size_t matchLength = 0;
+                size_t offset = position - candidate;
+                uint8_t* token = NULL;
+
+                // Extend the match backwards
+                while ((ip > anchor) && (ref > refStart) && (ip[-1] == ref[-1]))
+                {
+                    ip--;
+                    ref--;
+                }
+
+                // Extend the match forwards (dictionary matches stop at the end of the dictionary)
+                mp = ip + SL_MIN_MATCH;
+                rp = ref + SL_MIN_MATCH;
+                while ((mp < matchlimit) && (rp < refEnd) && (*mp == *rp))
+                {
+                    mp++;
+                    rp++;
+                }
+
+                literalLength = (size_t)(ip - anchor);
+                matchLength = (size_t)(mp - ip) - SL_MIN_MATCH;
+
+                // Make sure the sequence fits
+                if ((size_t)(oend - op) < (1 + (literalLength / 255) + 1 + literalLength + 2 + (matchLength / 255) + 1))
+                    result = ENOSPC;
+                else
+                {
+                    // Token and literals
+                    token = op++;
+                    if (literalLength >= SL_RUN_MASK)
+                    {
+                        *token = (uint8_t)(SL_RUN_MASK << 4);
+                        op = SL_WriteLength(op, literalLength - SL_RUN_MASK);
+                    }
+                    else
+                        *token = (uint8_t)(literalLength << 4);
+                    memcpy((void*)op, (const void*)anchor, literalLength);
+                    op += literalLength;
+
+                    // Offset (little endian) and match length
+                    *op++ = (uint8_t)(offset & 0xFF);
+                    *op++ = (uint8_t)(offset >> 8);
+                    if (matchLength >= SL_RUN_MASK)
+                    {
+                        *token |= SL_RUN_MASK;
+                        op = SL_WriteLength(op, matchLength - SL_RUN_MASK);
+                    }
+                    else
+                        *token |= (uint8_t)matchLength;
+
+                    // Continue after the match
+                    ip = mp;
+                    anchor = ip;
+                    if (ip < mflimit)
+                        table[SL_Hash(SL_Read32(ip - 2))] = (uint32_t)(dictSize + (size_t)(ip - 2 - source));
+                }
+            }
+            else
+                ip++;
+        }
+    }
+
+    // Last literals
+    if (result == SL_RESULT_SUCCESS)
+    {
+        literalLength = (size_t)(iend - anchor);
+        if ((size_t)(oend - op) < (1 + (literalLength / 255) + 1 + literalLength))
+            result = ENOSPC;
+        else
+        {
+            if (literalLength >= SL_RUN_MASK)
+            {
+                *op++ = (uint8_t)(SL_RUN_MASK << 4);
+                op = SL_WriteLength(op, literalLength - SL_RUN_MASK);
+            }
+            else
+                *op++ = (uint8_t)(literalLength << 4);
+            memcpy((void*)op, (const void*)anchor, literalLength);
+            op += literalLength;
+
+            *compressedSize = (size_t)(op - destination);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_DecompressBlock
+// =================================================================================================
+int32_t SL_DecompressBlock (const uint8_t* dictionary,
+                            size_t dictionarySize,
+                            const uint8_t* source,
+                            size_t sourceSize,
+                            uint8_t* destination,
+                            size_t destinationSize)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    const uint8_t* ip = source;
+    const uint8_t* iend = source + sourceSize;
+    uint8_t* op = destination;
+    uint8_t* oend = destination + destinationSize;
+
+    while ((ip < iend) && (result == SL_RESULT_SUCCESS))
+    {
+        uint8_t token = *ip++;
+        size_t literalLength = token >> 4;
+        size_t matchLength = token & SL_RUN_MASK;
+        size_t offset = 0;
+
+        // Literal length
+        if (literalLength == SL_RUN_MASK)
+        {
+            uint8_t b = 255;
+
+            while ((b == 255) && (ip < iend))
+            {
+                b = *ip++;
+                literalLength += b;
+            }
+        }
+
+        // Literals
+        if ((literalLength > (size_t)(iend - ip)) || (literalLength > (size_t)(oend - op)))
+        {
+            result = EILSEQ;
+            break;
+        }
+        memcpy((void*)op, (const void*)ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // The last sequence has no match
+        if (ip == iend)
+            break;
+
+        // Offset
+        if ((iend - ip) < 2)
+        {
+            result = EILSEQ;
+            break;
+        }
+        offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if ((offset == 0) || (offset > ((size_t)(op - destination) + dictionarySize)))
+        {
+            result = EILSEQ;
+            break;
+        }
+
+        // Match length
+        if (matchLength == SL_RUN_MASK)
+        {
+            uint8_t b = 255;
+
+            while ((b == 255) && (ip < iend))
+            {
+                b = *ip++;
+                matchLength += b;
+            }
+        }
+        matchLength += SL_MIN_MATCH;
+
+        // Match (which may start in the dictionary or overlap the output, so copy byte by byte)
+        if (matchLength > (size_t)(oend - op))
+            result = EILSEQ;
+        else
+        {
+            while (matchLength-- > 0)
+            {
+                size_t produced = (size_t)(op - destination);
+
+                *op = (offset <= produced) ?
+                    op[-(ptrdiff_t)offset] : dictionary[dictionarySize - (offset - produced)];
+                op++;
+            }
+        }
+    }
+
+    // Check that we got everything
+    if ((result == SL_RESULT_SUCCESS) && (op != oend))
+        result = EILSEQ;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_CompressBound
+// =================================================================================================
+size_t SL_CompressBound (size_t sourceSize)
+{
+    return SL_COMPRESSED_VALUE_HEADER_SIZE + sourceSize + (sourceSize / 255) + 16;
+}
+
+// =================================================================================================
+//  SL_CompressValue
+// =================================================================================================
+int32_t SL_CompressValue (const tSL_CompressionDictionary* dictionary,
+                          const uint8_t* source,
+                          size_t sourceSize,
+                          uint8_t* destination,
+                          size_t destinationCapacity,
+                          size_t* compressedSize)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    size_t headerSize = 0;
+    size_t blockSize = 0;
+
+    // An empty dictionary is the same as no dictionary
+    if ((dictionary != NULL) && (dictionary->size == 0))
+        dictionary = NULL;
+
+    // Check arguments
+    if ((source == NULL) || (destination == NULL) || (compressedSize == NULL))
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_CompressValue has a NULL argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if ((sourceSize > UINT32_MAX) || (destinationCapacity < SL_COMPRESSED_VALUE_HEADER_SIZE))
+        result = ENOSPC;
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        // Header is the marker byte, the dictionary id (if any) and the uncompressed size
+        if (dictionary != NULL)
+        {
+            destination[headerSize++] = SL_DICTIONARY_COMPRESSED_VALUE_MARKER;
+            headerSize += SL_WriteVarint(destination + headerSize, (uint64_t)dictionary->id);
+        }
+        else
+            destination[headerSize++] = SL_COMPRESSED_VALUE_MARKER;
+        headerSize += SL_WriteVarint(destination + headerSize, (uint64_t)sourceSize);
+
+        // Compressed data
+        result = SL_CompressBlock(dictionary, source, sourceSize,
+                                  destination + headerSize, destinationCapacity - headerSize,
+                                  &blockSize);
+        if (result == SL_RESULT_SUCCESS)
+            *compressedSize = headerSize + blockSize;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_GetCompressedValueDictionaryId
+// =================================================================================================
+int32_t SL_GetCompressedValueDictionaryId (const uint8_t* source,
+                                           size_t sourceSize,
+                                           int64_t* dictionaryId)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    size_t position = 1;
+    uint64_t id = 0;
+
+    // Check arguments
+    if ((source == NULL) || (dictionaryId == NULL))
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_GetCompressedValueDictionaryId has a NULL argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (sourceSize < 2)
+        result = EILSEQ;
+    else if (source[0] == SL_COMPRESSED_VALUE_MARKER)
+        *dictionaryId = 0;
+    else if (source[0] != SL_DICTIONARY_COMPRESSED_VALUE_MARKER)
+        result = EILSEQ;
+    else
+    {
+        result = SL_ReadVarint(source, sourceSize, &position, &id);
+        if (result == SL_RESULT_SUCCESS)
+            *dictionaryId = (int64_t)id;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_DecompressValue
+// =================================================================================================
+int32_t SL_DecompressValue (const uint8_t* dictionary,
+                            size_t dictionarySize,
+                            const uint8_t* source,
+                            size_t sourceSize,
+                            char** text,
+                            size_t* textSize)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    size_t headerSize = 1;
+    uint64_t size = 0;
+    char* buffer = NULL;
+
+    // Check arguments
+    if ((source == NULL) || (text == NULL) || (textSize == NULL))
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_DecompressValue has a NULL argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (sourceSize < 2)
+        result = EILSEQ;
+    else if (source[0] == SL_DICTIONARY_COMPRESSED_VALUE_MARKER)
+    {
+        uint64_t id = 0;
+
+        // Skip the dictionary id; the caller has already looked up the dictionary
+        result = SL_ReadVarint(source, sourceSize, &headerSize, &id);
+        if ((result == SL_RESULT_SUCCESS) && (dictionary == NULL))
+            result = EINVAL;
+    }
+    else if (source[0] != SL_COMPRESSED_VALUE_MARKER)
+        result = EILSEQ;
+
+    // Parse the uncompressed size
+    if (result == SL_RESULT_SUCCESS)
+    {
+        result = SL_ReadVarint(source, sourceSize, &headerSize, &size);
+        if ((result == SL_RESULT_SUCCESS) && (size > UINT32_MAX))
+            result = EILSEQ;
+    }
+
+    // Decompress
+    if (result == SL_RESULT_SUCCESS)
+    {
+        buffer = (char*)sqlite3_malloc64((sqlite3_uint64)size + 1);
+        if (buffer == NULL)
+            result = ENOMEM;
+        else
+        {
+            result = SL_DecompressBlock(dictionary, (dictionary != NULL) ? dictionarySize : 0,
+                                        source + headerSize, sourceSize - headerSize,
+                                        (uint8_t*)buffer, (size_t)size);
+            if (result == SL_RESULT_SUCCESS)
+            {
+                buffer[size] = '\0';
+                *text = buffer;
+                *textSize = size;
+            }
+            else
+                sqlite3_free((void*)buffer);
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_AddDictionarySample
+// =================================================================================================
+void SL_AddDictionarySample (tSL_DictionaryTrainer* trainer, const char* text, size_t length)
+{
+    uint32_t slot = trainer->sampleCount % SL_DICTIONARY_SAMPLE_COUNT;
+
+    // The sample is a ring of the most recent values (truncated to the sample length)
+    if (length > SL_DICTIONARY_SAMPLE_LENGTH)
+        length = SL_DICTIONARY_SAMPLE_LENGTH;
+    memcpy((void*)trainer->samples[slot], (const void*)text, length);
+    trainer->sampleLengths[slot] = (uint16_t)length;
+    trainer->sampleCount++;
+}
+
+// =================================================================================================
+//  SL_TrainDictionary
+// =================================================================================================
+int32_t SL_TrainDictionary (const tSL_DictionaryTrainer* trainer,
+                            tSL_CompressionDictionary* dictionary)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint64_t shapes[SL_DICTIONARY_SAMPLE_COUNT];
+    uint32_t scores[SL_DICTIONARY_SAMPLE_COUNT];
+    uint16_t order[SL_DICTIONARY_SAMPLE_COUNT];
+    uint32_t sampleCount = (trainer->sampleCount < SL_DICTIONARY_SAMPLE_COUNT) ?
+        trainer->sampleCount : SL_DICTIONARY_SAMPLE_COUNT;
+    uint32_t candidateCount = 0;
+    uint32_t selectedCount = 0;
+    size_t size = 0;
+    uint_fast32_t i = 0;
+    uint_fast32_t j = 0;
+
+    // Group the samples by shape
+    for (i = 0; i < sampleCount; i++)
+        shapes[i] = SL_HashSampleShape(trainer->samples[i], trainer->sampleLengths[i]);
+
+    // Score one sample of each shape by how much of the sample its shape covers
+    for (i = 0; i < sampleCount; i++)
+    {
+        uint32_t count = 0;
+        bool first = true;
+
+        for (j = 0; j < sampleCount; j++)
+        {
+            if (shapes[j] == shapes[i])
+            {
+                if (j < i)
+                    first = false;
+                count++;
+            }
+        }
+        if (first && (trainer->sampleLengths[i] >= SL_MIN_MATCH))
+        {
+            scores[i] = count * trainer->sampleLengths[i];
+
+            // Insert in descending score order
+            j = candidateCount++;
+            while ((j > 0) && (scores[order[j - 1]] < scores[i]))
+            {
+                order[j] = order[j - 1];
+                j--;
+            }
+            order[j] = (uint16_t)i;
+        }
+    }
+
+    // Take the best samples that fit
+    for (i = 0; i < candidateCount; i++)
+    {
+        if ((size + trainer->sampleLengths[order[i]]) <= SL_MAX_DICTIONARY_SIZE)
+        {
+            size += trainer->sampleLengths[order[i]];
+            order[selectedCount++] = order[i];
+        }
+    }
+
+    if (size < SL_MIN_DICTIONARY_SIZE)
+        result = ENODATA;
+    else
+    {
+        size_t position = 0;
+
+        // Lay out the best samples last, where offsets to them are shortest
+        dictionary->size = size;
+        for (i = selectedCount; i > 0; i--)
+        {
+            uint16_t sample = order[i - 1];
+
+            memcpy((void*)(dictionary->content + position),
+                   (const void*)trainer->samples[sample],
+                   trainer->sampleLengths[sample]);
+            position += trainer->sampleLengths[sample];
+        }
+
+        // Prime the match finder
+        memset((void*)dictionary->hashTable, 0, sizeof(dictionary->hashTable));
+        for (position = 0; (position + SL_MIN_MATCH) <= size; position++)
+            dictionary->hashTable[SL_Hash(SL_Read32(dictionary->content + position))] = (uint32_t)position;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_LoadDictionary
+// =================================================================================================
+int32_t SL_LoadDictionary (sqlite3* database,
+                           tSL_DictionaryCache* cache,
+                           int64_t dictionaryId,
+                           const tSL_CachedDictionary** dictionary)
+{
+    int32_t result = SQLITE_OK;
+    sqlite3_stmt* statement = NULL;
+    uint_fast32_t i = 0;
+
+    // Look in the cache first (dictionaries never change once they're written)
+    *dictionary = NULL;
+    for (i = 0; i < SL_DICTIONARY_CACHE_SIZE; i++)
+    {
+        if ((cache->entries[i].content != NULL) && (cache->entries[i].id == dictionaryId))
+        {
+            *dictionary = &(cache->entries[i]);
+            break;
+        }
+    }
+
+    // Load the dictionary
+    if (*dictionary == NULL)
+    {
+        result = sqlite3_prepare_v2(database, kSL_SelectDictionarySQLCommandString, -1,
+                                    &statement, NULL);
+        if (result == SQLITE_OK)
+            result = sqlite3_bind_int64(statement, 1, dictionaryId);
+        if (result == SQLITE_OK)
+        {
+            result = sqlite3_step(statement);
+            if (result == SQLITE_ROW)
+            {
+                tSL_CachedDictionary* entry = &(cache->entries[cache->next]);
+                const void* content = sqlite3_column_blob(statement, 0);
+                int size = sqlite3_column_bytes(statement, 0);
+
+                // Replace the oldest cached dictionary
+                sqlite3_free((void*)entry->content);
+                entry->content = (uint8_t*)sqlite3_malloc((size > 0) ? size : 1);
+                if (entry->content == NULL)
+                    result = SQLITE_NOMEM;
+                else
+                {
+                    if (size > 0)
+                        memcpy((void*)entry->content, content, (size_t)size);
+                    entry->id = dictionaryId;
+                    entry->size = (size_t)size;
+                    cache->next = (cache->next + 1) % SL_DICTIONARY_CACHE_SIZE;
+                    *dictionary = entry;
+                    result = SQLITE_OK;
+                }
+            }
+            else if (result == SQLITE_DONE)
+                result = SQLITE_NOTFOUND;
+        }
+        (void)sqlite3_finalize(statement);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_DestroyDictionaryCache
+// =================================================================================================
+void SL_DestroyDictionaryCache (void* cache)
+{
+    tSL_DictionaryCache* dictionaryCache = (tSL_DictionaryCache*)cache;
+    uint_fast32_t i = 0;
+
+    for (i = 0; i < SL_DICTIONARY_CACHE_SIZE; i++)
+        sqlite3_free((void*)dictionaryCache->entries[i].content);
+    sqlite3_free(cache);
+}
+
+// =================================================================================================
+//  SL_DecompressFunction
+// =================================================================================================
+void SL_DecompressFunction (sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+    const uint8_t* blob = NULL;
+    int blobSize = 0;
+
+    // Only compressed values are BLOBs; everything else passes through unchanged
+    if ((argc == 1) && (sqlite3_value_type(argv[0]) == SQLITE_BLOB))
+    {
+        blob = (const uint8_t*)sqlite3_value_blob(argv[0]);
+        blobSize = sqlite3_value_bytes(argv[0]);
+    }
+    if ((blob != NULL) && (blobSize > 0) &&
+        ((blob[0] == SL_COMPRESSED_VALUE_MARKER) || (blob[0] == SL_DICTIONARY_COMPRESSED_VALUE_MARKER)))
+    {
+        const tSL_CachedDictionary* dictionary = NULL;
+        char* text = NULL;
+        size_t textSize = 0;
+        int64_t dictionaryId = 0;
+        int32_t result = SL_GetCompressedValueDictionaryId(blob, (size_t)blobSize, &dictionaryId);
+
+        // Find the dictionary
+        if ((result == SL_RESULT_SUCCESS) && (dictionaryId != 0) &&
+            (SL_LoadDictionary(sqlite3_context_db_handle(context),
+                               (tSL_DictionaryCache*)sqlite3_user_data(context),
+                               dictionaryId, &dictionary) != SQLITE_OK))
+            result = ENOENT;
+
+        if (result == SL_RESULT_SUCCESS)
+            result = SL_DecompressValue((dictionary != NULL) ? dictionary->content : NULL,
+                                        (dictionary != NULL) ? dictionary->size : 0,
+                                        blob, (size_t)blobSize, &text, &textSize);
+
+        if (result == SL_RESULT_SUCCESS)
+            sqlite3_result_text64(context, text, (sqlite3_uint64)textSize, sqlite3_free, SQLITE_UTF8);
+        else if (result == ENOMEM)
+            sqlite3_result_error_nomem(context);
+        else if (result == ENOENT)
+            sqlite3_result_error(context, "compression dictionary not found", -1);
+        else
+            sqlite3_result_error(context, "malformed compressed value", -1);
+    }
+    else
+        sqlite3_result_value(context, argv[0]);
+}
+
+// =================================================================================================
+//  SL_RegisterCompressionFunctions
+// =================================================================================================
+int32_t SL_RegisterCompressionFunctions (sqlite3* database)
+{
+    int32_t result = SQLITE_OK;
+    tSL_DictionaryCache* cache = (tSL_DictionaryCache*)sqlite3_malloc(sizeof(tSL_DictionaryCache));
+
+    // SQLite owns the cache from here on, even if registration fails
+    if (cache != NULL)
+        memset((void*)cache, 0, sizeof(tSL_DictionaryCache));
+    result = (cache == NULL) ? SQLITE_NOMEM :
+        sqlite3_create_function_v2(database, SL_DECOMPRESS_FUNCTION_NAME, 1,
+                                   SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS,
+                                   (void*)cache, SL_DecompressFunction, NULL, NULL,
+                                   SL_DestroyDictionaryCache);
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, sqlite3_create_function_v2 failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
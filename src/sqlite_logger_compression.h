@@ -0,0 +1,121 @@
+// =================================================================================================
+//! @file sqlite_logger_compression.h
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the private interface for SQLite Logger column compression.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-10
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#ifndef __SQLITE_LOGGER_COMPRESSION_H__
+#define __SQLITE_LOGGER_COMPRESSION_H__
+
+#include "sqlite_logger.h"
+#include "sqlite3.h"
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+//  First byte of a compressed column value
+#define SL_COMPRESSED_VALUE_MARKER              0xC5
+
+//  First byte of a column value compressed with a dictionary
+#define SL_DICTIONARY_COMPRESSED_VALUE_MARKER   0xC6
+
+//  Maximum size of the header that precedes compressed column data
+#define SL_COMPRESSED_VALUE_HEADER_SIZE         16
+
+//  Name of the SQL function that decompresses column values
+#define SL_DECOMPRESS_FUNCTION_NAME             "sl_decompress"
+
+//  Name of the table that holds compression dictionaries
+#define SL_DICTIONARY_TABLE_NAME                "log dictionaries"
+
+//  Dictionary limits
+#define SL_MAX_DICTIONARY_SIZE                  (16 * 1024)
+#define SL_DICTIONARY_SAMPLE_COUNT              256
+#define SL_DICTIONARY_SAMPLE_LENGTH             256
+
+//  Match finder hash table size
+#define SL_COMPRESSION_HASH_LOG                 12
+#define SL_COMPRESSION_HASH_TABLE_SIZE          (1 << SL_COMPRESSION_HASH_LOG)
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+//  Compression dictionary
+typedef struct tsl_compressiondictionary
+{
+    int64_t     id;
+    size_t      size;
+    uint8_t     content[SL_MAX_DICTIONARY_SIZE];
+    uint32_t    hashTable[SL_COMPRESSION_HASH_TABLE_SIZE];
+}
+tSL_CompressionDictionary;
+
+//  Sample of recent column values used to train a dictionary
+typedef struct tsl_dictionarytrainer
+{
+    char        samples[SL_DICTIONARY_SAMPLE_COUNT][SL_DICTIONARY_SAMPLE_LENGTH];
+    uint16_t    sampleLengths[SL_DICTIONARY_SAMPLE_COUNT];
+    uint32_t    sampleCount;
+}
+tSL_DictionaryTrainer;
+
+// =================================================================================================
+//  Prototypes
+// =================================================================================================
+
+//  Writes a varint (at most 10 bytes) and returns its size
+size_t SL_WriteVarint (uint8_t* destination, uint64_t value);
+
+//  Reads a varint at position, and advances position past it; fails with EILSEQ if malformed
+int32_t SL_ReadVarint (const uint8_t* source,
+                       size_t sourceSize,
+                       size_t* position,
+                       uint64_t* value);
+
+//  Returns the worst case size of a compressed value (including its header)
+size_t SL_CompressBound (size_t sourceSize);
+
+//  Compresses source into destination as a column value (optionally against a dictionary);
+//  fails with ENOSPC if it doesn't fit
+int32_t SL_CompressValue (const tSL_CompressionDictionary* dictionary,
+                          const uint8_t* source,
+                          size_t sourceSize,
+                          uint8_t* destination,
+                          size_t destinationCapacity,
+                          size_t* compressedSize);
+
+//  Gets the id of the dictionary a column value was compressed with (0 if none)
+int32_t SL_GetCompressedValueDictionaryId (const uint8_t* source,
+                                           size_t sourceSize,
+                                           int64_t* dictionaryId);
+
+//  Decompresses a column value; the caller frees the returned text with sqlite3_free
+int32_t SL_DecompressValue (const uint8_t* dictionary,
+                            size_t dictionarySize,
+                            const uint8_t* source,
+                            size_t sourceSize,
+                            char** text,
+                            size_t* textSize);
+
+//  Adds a column value to the dictionary training sample
+void SL_AddDictionarySample (tSL_DictionaryTrainer* trainer,
+                             const char* text,
+                             size_t length);
+
+//  Trains a dictionary from the training sample (the caller assigns the dictionary id)
+int32_t SL_TrainDictionary (const tSL_DictionaryTrainer* trainer,
+                            tSL_CompressionDictionary* dictionary);
+
+//  Registers the sl_decompress SQL function with a database connection
+int32_t SL_RegisterCompressionFunctions (sqlite3* database);
+
+// =================================================================================================
+#endif	// __SQLITE_LOGGER_COMPRESSION_H__
+// =================================================================================================
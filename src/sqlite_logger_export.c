@@ -0,0 +1,762 @@
+// =================================================================================================
+//! @file sqlite_logger_export.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the implementation of SQLite Logger log export.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-18
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sqlite_logger.h"
+#include "sqlite_logger_archive.h"
+#include "sqlite_logger_compression.h"
+#include "sqlite_logger_export.h"
+#include "sqlite3.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Where to direct fprintf output
+#define SL_TERMINAL                 stderr
+
+//  Size of the output file buffers
+#define SL_EXPORT_BUFFER_SIZE       (1024 * 1024)
+
+//  Most threads an export can use
+#define SL_MAX_EXPORT_THREADS       64
+
+//  Most log ids in a range exported by more than one thread (so a range's rows can be formatted
+//  in memory)
+#define SL_EXPORT_RANGE_SIZE        4096
+
+//  Ranges in flight for each export thread (so formatting overlaps writing)
+#define SL_EXPORT_SLOTS_PER_THREAD  2
+
+//  Slot states
+#define SL_EXPORT_SLOT_EMPTY        0
+#define SL_EXPORT_SLOT_FORMATTING   1
+#define SL_EXPORT_SLOT_FORMATTED    2
+
+//  Name of the column that identifies the log table of an exported row
+#define SL_EXPORT_TABLE_COLUMN_NAME "log_table"
+
+//  Name of the column that identifies the log file of a merged row
+#define SL_EXPORT_SOURCE_COLUMN_NAME "log_source"
+
+//  SQL command to select the log tables (and archived log tables) to export; a session that
+//  started after the end of the time range has nothing to export
+static const char* kSL_SelectExportTablesSQLCommandString =
+    "SELECT m.name FROM sqlite_master AS m WHERE m.name GLOB 'log at [0-9]*' AND (?1 IS NULL OR m.name = ?1) AND (?2 IS NULL OR substr(m.name, 8) < ?2) AND ((m.type = 'table' AND EXISTS (SELECT 1 FROM pragma_table_info(m.name) AS c WHERE c.name = 'log_message')) OR (m.type = 'view' AND m.sql GLOB '*FROM " SL_ARCHIVE_MODULE_NAME "(*')) ORDER BY m.name";
+
+//  Hexadecimal digits for BLOB values
+static const char* kSL_HexDigits = "0123456789abcdef";
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+//  A range of rows of one log table
+typedef struct tsl_exportrange
+{
+    char*       tableName;
+    char*       columns;
+    int64_t     firstId;
+    int64_t     lastId;
+}
+tSL_ExportRange;
+
+//  The formatted rows of a range
+typedef struct tsl_exportslot
+{
+    uint32_t    state;
+    char*       data;
+    size_t      size;
+    int32_t     result;
+}
+tSL_ExportSlot;
+
+//  The ranges the export threads format, and the slots they format them into (range i is
+//  formatted into slot i modulo the slot count)
+typedef struct tsl_exportqueue
+{
+    const char*                 logPath;
+    const tSL_ExportOptions*    options;
+    const tSL_ExportRange*      ranges;
+    uint32_t                    rangeCount;
+    uint32_t                    nextRange;
+    pthread_mutex_t             mutex;
+    pthread_cond_t              slotFormatted;
+    pthread_cond_t              slotEmpty;
+    tSL_ExportSlot              slots[SL_MAX_EXPORT_THREADS * SL_EXPORT_SLOTS_PER_THREAD];
+    uint32_t                    slotCount;
+    bool                        stopping;
+}
+tSL_ExportQueue;
+
+// =================================================================================================
+//  Private globals
+// =================================================================================================
+
+//  The mmap_size of the connections opened by SL_OpenExportDatabase
+static uint64_t gExportMemoryMapSize = 0;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+static int32_t SL_SelectExportRanges (sqlite3* database,
+                                      const tSL_ExportOptions* options,
+                                      tSL_ExportRange** ranges,
+                                      uint32_t* rangeCount);
+
+static void SL_FreeExportRanges (tSL_ExportRange* ranges, uint32_t rangeCount);
+
+static void SL_WriteJSONString (FILE* output, const unsigned char* text, int size);
+
+static void SL_WriteCSVString (FILE* output, const unsigned char* text, int size);
+
+static int32_t SL_WriteExportRange (sqlite3* database,
+                                    FILE* output,
+                                    const tSL_ExportOptions* options,
+                                    const tSL_ExportRange* range);
+
+static int32_t SL_FormatExportRange (sqlite3* database,
+                                     const tSL_ExportOptions* options,
+                                     const tSL_ExportRange* range,
+                                     tSL_ExportSlot* slot);
+
+static void* SL_ExportThread (void* argument);
+
+// =================================================================================================
+//  SL_Export
+// =================================================================================================
+int32_t SL_Export (const char* logPath, const char* outputPath, const tSL_ExportOptions* options)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    sqlite3* database = NULL;
+    tSL_ExportRange* ranges = NULL;
+    uint32_t rangeCount = 0;
+    tSL_ExportQueue queue;
+    pthread_t threads[SL_MAX_EXPORT_THREADS];
+    bool threadStarted[SL_MAX_EXPORT_THREADS] = {false};
+    uint32_t threadCount = 0;
+    FILE* output = NULL;
+    char* outputBuffer = NULL;
+    uint_fast32_t i = 0;
+
+    memset((void*)&queue, 0, sizeof(queue));
+
+    // Check arguments
+    if ((logPath == NULL) || (outputPath == NULL) || (options == NULL))
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_Export has a NULL argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if ((options->format != eSL_ExportFormat_NDJSON) && (options->format != eSL_ExportFormat_CSV))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, export format %d is invalid.\n",
+                __LINE__, __FUNCTION__, options->format);
+    }
+    else
+    {
+        threadCount = options->threadCount;
+        if (threadCount == 0)
+            threadCount = 1;
+        else if (threadCount > SL_MAX_EXPORT_THREADS)
+            threadCount = SL_MAX_EXPORT_THREADS;
+
+        // Split the log tables into ranges of log ids
+        result = SL_OpenExportDatabase(logPath, &database);
+        if (result == SQLITE_OK)
+        {
+            tSL_ExportOptions splitOptions = *options;
+
+            splitOptions.threadCount = threadCount;
+            result = SL_SelectExportRanges(database, &splitOptions, &ranges, &rangeCount);
+        }
+        if (result == SQLITE_OK)
+            result = SL_OpenExportFile(outputPath, "wb", &output, &outputBuffer);
+        if (result == SQLITE_OK)
+            SL_WriteExportHeader(output, options->format, false);
+
+        // A single thread writes the ranges straight to the output file; more than one format
+        // the ranges in memory, in parallel, and the calling thread writes them in order
+        if ((result == SQLITE_OK) && (threadCount == 1))
+        {
+            for (i = 0; (i < rangeCount) && (result == SQLITE_OK); i++)
+                result = SL_WriteExportRange(database, output, options, &(ranges[i]));
+        }
+        else if (result == SQLITE_OK)
+        {
+            queue.logPath = logPath;
+            queue.options = options;
+            queue.ranges = ranges;
+            queue.rangeCount = rangeCount;
+            queue.slotCount = threadCount * SL_EXPORT_SLOTS_PER_THREAD;
+            (void)pthread_mutex_init(&(queue.mutex), NULL);
+            (void)pthread_cond_init(&(queue.slotFormatted), NULL);
+            (void)pthread_cond_init(&(queue.slotEmpty), NULL);
+            for (i = 0; (i < threadCount) && (result == SQLITE_OK); i++)
+            {
+                result = pthread_create(&(threads[i]), NULL, SL_ExportThread, (void*)&queue);
+                if (result == 0)
+                    threadStarted[i] = true;
+                else
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, pthread_create failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+            for (i = 0; (i < rangeCount) && (result == SQLITE_OK); i++)
+            {
+                tSL_ExportSlot* slot = &(queue.slots[i % queue.slotCount]);
+
+                (void)pthread_mutex_lock(&(queue.mutex));
+                while (slot->state != SL_EXPORT_SLOT_FORMATTED)
+                    (void)pthread_cond_wait(&(queue.slotFormatted), &(queue.mutex));
+                (void)pthread_mutex_unlock(&(queue.mutex));
+
+                result = slot->result;
+                if (result == SQLITE_OK)
+                    (void)fwrite((const void*)slot->data, 1, slot->size, output);
+                free((void*)slot->data);
+                slot->data = NULL;
+
+                // Hand the slot back to the export threads
+                (void)pthread_mutex_lock(&(queue.mutex));
+                slot->state = SL_EXPORT_SLOT_EMPTY;
+                (void)pthread_cond_broadcast(&(queue.slotEmpty));
+                (void)pthread_mutex_unlock(&(queue.mutex));
+            }
+
+            (void)pthread_mutex_lock(&(queue.mutex));
+            queue.stopping = true;
+            (void)pthread_cond_broadcast(&(queue.slotEmpty));
+            (void)pthread_mutex_unlock(&(queue.mutex));
+            for (i = 0; i < threadCount; i++)
+            {
+                if (threadStarted[i])
+                    (void)pthread_join(threads[i], NULL);
+            }
+            for (i = 0; i < queue.slotCount; i++)
+                free((void*)(queue.slots[i].data));
+            (void)pthread_cond_destroy(&(queue.slotEmpty));
+            (void)pthread_cond_destroy(&(queue.slotFormatted));
+            (void)pthread_mutex_destroy(&(queue.mutex));
+        }
+        if (output != NULL)
+            result = SL_CloseExportFile(output, outputBuffer, result);
+
+        SL_FreeExportRanges(ranges, rangeCount);
+        (void)sqlite3_close(database);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_OpenExportDatabase
+// =================================================================================================
+int32_t SL_OpenExportDatabase (const char* logPath, sqlite3** database)
+{
+    int32_t result = sqlite3_open_v2(logPath, database, SQLITE_OPEN_READONLY, NULL);
+
+    // Pages are read straight from the file's memory map, instead of being copied by read()
+    if ((result == SQLITE_OK) && (gExportMemoryMapSize > 0))
+        result = SL_SetDatabaseMemoryMapSize(*database, gExportMemoryMapSize);
+
+    // Compressed values and archived tables are read with the SQLite Logger functions
+    if (result == SQLITE_OK)
+        result = SL_RegisterCompressionFunctions(*database);
+    if (result == SQLITE_OK)
+        result = SL_RegisterArchiveModule(*database);
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, opening %s failed with result %d.\n",
+                __LINE__, __FUNCTION__, logPath, result);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetExportMemoryMapSize
+// =================================================================================================
+void SL_SetExportMemoryMapSize (uint64_t size)
+{
+    gExportMemoryMapSize = size;
+}
+
+// =================================================================================================
+//  SL_SetDatabaseMemoryMapSize
+// =================================================================================================
+int32_t SL_SetDatabaseMemoryMapSize (sqlite3* database, uint64_t size)
+{
+    char cmdString[64] = {0};
+
+    snprintf(cmdString, sizeof(cmdString), "PRAGMA mmap_size = %llu;", (unsigned long long)size);
+
+    return sqlite3_exec(database, cmdString, NULL, NULL, NULL);
+}
+
+// =================================================================================================
+//  SL_PrepareLogTableSelect
+// =================================================================================================
+int32_t SL_PrepareLogTableSelect (sqlite3* database,
+                                  const char* tableName,
+                                  const char* endTime,
+                                  sqlite3_stmt** statement)
+{
+    int32_t result = sqlite3_prepare_v2(database, kSL_SelectExportTablesSQLCommandString, -1,
+                                        statement, NULL);
+
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(*statement, 1, tableName, -1, SQLITE_STATIC);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(*statement, 2, endTime, -1, SQLITE_STATIC);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_OpenExportFile
+// =================================================================================================
+int32_t SL_OpenExportFile (const char* path, const char* mode, FILE** file, char** buffer)
+{
+    int32_t result = SQLITE_OK;
+
+    *buffer = (char*)malloc(SL_EXPORT_BUFFER_SIZE);
+    if (*buffer == NULL)
+        result = SQLITE_NOMEM;
+    else
+    {
+        *file = fopen(path, mode);
+        if (*file == NULL)
+        {
+            result = errno;
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, fopen of %s failed with result %d.\n",
+                    __LINE__, __FUNCTION__, path, result);
+            free((void*)*buffer);
+            *buffer = NULL;
+        }
+        else
+            (void)setvbuf(*file, *buffer, _IOFBF, SL_EXPORT_BUFFER_SIZE);
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_CloseExportFile
+// =================================================================================================
+int32_t SL_CloseExportFile (FILE* file, char* buffer, int32_t result)
+{
+    // Write errors are sticky, so they're only checked once
+    if ((result == SQLITE_OK) && ferror(file))
+        result = EIO;
+    if ((fclose(file) != 0) && (result == SQLITE_OK))
+        result = errno;
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, export failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+    free((void*)buffer);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SelectExportRanges
+// =================================================================================================
+int32_t SL_SelectExportRanges (sqlite3* database,
+                               const tSL_ExportOptions* options,
+                               tSL_ExportRange** ranges,
+                               uint32_t* rangeCount)
+{
+    int32_t result = SQLITE_OK;
+    sqlite3_stmt* statement = NULL;
+    uint32_t capacity = 0;
+
+    result = SL_PrepareLogTableSelect(database, options->tableName, options->endTime, &statement);
+    while ((result == SQLITE_OK) && ((result = sqlite3_step(statement)) == SQLITE_ROW))
+    {
+        const char* tableName = (const char*)sqlite3_column_text(statement, 0);
+        char* columns = NULL;
+        char* cmdString = NULL;
+        sqlite3_stmt* boundsStatement = NULL;
+        int64_t firstId = 0;
+        int64_t lastId = -1;
+        uint_fast32_t i = 0;
+
+        // Find the log ids of the table
+        result = SL_BuildLogColumnList(database, tableName, &columns);
+        if (result == SQLITE_OK)
+        {
+            cmdString = sqlite3_mprintf("SELECT MIN(log_id), MAX(log_id) FROM \"%w\"", tableName);
+            result = (cmdString == NULL) ? SQLITE_NOMEM :
+                sqlite3_prepare_v2(database, cmdString, -1, &boundsStatement, NULL);
+        }
+        if ((result == SQLITE_OK) && (sqlite3_step(boundsStatement) == SQLITE_ROW) &&
+            (sqlite3_column_type(boundsStatement, 0) != SQLITE_NULL))
+        {
+            firstId = sqlite3_column_int64(boundsStatement, 0);
+            lastId = sqlite3_column_int64(boundsStatement, 1);
+        }
+        (void)sqlite3_finalize(boundsStatement);
+        sqlite3_free((void*)cmdString);
+
+        // Split the log ids into ranges that can be formatted in memory, when there's more than
+        // one thread (an empty table has no ranges)
+        if ((result == SQLITE_OK) && (lastId >= firstId))
+        {
+            uint64_t span = (uint64_t)(lastId - firstId) + 1;
+            uint32_t splitCount = (options->threadCount > 1) ?
+                (uint32_t)((span + SL_EXPORT_RANGE_SIZE - 1) / SL_EXPORT_RANGE_SIZE) : 1;
+
+            if ((*rangeCount + splitCount) > capacity)
+            {
+                tSL_ExportRange* newRanges = NULL;
+
+                capacity = (*rangeCount + splitCount) * 2;
+                newRanges = (tSL_ExportRange*)realloc((void*)*ranges, capacity * sizeof(tSL_ExportRange));
+                if (newRanges == NULL)
+                    result = SQLITE_NOMEM;
+                else
+                    *ranges = newRanges;
+            }
+            for (i = 0; (i < splitCount) && (result == SQLITE_OK); i++)
+            {
+                tSL_ExportRange* range = &((*ranges)[*rangeCount]);
+
+                range->firstId = firstId + (int64_t)((span * i) / splitCount);
+                range->lastId = firstId + (int64_t)((span * (i + 1)) / splitCount) - 1;
+                range->tableName = sqlite3_mprintf("%s", tableName);
+                range->columns = sqlite3_mprintf("%s", columns);
+                (*rangeCount)++;
+                if ((range->tableName == NULL) || (range->columns == NULL))
+                    result = SQLITE_NOMEM;
+            }
+        }
+        sqlite3_free((void*)columns);
+    }
+    if (result == SQLITE_DONE)
+        result = SQLITE_OK; // Eat this result code
+    else
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, selecting log tables failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+    (void)sqlite3_finalize(statement);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_FreeExportRanges
+// =================================================================================================
+void SL_FreeExportRanges (tSL_ExportRange* ranges, uint32_t rangeCount)
+{
+    uint_fast32_t i = 0;
+
+    for (i = 0; i < rangeCount; i++)
+    {
+        sqlite3_free((void*)(ranges[i].tableName));
+        sqlite3_free((void*)(ranges[i].columns));
+    }
+    free((void*)ranges);
+
+    return;
+}
+
+// =================================================================================================
+//  SL_WriteJSONString
+// =================================================================================================
+void SL_WriteJSONString (FILE* output, const unsigned char* text, int size)
+{
+    int i = 0;
+
+    putc('"', output);
+    for (i = 0; i < size; i++)
+    {
+        unsigned char c = text[i];
+
+        if ((c == '"') || (c == '\\'))
+        {
+            putc('\\', output);
+            putc(c, output);
+        }
+        else if (c == '\n')
+            fputs("\\n", output);
+        else if (c == '\r')
+            fputs("\\r", output);
+        else if (c == '\t')
+            fputs("\\t", output);
+        else if (c < 0x20)
+            fprintf(output, "\\u%04x", c);
+        else
+            putc(c, output);
+    }
+    putc('"', output);
+
+    return;
+}
+
+// =================================================================================================
+//  SL_WriteCSVString
+// =================================================================================================
+void SL_WriteCSVString (FILE* output, const unsigned char* text, int size)
+{
+    bool quote = false;
+    int i = 0;
+
+    // Values are only quoted when they need to be (RFC 4180)
+    for (i = 0; (i < size) && !quote; i++)
+        quote = (text[i] == ',') || (text[i] == '"') || (text[i] == '\r') || (text[i] == '\n');
+    if (!quote)
+        (void)fwrite((const void*)text, 1, (size_t)size, output);
+    else
+    {
+        putc('"', output);
+        for (i = 0; i < size; i++)
+        {
+            if (text[i] == '"')
+                putc('"', output);
+            putc(text[i], output);
+        }
+        putc('"', output);
+    }
+    return;
+}
+
+// =================================================================================================
+//  SL_WriteExportHeader
+// =================================================================================================
+void SL_WriteExportHeader (FILE* output, tSL_ExportFormat format, bool hasSource)
+{
+    uint_fast32_t i = 0;
+
+    if (format == eSL_ExportFormat_CSV)
+    {
+        if (hasSource)
+            fputs(SL_EXPORT_SOURCE_COLUMN_NAME ",", output);
+        fputs(SL_EXPORT_TABLE_COLUMN_NAME, output);
+        for (i = 0; i < SL_LOG_COLUMN_COUNT; i++)
+            fprintf(output, ",%s", SL_GetLogColumnName((uint32_t)i));
+        fputs("\r\n", output);
+    }
+    return;
+}
+
+// =================================================================================================
+//  SL_WriteExportRow
+// =================================================================================================
+void SL_WriteExportRow (FILE* output,
+                        tSL_ExportFormat format,
+                        const char* sourceName,
+                        const char* tableName,
+                        sqlite3_value** values)
+{
+    uint_fast32_t i = 0;
+    int j = 0;
+
+    if (format == eSL_ExportFormat_NDJSON)
+    {
+        putc('{', output);
+        if (sourceName != NULL)
+        {
+            fputs("\"" SL_EXPORT_SOURCE_COLUMN_NAME "\":", output);
+            SL_WriteJSONString(output, (const unsigned char*)sourceName, (int)strlen(sourceName));
+            putc(',', output);
+        }
+        fputs("\"" SL_EXPORT_TABLE_COLUMN_NAME "\":", output);
+        SL_WriteJSONString(output, (const unsigned char*)tableName, (int)strlen(tableName));
+    }
+    else
+    {
+        if (sourceName != NULL)
+        {
+            SL_WriteCSVString(output, (const unsigned char*)sourceName, (int)strlen(sourceName));
+            putc(',', output);
+        }
+        SL_WriteCSVString(output, (const unsigned char*)tableName, (int)strlen(tableName));
+    }
+
+    for (i = 0; i < SL_LOG_COLUMN_COUNT; i++)
+    {
+        int type = sqlite3_value_type(values[i]);
+
+        // NDJSON rows leave out NULL columns
+        if ((format == eSL_ExportFormat_NDJSON) && (type != SQLITE_NULL))
+            fprintf(output, ",\"%s\":", SL_GetLogColumnName((uint32_t)i));
+        else if (format == eSL_ExportFormat_CSV)
+            putc(',', output);
+
+        if (type == SQLITE_INTEGER)
+            fprintf(output, "%lld", (long long)sqlite3_value_int64(values[i]));
+        else if (type == SQLITE_FLOAT)
+            fprintf(output, "%.17g", sqlite3_value_double(values[i]));
+        else if (type == SQLITE_TEXT)
+        {
+            const unsigned char* text = sqlite3_value_text(values[i]);
+            int size = sqlite3_value_bytes(values[i]);
+
+            if (format == eSL_ExportFormat_NDJSON)
+                SL_WriteJSONString(output, text, size);
+            else
+                SL_WriteCSVString(output, text, size);
+        }
+        else if (type == SQLITE_BLOB)
+        {
+            const unsigned char* blob = (const unsigned char*)sqlite3_value_blob(values[i]);
+            int size = sqlite3_value_bytes(values[i]);
+
+            // BLOBs are written as hexadecimal text
+            if (format == eSL_ExportFormat_NDJSON)
+                putc('"', output);
+            for (j = 0; j < size; j++)
+            {
+                putc(kSL_HexDigits[blob[j] >> 4], output);
+                putc(kSL_HexDigits[blob[j] & 0x0F], output);
+            }
+            if (format == eSL_ExportFormat_NDJSON)
+                putc('"', output);
+        }
+    }
+    fputs((format == eSL_ExportFormat_NDJSON) ? "}\n" : "\r\n", output);
+
+    return;
+}
+
+// =================================================================================================
+//  SL_WriteExportRange
+// =================================================================================================
+int32_t SL_WriteExportRange (sqlite3* database,
+                             FILE* output,
+                             const tSL_ExportOptions* options,
+                             const tSL_ExportRange* range)
+{
+    int32_t result = SQLITE_OK;
+    sqlite3_stmt* statement = NULL;
+    char* cmdString = NULL;
+
+    // The rows are read with a single forward-only scan
+    cmdString = sqlite3_mprintf("SELECT %s FROM \"%w\" WHERE log_id BETWEEN ?1 AND ?2 AND (?3 IS NULL OR log_timestamp >= ?3) AND (?4 IS NULL OR log_timestamp < ?4) ORDER BY log_id",
+                                range->columns, range->tableName);
+    if (cmdString == NULL)
+        result = SQLITE_NOMEM;
+    else
+        result = sqlite3_prepare_v2(database, cmdString, -1, &statement, NULL);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_int64(statement, 1, range->firstId);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_int64(statement, 2, range->lastId);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(statement, 3, options->startTime, -1, SQLITE_STATIC);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(statement, 4, options->endTime, -1, SQLITE_STATIC);
+    while ((result == SQLITE_OK) && ((result = sqlite3_step(statement)) == SQLITE_ROW))
+    {
+        sqlite3_value* values[SL_LOG_COLUMN_COUNT];
+        uint_fast32_t i = 0;
+
+        // Each connection is only used by one thread, so its column values are read without a lock
+        for (i = 0; i < SL_LOG_COLUMN_COUNT; i++)
+            values[i] = sqlite3_column_value(statement, (int)i);
+        SL_WriteExportRow(output, options->format, NULL, range->tableName, values);
+        result = SQLITE_OK;
+    }
+    if (result == SQLITE_DONE)
+        result = SQLITE_OK; // Eat this result code
+    else
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, exporting %s failed with result %d.\n",
+                __LINE__, __FUNCTION__, range->tableName, result);
+    (void)sqlite3_finalize(statement);
+    sqlite3_free((void*)cmdString);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_FormatExportRange
+// =================================================================================================
+int32_t SL_FormatExportRange (sqlite3* database,
+                              const tSL_ExportOptions* options,
+                              const tSL_ExportRange* range,
+                              tSL_ExportSlot* slot)
+{
+    int32_t result = SQLITE_OK;
+    FILE* output = NULL;
+
+    // The rows are written to a memory stream, whose buffer is the slot's data once it's closed
+    output = open_memstream(&(slot->data), &(slot->size));
+    if (output == NULL)
+    {
+        result = errno;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, open_memstream failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+    }
+    else
+    {
+        result = SL_WriteExportRange(database, output, options, range);
+        if (ferror(output) && (result == SQLITE_OK))
+            result = SQLITE_NOMEM;
+        if ((fclose(output) != 0) && (result == SQLITE_OK))
+            result = SQLITE_NOMEM;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ExportThread
+// =================================================================================================
+void* SL_ExportThread (void* argument)
+{
+    tSL_ExportQueue* queue = (tSL_ExportQueue*)argument;
+    sqlite3* database = NULL;
+    int32_t result = SQLITE_OK;
+
+    // Each thread reads with its own connection; the threads take turns claiming ranges (in
+    // order), and format them in parallel
+    result = SL_OpenExportDatabase(queue->logPath, &database);
+    (void)pthread_mutex_lock(&(queue->mutex));
+    while (!queue->stopping && (queue->nextRange < queue->rangeCount))
+    {
+        tSL_ExportSlot* slot = &(queue->slots[queue->nextRange % queue->slotCount]);
+
+        if (slot->state != SL_EXPORT_SLOT_EMPTY)
+            (void)pthread_cond_wait(&(queue->slotEmpty), &(queue->mutex));
+        else
+        {
+            const tSL_ExportRange* range = &(queue->ranges[queue->nextRange]);
+
+            slot->state = SL_EXPORT_SLOT_FORMATTING;
+            queue->nextRange++;
+            (void)pthread_mutex_unlock(&(queue->mutex));
+
+            if (result == SQLITE_OK)
+                slot->result = SL_FormatExportRange(database, queue->options, range, slot);
+            else
+                slot->result = result;
+
+            (void)pthread_mutex_lock(&(queue->mutex));
+            slot->state = SL_EXPORT_SLOT_FORMATTED;
+            (void)pthread_cond_broadcast(&(queue->slotFormatted));
+        }
+    }
+    (void)pthread_mutex_unlock(&(queue->mutex));
+    (void)sqlite3_close(database);
+
+    return NULL;
+}
+
+// =================================================================================================
@@ -0,0 +1,62 @@
+// =================================================================================================
+//! @file sqlite_logger_export.h
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the private interface for SQLite Logger log export.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-23
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#ifndef __SQLITE_LOGGER_EXPORT_H__
+#define __SQLITE_LOGGER_EXPORT_H__
+
+#include <stdio.h>
+#include "sqlite_logger.h"
+#include "sqlite3.h"
+
+// =================================================================================================
+//  Prototypes
+// =================================================================================================
+
+//  Opens a log file read-only, with the functions that read compressed values and archived
+//  tables
+int32_t SL_OpenExportDatabase (const char* logPath, sqlite3** database);
+
+//  Sets the mmap_size of the log files opened by SL_OpenExportDatabase from now on (0 reads
+//  them with read())
+void SL_SetExportMemoryMapSize (uint64_t size);
+
+//  Sets the mmap_size of a database connection
+int32_t SL_SetDatabaseMemoryMapSize (sqlite3* database, uint64_t size);
+
+//  Prepares a statement that selects the log tables (and archived log tables) of a log file, in
+//  session order; a NULL table name selects every session, and sessions that started at or
+//  after the end time (if not NULL) are left out
+int32_t SL_PrepareLogTableSelect (sqlite3* database,
+                                  const char* tableName,
+                                  const char* endTime,
+                                  sqlite3_stmt** statement);
+
+//  Opens an output file with a large buffer; the file is closed with SL_CloseExportFile
+int32_t SL_OpenExportFile (const char* path, const char* mode, FILE** file, char** buffer);
+
+//  Closes an output file, and returns the first error of the export (or of the file)
+int32_t SL_CloseExportFile (FILE* file, char* buffer, int32_t result);
+
+//  Writes the CSV header line (NDJSON has none); the source column is only written when rows
+//  have a source
+void SL_WriteExportHeader (FILE* output, tSL_ExportFormat format, bool hasSource);
+
+//  Writes a row of log table column values (in SL_GetLogColumnName order); a NULL source name
+//  leaves out the source column
+void SL_WriteExportRow (FILE* output,
+                        tSL_ExportFormat format,
+                        const char* sourceName,
+                        const char* tableName,
+                        sqlite3_value** values);
+
+// =================================================================================================
+#endif	// __SQLITE_LOGGER_EXPORT_H__
+// =================================================================================================
@@ -0,0 +1,909 @@
+// =================================================================================================
+//! @file sqlite_logger_import.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the implementation of SQLite Logger log import parsing.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-21
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sqlite_logger_import.h"
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Where to direct fprintf output
+#define SL_TERMINAL                     stderr
+
+//  Blocks in flight for each parser thread (so parsing overlaps writing)
+#define SL_IMPORT_SLOTS_PER_THREAD      2
+
+//  Block states
+#define SL_IMPORT_SLOT_EMPTY            0
+#define SL_IMPORT_SLOT_PARSING          1
+#define SL_IMPORT_SLOT_PARSED           2
+
+//  Initial number of records in a block
+#define SL_IMPORT_RECORD_CAPACITY       4096
+
+//  Field identifiers
+#define SL_IMPORT_FIELD_NONE            0
+#define SL_IMPORT_FIELD_TIMESTAMP       1
+#define SL_IMPORT_FIELD_MESSAGE         2
+#define SL_IMPORT_FIELD_LEVEL           3
+#define SL_IMPORT_FIELD_FILE_NAME       4
+#define SL_IMPORT_FIELD_FUNCTION_NAME   5
+#define SL_IMPORT_FIELD_LINE_NUMBER     6
+#define SL_IMPORT_FIELD_TAG             7
+#define SL_IMPORT_FIELD_SUPPLEMENTAL    8
+#define SL_IMPORT_FIELD_REPEAT_COUNT    9
+#define SL_IMPORT_FIELD_LAST_TIMESTAMP  10
+#define SL_IMPORT_FIELD_SAMPLE_RATE     11
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+//  A name that maps to a log level or a field
+typedef struct tsl_importname
+{
+    const char*     name;
+    int             value;
+}
+tSL_ImportName;
+
+//  A block of input and its parsed records
+typedef struct tsl_importslot
+{
+    uint32_t            state;
+    char*               data;
+    size_t              size;
+    size_t              capacity;
+    tSL_ImportRecord*   records;
+    uint32_t            recordCount;
+    uint32_t            recordCapacity;
+    uint64_t            skippedCount;
+    int32_t             result;
+}
+tSL_ImportSlot;
+
+//  Import reader
+struct tsl_importreader
+{
+    FILE*               input;
+    tSL_ImportFormat    format;
+    pthread_mutex_t     mutex;
+    pthread_cond_t      slotParsed;
+    pthread_cond_t      slotEmpty;
+    tSL_ImportSlot      slots[SL_MAX_IMPORT_THREADS * SL_IMPORT_SLOTS_PER_THREAD];
+    uint32_t            slotCount;
+    uint32_t            fillIndex;
+    uint32_t            readIndex;
+    bool                held;
+    char*               carry;
+    size_t              carrySize;
+    size_t              carryCapacity;
+    bool                endOfInput;
+    bool                stopping;
+    int32_t             result;
+    pthread_t           threads[SL_MAX_IMPORT_THREADS];
+    uint32_t            threadCount;
+    uint64_t            skippedCount;
+};
+
+// =================================================================================================
+//  Private name tables
+// =================================================================================================
+
+//  Log level names used by common logging libraries (matched without regard to case)
+static const tSL_ImportName kSL_ImportLevelNames[] = {
+    {"diagnostic",  eSL_LogLevel_Diagnostic},
+    {"debug",       eSL_LogLevel_Diagnostic},
+    {"trace",       eSL_LogLevel_Diagnostic},
+    {"detail",      eSL_LogLevel_Detail},
+    {"verbose",     eSL_LogLevel_Detail},
+    {"info",        eSL_LogLevel_Info},
+    {"information", eSL_LogLevel_Info},
+    {"notice",      eSL_LogLevel_Info},
+    {"warning",     eSL_LogLevel_Warning},
+    {"warn",        eSL_LogLevel_Warning},
+    {"error",       eSL_LogLevel_Error},
+    {"err",         eSL_LogLevel_Error},
+    {"critical",    eSL_LogLevel_Error},
+    {"crit",        eSL_LogLevel_Error},
+    {"fatal",       eSL_LogLevel_Error},
+    {NULL,          0}
+};
+
+//  NDJSON field names (log table column names, and names used by common logging libraries)
+static const tSL_ImportName kSL_ImportFieldNames[] = {
+    {"log_timestamp",           SL_IMPORT_FIELD_TIMESTAMP},
+    {"timestamp",               SL_IMPORT_FIELD_TIMESTAMP},
+    {"@timestamp",              SL_IMPORT_FIELD_TIMESTAMP},
+    {"time",                    SL_IMPORT_FIELD_TIMESTAMP},
+    {"ts",                      SL_IMPORT_FIELD_TIMESTAMP},
+    {"log_message",             SL_IMPORT_FIELD_MESSAGE},
+    {"message",                 SL_IMPORT_FIELD_MESSAGE},
+    {"msg",                     SL_IMPORT_FIELD_MESSAGE},
+    {"log_level",               SL_IMPORT_FIELD_LEVEL},
+    {"level",                   SL_IMPORT_FIELD_LEVEL},
+    {"severity",                SL_IMPORT_FIELD_LEVEL},
+    {"log_filename",            SL_IMPORT_FIELD_FILE_NAME},
+    {"filename",                SL_IMPORT_FIELD_FILE_NAME},
+    {"file",                    SL_IMPORT_FIELD_FILE_NAME},
+    {"log_functionname",        SL_IMPORT_FIELD_FUNCTION_NAME},
+    {"function",                SL_IMPORT_FIELD_FUNCTION_NAME},
+    {"func",                    SL_IMPORT_FIELD_FUNCTION_NAME},
+    {"log_linenumber",          SL_IMPORT_FIELD_LINE_NUMBER},
+    {"line",                    SL_IMPORT_FIELD_LINE_NUMBER},
+    {"lineno",                  SL_IMPORT_FIELD_LINE_NUMBER},
+    {"log_tag",                 SL_IMPORT_FIELD_TAG},
+    {"tag",                     SL_IMPORT_FIELD_TAG},
+    {"log_supplementaldata",    SL_IMPORT_FIELD_SUPPLEMENTAL},
+    {"log_repeat_count",        SL_IMPORT_FIELD_REPEAT_COUNT},
+    {"log_last_timestamp",      SL_IMPORT_FIELD_LAST_TIMESTAMP},
+    {"log_sample_rate",         SL_IMPORT_FIELD_SAMPLE_RATE},
+    {NULL,                      SL_IMPORT_FIELD_NONE}
+};
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+static bool SL_MatchImportName (const tSL_ImportName* names,
+                                const char* text,
+                                size_t length,
+                                int* value);
+
+static size_t SL_MatchTimestamp (const char* text);
+
+static bool SL_ParseTextLine (char* line, tSL_ImportRecord* record);
+
+static char* SL_ParseJSONString (char* text, char** end);
+
+static char* SL_SkipJSONValue (char* text);
+
+static bool SL_ParseJSONLine (char* line, tSL_ImportRecord* record);
+
+static int32_t SL_FillImportSlot (tSL_ImportReader* reader, tSL_ImportSlot* slot);
+
+static int32_t SL_ParseImportSlot (tSL_ImportFormat format, tSL_ImportSlot* slot);
+
+static void* SL_ImportThread (void* argument);
+
+// =================================================================================================
+//  SL_MatchImportName
+// =================================================================================================
+bool SL_MatchImportName (const tSL_ImportName* names,
+                         const char* text,
+                         size_t length,
+                         int* value)
+{
+    bool match = false;
+    uint_fast32_t i = 0;
+
+    for (i = 0; (names[i].name != NULL) && !match; i++)
+    {
+        if ((strlen(names[i].name) == length) && (strncasecmp(names[i].name, text, length) == 0))
+        {
+            *value = names[i].value;
+            match = true;
+        }
+    }
+    return match;
+}
+
+// =================================================================================================
+//  SL_MatchTimestamp
+// =================================================================================================
+size_t SL_MatchTimestamp (const char* text)
+{
+    static const char* kPattern = "dddd-dd-dd dd:dd:dd";
+    size_t length = 0;
+    size_t zoneLength = 0;
+    int level = 0;
+
+    // Date and time (with a space or a 'T' between them)
+    for (length = 0; kPattern[length] != 0; length++)
+    {
+        if ((kPattern[length] == 'd') ? !isdigit((unsigned char)text[length]) :
+            ((text[length] != kPattern[length]) && !((length == 10) && (text[length] == 'T'))))
+            break;
+    }
+    if (kPattern[length] != 0)
+        length = 0;
+    else
+    {
+        // Fraction of a second
+        if (((text[length] == '.') || (text[length] == ',')) && isdigit((unsigned char)text[length + 1]))
+        {
+            length++;
+            while (isdigit((unsigned char)text[length]))
+                length++;
+        }
+
+        // Time zone ('Z', an offset, or an abbreviation that isn't a log level)
+        if (text[length] == 'Z')
+            length++;
+        else if (((text[length] == '+') || (text[length] == '-')) && isdigit((unsigned char)text[length + 1]))
+        {
+            length++;
+            while (isdigit((unsigned char)text[length]) || (text[length] == ':'))
+                length++;
+        }
+        else if (text[length] == ' ')
+        {
+            while (isupper((unsigned char)text[length + 1 + zoneLength]))
+                zoneLength++;
+            if ((zoneLength >= 2) && (zoneLength <= 5) &&
+                !isalnum((unsigned char)text[length + 1 + zoneLength]) &&
+                !SL_MatchImportName(kSL_ImportLevelNames, text + length + 1, zoneLength, &level))
+                length += 1 + zoneLength;
+        }
+    }
+    return length;
+}
+
+// =================================================================================================
+//  SL_ParseTextLine
+// =================================================================================================
+bool SL_ParseTextLine (char* line, tSL_ImportRecord* record)
+{
+    char* text = line;
+    char* timestamp = NULL;
+    size_t length = 0;
+    int level = 0;
+
+    // A line is an optional timestamp, an optional log level, and a message, with optional
+    // brackets around the timestamp and log level
+    while (isspace((unsigned char)*text))
+        text++;
+    length = SL_MatchTimestamp(text + ((*text == '[') ? 1 : 0));
+    if ((length > 0) && (*text == '[') && (text[length + 1] == ']'))
+    {
+        timestamp = text + 1;
+        text += length + 2;
+    }
+    else if ((length > 0) && (*text != '[') && ((text[length] == 0) || isspace((unsigned char)text[length])))
+    {
+        timestamp = text;
+        text += length + ((text[length] != 0) ? 1 : 0);
+    }
+    if (timestamp != NULL)
+    {
+        timestamp[length] = 0;
+        if (timestamp[10] == 'T')
+            timestamp[10] = ' ';
+        record->timestamp = timestamp;
+    }
+
+    while (isspace((unsigned char)*text))
+        text++;
+    for (length = ((*text == '[') ? 1 : 0); isalpha((unsigned char)text[length]); length++)
+        ;
+    if ((*text == '[') && (text[length] == ']') &&
+        SL_MatchImportName(kSL_ImportLevelNames, text + 1, length - 1, &level))
+    {
+        record->level = (tSL_LogLevel)level;
+        text += length + 1;
+    }
+    else if ((*text != '[') && ((text[length] == 0) || (text[length] == ':') || isspace((unsigned char)text[length])) &&
+             SL_MatchImportName(kSL_ImportLevelNames, text, length, &level))
+    {
+        record->level = (tSL_LogLevel)level;
+        text += length + ((text[length] == ':') ? 1 : 0);
+    }
+    while (isspace((unsigned char)*text))
+        text++;
+
+    record->message = text;
+
+    return (*text != 0);
+}
+
+// =================================================================================================
+//  SL_ParseJSONString
+// =================================================================================================
+char* SL_ParseJSONString (char* text, char** end)
+{
+    char* string = text + 1;
+    char* source = string;
+    char* destination = string;
+
+    // The unescaped string is never longer than the escaped one, so it's decoded in place
+    while ((*source != '"') && (*source != 0))
+    {
+        if (*source != '\\')
+            *destination++ = *source++;
+        else
+        {
+            source++;
+            switch (*source)
+            {
+                case 'b':   *destination++ = '\b';  source++;   break;
+                case 'f':   *destination++ = '\f';  source++;   break;
+                case 'n':   *destination++ = '\n';  source++;   break;
+                case 'r':   *destination++ = '\r';  source++;   break;
+                case 't':   *destination++ = '\t';  source++;   break;
+                case 'u':
+                {
+                    uint32_t codePoint = 0;
+                    char hex[5] = {0};
+                    char* hexEnd = NULL;
+
+                    memcpy((void*)hex, (const void*)(source + 1), 4);
+                    codePoint = (uint32_t)strtoul(hex, &hexEnd, 16);
+                    if (hexEnd != (hex + 4))
+                        source = NULL;
+                    else
+                    {
+                        source += 5;
+
+                        // Surrogate pair
+                        if ((codePoint >= 0xD800) && (codePoint < 0xDC00) &&
+                            (source[0] == '\\') && (source[1] == 'u'))
+                        {
+                            uint32_t low = 0;
+
+                            memcpy((void*)hex, (const void*)(source + 2), 4);
+                            low = (uint32_t)strtoul(hex, &hexEnd, 16);
+                            if ((hexEnd == (hex + 4)) && (low >= 0xDC00) && (low < 0xE000))
+                            {
+                                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                                source += 6;
+                            }
+                        }
+
+                        // UTF-8
+                        if (codePoint < 0x80)
+                            *destination++ = (char)codePoint;
+                        else if (codePoint < 0x800)
+                        {
+                            *destination++ = (char)(0xC0 | (codePoint >> 6));
+                            *destination++ = (char)(0x80 | (codePoint & 0x3F));
+                        }
+                        else if (codePoint < 0x10000)
+                        {
+                            *destination++ = (char)(0xE0 | (codePoint >> 12));
+                            *destination++ = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                            *destination++ = (char)(0x80 | (codePoint & 0x3F));
+                        }
+                        else
+                        {
+                            *destination++ = (char)(0xF0 | (codePoint >> 18));
+                            *destination++ = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+                            *destination++ = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+                            *destination++ = (char)(0x80 | (codePoint & 0x3F));
+                        }
+                    }
+                    break;
+                }
+                case 0:
+                    source = NULL;
+                    break;
+                default:    // '"', '\\' and '/'
+                    *destination++ = *source++;
+                    break;
+            }
+            if (source == NULL)
+                break;
+        }
+    }
+    if ((source == NULL) || (*source != '"'))
+        string = NULL;
+    else
+    {
+        *end = source + 1;
+        *destination = 0;
+    }
+    return string;
+}
+
+// =================================================================================================
+//  SL_SkipJSONValue
+// =================================================================================================
+char* SL_SkipJSONValue (char* text)
+{
+    char* end = NULL;
+    uint32_t depth = 0;
+
+    // Objects and arrays are skipped by matching brackets (strings may contain brackets)
+    do
+    {
+        if (*text == '"')
+        {
+            if (SL_ParseJSONString(text, &end) == NULL)
+                text = NULL;
+            else
+                text = end;
+        }
+        else if ((*text == '{') || (*text == '['))
+        {
+            depth++;
+            text++;
+        }
+        else if (((*text == '}') || (*text == ']')) && (depth > 0))
+        {
+            depth--;
+            text++;
+        }
+        else if ((*text == 0) || ((depth == 0) && ((*text == ',') || (*text == '}'))))
+            break;
+        else
+            text++;
+    } while ((text != NULL) && (depth > 0));
+
+    // Scalars run to the next delimiter
+    while ((text != NULL) && (*text != 0) && (*text != ',') && (*text != '}') &&
+           !isspace((unsigned char)*text))
+        text++;
+
+    return text;
+}
+
+// =================================================================================================
+//  SL_ParseJSONLine
+// =================================================================================================
+bool SL_ParseJSONLine (char* line, tSL_ImportRecord* record)
+{
+    bool valid = true;
+    char* text = line;
+    char* key = NULL;
+    char* value = NULL;
+    char* end = NULL;
+    int field = SL_IMPORT_FIELD_NONE;
+    int level = 0;
+
+    while (isspace((unsigned char)*text))
+        text++;
+    valid = (*text == '{');
+    if (valid)
+        text++;
+    while (valid)
+    {
+        // Key
+        while (isspace((unsigned char)*text))
+            text++;
+        if (*text == '}')
+            break;
+        key = (*text == '"') ? SL_ParseJSONString(text, &end) : NULL;
+        valid = (key != NULL);
+        if (valid)
+        {
+            text = end;
+            while (isspace((unsigned char)*text))
+                text++;
+            valid = (*text == ':');
+            text++;
+        }
+        if (valid)
+        {
+            while (isspace((unsigned char)*text))
+                text++;
+            if (!SL_MatchImportName(kSL_ImportFieldNames, key, strlen(key), &field))
+                field = SL_IMPORT_FIELD_NONE;
+
+            // String values
+            if (*text == '"')
+            {
+                value = SL_ParseJSONString(text, &end);
+                valid = (value != NULL);
+                if (valid)
+                {
+                    text = end;
+                    if (field == SL_IMPORT_FIELD_TIMESTAMP)
+                        record->timestamp = value;
+                    else if (field == SL_IMPORT_FIELD_MESSAGE)
+                        record->message = value;
+                    else if ((field == SL_IMPORT_FIELD_LEVEL) &&
+                             SL_MatchImportName(kSL_ImportLevelNames, value, strlen(value), &level))
+                        record->level = (tSL_LogLevel)level;
+                    else if (field == SL_IMPORT_FIELD_FILE_NAME)
+                        record->fileName = value;
+                    else if (field == SL_IMPORT_FIELD_FUNCTION_NAME)
+                        record->functionName = value;
+                    else if (field == SL_IMPORT_FIELD_TAG)
+                        record->tag = value;
+                    else if (field == SL_IMPORT_FIELD_SUPPLEMENTAL)
+                        record->supplementalData = value;
+                    else if (field == SL_IMPORT_FIELD_LAST_TIMESTAMP)
+                        record->lastTimestamp = value;
+                }
+            }
+
+            // Numeric values
+            else if ((*text == '-') || isdigit((unsigned char)*text))
+            {
+                double number = strtod(text, &end);
+
+                valid = (end != text);
+                if (valid)
+                {
+                    text = end;
+                    if ((field == SL_IMPORT_FIELD_LINE_NUMBER) && (number >= 0))
+                        record->lineNumber = (uint32_t)number;
+                    else if ((field == SL_IMPORT_FIELD_REPEAT_COUNT) && (number >= 1))
+                        record->repeatCount = (uint32_t)number;
+                    else if ((field == SL_IMPORT_FIELD_SAMPLE_RATE) && (number > 0) && (number <= 1))
+                        record->sampleRate = number;
+                }
+            }
+
+            // Anything else (null, booleans, objects and arrays) is ignored
+            else
+            {
+                text = SL_SkipJSONValue(text);
+                valid = (text != NULL);
+            }
+        }
+        if (valid)
+        {
+            while (isspace((unsigned char)*text))
+                text++;
+            if (*text == ',')
+                text++;
+            else
+                valid = (*text == '}');
+        }
+    }
+    if (valid && (record->timestamp != NULL) && (strlen(record->timestamp) > 10) &&
+        (record->timestamp[10] == 'T'))
+        ((char*)record->timestamp)[10] = ' ';
+
+    return valid && (record->message != NULL) && (record->message[0] != 0);
+}
+
+// =================================================================================================
+//  SL_FillImportSlot
+// =================================================================================================
+int32_t SL_FillImportSlot (tSL_ImportReader* reader, tSL_ImportSlot* slot)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    size_t lineEnd = 0;
+    size_t scanned = 0;
+    bool found = false;
+
+    // Start with the partial line left over from the last block
+    slot->size = 0;
+    if (slot->capacity < (reader->carrySize + SL_IMPORT_BLOCK_SIZE + 1))
+    {
+        char* data = (char*)realloc((void*)slot->data, reader->carrySize + SL_IMPORT_BLOCK_SIZE + 1);
+        if (data == NULL)
+            result = ENOMEM;
+        else
+        {
+            slot->data = data;
+            slot->capacity = reader->carrySize + SL_IMPORT_BLOCK_SIZE + 1;
+        }
+    }
+    if (result == SL_RESULT_SUCCESS)
+    {
+        memcpy((void*)slot->data, (const void*)reader->carry, reader->carrySize);
+        slot->size = reader->carrySize;
+        reader->carrySize = 0;
+    }
+
+    // Read until the block has at least one whole line (lines can be longer than a block)
+    while ((result == SL_RESULT_SUCCESS) && !reader->endOfInput && !found)
+    {
+        size_t size = 0;
+
+        if (slot->capacity < (slot->size + SL_IMPORT_BLOCK_SIZE + 1))
+        {
+            char* data = (char*)realloc((void*)slot->data, slot->size + SL_IMPORT_BLOCK_SIZE + 1);
+            if (data == NULL)
+                result = ENOMEM;
+            else
+            {
+                slot->data = data;
+                slot->capacity = slot->size + SL_IMPORT_BLOCK_SIZE + 1;
+            }
+        }
+        if (result == SL_RESULT_SUCCESS)
+        {
+            size = fread((void*)(slot->data + slot->size), 1, SL_IMPORT_BLOCK_SIZE, reader->input);
+            slot->size += size;
+            if (size < SL_IMPORT_BLOCK_SIZE)
+            {
+                if (ferror(reader->input))
+                    result = EIO;
+                reader->endOfInput = true;
+            }
+            for (lineEnd = slot->size; (lineEnd > scanned) && !found; lineEnd--)
+                found = (slot->data[lineEnd - 1] == '\n');
+            scanned = slot->size;
+        }
+    }
+
+    // Keep the partial line at the end for the next block
+    if ((result == SL_RESULT_SUCCESS) && !reader->endOfInput)
+    {
+        lineEnd++;
+        reader->carrySize = slot->size - lineEnd;
+        if (reader->carryCapacity < reader->carrySize)
+        {
+            char* carry = (char*)realloc((void*)reader->carry, reader->carrySize);
+            if (carry == NULL)
+                result = ENOMEM;
+            else
+            {
+                reader->carry = carry;
+                reader->carryCapacity = reader->carrySize;
+            }
+        }
+        if (result == SL_RESULT_SUCCESS)
+        {
+            memcpy((void*)reader->carry, (const void*)(slot->data + lineEnd), reader->carrySize);
+            slot->size = lineEnd;
+        }
+    }
+    if (result == SL_RESULT_SUCCESS)
+        slot->data[slot->size] = 0;
+    else
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, reading import input failed with result %d.\n",
+                __LINE__, __FUNCTION__, result);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_ParseImportSlot
+// =================================================================================================
+int32_t SL_ParseImportSlot (tSL_ImportFormat format, tSL_ImportSlot* slot)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char* line = slot->data;
+    char* lineEnd = NULL;
+
+    slot->recordCount = 0;
+    slot->skippedCount = 0;
+    while ((result == SL_RESULT_SUCCESS) && (line < (slot->data + slot->size)))
+    {
+        tSL_ImportRecord* record = NULL;
+        size_t length = 0;
+        bool parsed = false;
+
+        // Terminate the line (dropping any carriage return)
+        lineEnd = strchr(line, '\n');
+        if (lineEnd == NULL)
+            lineEnd = slot->data + slot->size;
+        *lineEnd = 0;
+        length = (size_t)(lineEnd - line);
+        if ((length > 0) && (line[length - 1] == '\r'))
+            line[length - 1] = 0;
+
+        // Make room for the record
+        if (slot->recordCount == slot->recordCapacity)
+        {
+            uint32_t capacity = (slot->recordCapacity == 0) ?
+                SL_IMPORT_RECORD_CAPACITY : (slot->recordCapacity * 2);
+            tSL_ImportRecord* records = (tSL_ImportRecord*)realloc((void*)slot->records,
+                                                                   capacity * sizeof(tSL_ImportRecord));
+            if (records == NULL)
+                result = ENOMEM;
+            else
+            {
+                slot->records = records;
+                slot->recordCapacity = capacity;
+            }
+        }
+        if (result == SL_RESULT_SUCCESS)
+        {
+            record = &(slot->records[slot->recordCount]);
+            memset((void*)record, 0, sizeof(tSL_ImportRecord));
+            record->level = eSL_LogLevel_Info;
+            record->repeatCount = 1;
+            record->sampleRate = 1.0;
+
+            if (format == eSL_ImportFormat_NDJSON)
+                parsed = SL_ParseJSONLine(line, record);
+            else
+                parsed = SL_ParseTextLine(line, record);
+
+            // Blank lines aren't worth counting
+            if (parsed)
+                slot->recordCount++;
+            else if (line[strspn(line, " \t\r")] != 0)
+                slot->skippedCount++;
+        }
+        line = lineEnd + 1;
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_ImportThread
+// =================================================================================================
+void* SL_ImportThread (void* argument)
+{
+    tSL_ImportReader* reader = (tSL_ImportReader*)argument;
+
+    // Parser threads take turns reading blocks (in file order), and parse them in parallel
+    (void)pthread_mutex_lock(&(reader->mutex));
+    while (!reader->stopping && !reader->endOfInput && (reader->result == SL_RESULT_SUCCESS))
+    {
+        tSL_ImportSlot* slot = &(reader->slots[reader->fillIndex]);
+
+        if (slot->state != SL_IMPORT_SLOT_EMPTY)
+            (void)pthread_cond_wait(&(reader->slotEmpty), &(reader->mutex));
+        else
+        {
+            reader->result = SL_FillImportSlot(reader, slot);
+            if ((reader->result == SL_RESULT_SUCCESS) && (slot->size > 0))
+            {
+                slot->state = SL_IMPORT_SLOT_PARSING;
+                reader->fillIndex = (reader->fillIndex + 1) % reader->slotCount;
+                (void)pthread_mutex_unlock(&(reader->mutex));
+
+                slot->result = SL_ParseImportSlot(reader->format, slot);
+
+                (void)pthread_mutex_lock(&(reader->mutex));
+                slot->state = SL_IMPORT_SLOT_PARSED;
+            }
+            (void)pthread_cond_broadcast(&(reader->slotParsed));
+        }
+    }
+    (void)pthread_cond_broadcast(&(reader->slotParsed));
+    (void)pthread_mutex_unlock(&(reader->mutex));
+
+    return NULL;
+}
+
+// =================================================================================================
+//  SL_OpenImportReader
+// =================================================================================================
+int32_t SL_OpenImportReader (const char* path,
+                             tSL_ImportFormat format,
+                             uint32_t threadCount,
+                             tSL_ImportReader** reader)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_ImportReader* newReader = NULL;
+    uint_fast32_t i = 0;
+
+    newReader = (tSL_ImportReader*)calloc(1, sizeof(tSL_ImportReader));
+    if (newReader == NULL)
+        result = ENOMEM;
+    else
+    {
+        newReader->format = format;
+        newReader->input = fopen(path, "rb");
+        if (newReader->input == NULL)
+        {
+            result = errno;
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, fopen of %s failed with result %d.\n",
+                    __LINE__, __FUNCTION__, path, result);
+        }
+        else
+        {
+            // Blocks are read whole, so stdio buffering would only add a copy
+            (void)setvbuf(newReader->input, NULL, _IONBF, 0);
+            (void)pthread_mutex_init(&(newReader->mutex), NULL);
+            (void)pthread_cond_init(&(newReader->slotParsed), NULL);
+            (void)pthread_cond_init(&(newReader->slotEmpty), NULL);
+
+            if (threadCount == 0)
+                threadCount = 1;
+            else if (threadCount > SL_MAX_IMPORT_THREADS)
+                threadCount = SL_MAX_IMPORT_THREADS;
+            newReader->slotCount = threadCount * SL_IMPORT_SLOTS_PER_THREAD;
+            for (i = 0; (i < threadCount) && (result == SL_RESULT_SUCCESS); i++)
+            {
+                result = pthread_create(&(newReader->threads[i]), NULL, SL_ImportThread, (void*)newReader);
+                if (result == 0)
+                    newReader->threadCount++;
+                else
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, pthread_create failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+        }
+    }
+    if (result == SL_RESULT_SUCCESS)
+        *reader = newReader;
+    else
+        SL_CloseImportReader(newReader);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_ReadImportBlock
+// =================================================================================================
+int32_t SL_ReadImportBlock (tSL_ImportReader* reader,
+                            const tSL_ImportRecord** records,
+                            uint32_t* recordCount)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_ImportSlot* slot = NULL;
+
+    (void)pthread_mutex_lock(&(reader->mutex));
+
+    // Hand the last block back to the parser threads
+    if (reader->held)
+    {
+        reader->slots[reader->readIndex].state = SL_IMPORT_SLOT_EMPTY;
+        reader->readIndex = (reader->readIndex + 1) % reader->slotCount;
+        reader->held = false;
+        (void)pthread_cond_broadcast(&(reader->slotEmpty));
+    }
+
+    // Wait for the next block (an empty block after the end of the input means there are no more)
+    slot = &(reader->slots[reader->readIndex]);
+    while ((slot->state != SL_IMPORT_SLOT_PARSED) && (reader->result == SL_RESULT_SUCCESS) &&
+           !(reader->endOfInput && (slot->state == SL_IMPORT_SLOT_EMPTY)))
+        (void)pthread_cond_wait(&(reader->slotParsed), &(reader->mutex));
+
+    if (reader->result != SL_RESULT_SUCCESS)
+        result = reader->result;
+    else if (slot->state != SL_IMPORT_SLOT_PARSED)
+        result = ENODATA;
+    else if (slot->result != SL_RESULT_SUCCESS)
+        result = slot->result;
+    else
+    {
+        *records = slot->records;
+        *recordCount = slot->recordCount;
+        reader->skippedCount += slot->skippedCount;
+        reader->held = true;
+    }
+    (void)pthread_mutex_unlock(&(reader->mutex));
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_GetImportSkippedLineCount
+// =================================================================================================
+uint64_t SL_GetImportSkippedLineCount (const tSL_ImportReader* reader)
+{
+    return reader->skippedCount;
+}
+
+// =================================================================================================
+//  SL_CloseImportReader
+// =================================================================================================
+void SL_CloseImportReader (tSL_ImportReader* reader)
+{
+    uint_fast32_t i = 0;
+
+    if (reader != NULL)
+    {
+        if (reader->input != NULL)
+        {
+            (void)pthread_mutex_lock(&(reader->mutex));
+            reader->stopping = true;
+            (void)pthread_cond_broadcast(&(reader->slotEmpty));
+            (void)pthread_mutex_unlock(&(reader->mutex));
+            for (i = 0; i < reader->threadCount; i++)
+                (void)pthread_join(reader->threads[i], NULL);
+
+            (void)pthread_cond_destroy(&(reader->slotEmpty));
+            (void)pthread_cond_destroy(&(reader->slotParsed));
+            (void)pthread_mutex_destroy(&(reader->mutex));
+            (void)fclose(reader->input);
+        }
+        for (i = 0; i < (SL_MAX_IMPORT_THREADS * SL_IMPORT_SLOTS_PER_THREAD); i++)
+        {
+            free((void*)(reader->slots[i].data));
+            free((void*)(reader->slots[i].records));
+        }
+        free((void*)(reader->carry));
+        free((void*)reader);
+    }
+    return;
+}
+
+// =================================================================================================
@@ -0,0 +1,76 @@
+// =================================================================================================
+//! @file sqlite_logger_import.h
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the private interface for SQLite Logger log import.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-21
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#ifndef __SQLITE_LOGGER_IMPORT_H__
+#define __SQLITE_LOGGER_IMPORT_H__
+
+#include "sqlite_logger.h"
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+//  Size of the blocks of input each parser thread reads
+#define SL_IMPORT_BLOCK_SIZE            (1024 * 1024)
+
+//  Most parser threads an import can use
+#define SL_MAX_IMPORT_THREADS           16
+
+// =================================================================================================
+//  Types
+// =================================================================================================
+
+//  A parsed log entry (strings point into the block it was parsed from, and absent values are
+//  NULL)
+typedef struct tsl_importrecord
+{
+    const char*     timestamp;
+    const char*     message;
+    tSL_LogLevel    level;
+    const char*     fileName;
+    const char*     functionName;
+    uint32_t        lineNumber;
+    const char*     tag;
+    const char*     supplementalData;
+    uint32_t        repeatCount;
+    const char*     lastTimestamp;
+    double          sampleRate;
+}
+tSL_ImportRecord;
+
+//  Reads and parses an input file in blocks, on parser threads
+typedef struct tsl_importreader tSL_ImportReader;
+
+// =================================================================================================
+//  Prototypes
+// =================================================================================================
+
+//  Opens an input file and starts parsing it
+int32_t SL_OpenImportReader (const char* path,
+                             tSL_ImportFormat format,
+                             uint32_t threadCount,
+                             tSL_ImportReader** reader);
+
+//  Gets the records of the next block of the input file, in file order; the records are valid
+//  until the next call, and ENODATA means there are no more blocks
+int32_t SL_ReadImportBlock (tSL_ImportReader* reader,
+                            const tSL_ImportRecord** records,
+                            uint32_t* recordCount);
+
+//  Gets the number of lines that couldn't be parsed so far
+uint64_t SL_GetImportSkippedLineCount (const tSL_ImportReader* reader);
+
+//  Stops the parser threads and closes the input file
+void SL_CloseImportReader (tSL_ImportReader* reader);
+
+// =================================================================================================
+#endif	// __SQLITE_LOGGER_IMPORT_H__
+// =================================================================================================
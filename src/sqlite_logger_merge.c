@@ -0,0 +1,695 @@
+// =================================================================================================
+//! @file sqlite_logger_merge.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the implementation of SQLite Logger log merging.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-23
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include "sqlite_logger.h"
+#include "sqlite_logger_archive.h"
+#include "sqlite_logger_export.h"
+#include "sqlite3.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Where to direct fprintf output
+#define SL_TERMINAL                 stderr
+
+//  Number of rows a log table is read at a time
+#define SL_MERGE_BATCH_ROW_COUNT    256
+
+//  Most threads a merge can read with
+#define SL_MAX_MERGE_THREADS        64
+
+//  Index of the timestamp in a row of log table column values
+#define SL_MERGE_TIMESTAMP_COLUMN   1
+
+//  SQL command to create a merged log table (a log table with the log file of each entry)
+static const char* kSL_CreateMergeTableSQLCommandString =
+    "CREATE TABLE \"log at %w\" (`log_id` INTEGER PRIMARY KEY AUTOINCREMENT NOT NULL, `log_timestamp` TEXT NOT NULL, `log_message` TEXT NOT NULL, `log_level` TEXT NOT NULL, `log_filename` TEXT, `log_functionname` TEXT, `log_linenumber` INTEGER, `log_tag` TEXT, `log_supplementaldata` TEXT, `log_repeat_count` INTEGER NOT NULL DEFAULT 1, `log_last_timestamp` TEXT, `log_sample_rate` REAL NOT NULL DEFAULT 1.0, `log_dictionary_id` INTEGER, `log_source` TEXT)";
+
+//  SQL command to insert a merged entry (values are stored uncompressed, so there's no
+//  dictionary id)
+static const char* kSL_InsertMergeEntrySQLCommandString =
+    "INSERT INTO \"log at %w\" (log_timestamp, log_message, log_level, log_filename, log_functionname, log_linenumber, log_tag, log_supplementaldata, log_repeat_count, log_last_timestamp, log_sample_rate, log_source) VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, coalesce(?9, 1), ?10, coalesce(?11, 1.0), ?12)";
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+//  Rows of a log table, copied out of the statement that read them
+typedef struct tsl_mergebatch
+{
+    sqlite3_value*  values[SL_MERGE_BATCH_ROW_COUNT * SL_LOG_COLUMN_COUNT];
+    uint32_t        rowCount;
+}
+tSL_MergeBatch;
+
+//  A log table being merged; one batch is merged while the other is read
+typedef struct tsl_mergesource
+{
+    const char*     logPath;
+    char*           tableName;
+    sqlite3*        database;
+    sqlite3_stmt*   statement;
+    tSL_MergeBatch  batches[2];
+    uint32_t        current;
+    uint32_t        rowIndex;
+    bool            reading;
+    bool            exhausted;
+    int32_t         result;
+}
+tSL_MergeSource;
+
+//  The state of a merge
+typedef struct tsl_merge
+{
+    tSL_MergeSource*    sources;
+    uint32_t            sourceCount;
+    uint32_t*           heap;
+    uint32_t            heapCount;
+    uint32_t*           queue;
+    uint32_t            queueHead;
+    uint32_t            queueCount;
+    uint32_t            threadCount;
+    bool                stopping;
+    pthread_mutex_t     mutex;
+    pthread_cond_t      batchQueued;
+    pthread_cond_t      batchRead;
+}
+tSL_Merge;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+static int32_t SL_OpenMergeSources (tSL_Merge* merge,
+                                    const char* const* logPaths,
+                                    uint32_t logCount,
+                                    const tSL_MergeOptions* options);
+
+static int32_t SL_PrepareMergeSource (tSL_MergeSource* source, const tSL_MergeOptions* options);
+
+static void SL_CloseMergeSources (tSL_Merge* merge);
+
+static void SL_ReadMergeBatch (tSL_MergeSource* source);
+
+static void SL_RequestMergeBatch (tSL_Merge* merge, uint32_t sourceIndex);
+
+static bool SL_NextMergeBatch (tSL_Merge* merge, uint32_t sourceIndex);
+
+static void* SL_MergeThread (void* argument);
+
+static sqlite3_value** SL_GetMergeRow (const tSL_MergeSource* source);
+
+static bool SL_MergeRowPrecedes (const tSL_Merge* merge, uint32_t first, uint32_t second);
+
+static void SL_SiftMergeHeap (tSL_Merge* merge, uint32_t position);
+
+static int32_t SL_WriteMergeEntry (sqlite3* output,
+                                   sqlite3_stmt** statement,
+                                   const tSL_MergeSource* source,
+                                   sqlite3_value** values);
+
+// =================================================================================================
+//  SL_Merge
+// =================================================================================================
+int32_t SL_Merge (const char* const* logPaths,
+                  uint32_t logCount,
+                  const char* outputPath,
+                  const tSL_MergeOptions* options,
+                  uint64_t* entryCount)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_Merge merge;
+    pthread_t threads[SL_MAX_MERGE_THREADS];
+    uint32_t startedCount = 0;
+    sqlite3* outputDatabase = NULL;
+    sqlite3_stmt* insertStatement = NULL;
+    FILE* output = NULL;
+    char* outputBuffer = NULL;
+    tSL_ExportFormat format = eSL_ExportFormat_NDJSON;
+    uint64_t count = 0;
+    uint_fast32_t i = 0;
+
+    memset((void*)&merge, 0, sizeof(merge));
+
+    // Check arguments
+    if ((logPaths == NULL) || (outputPath == NULL) || (options == NULL))
+    {
+        result = EFAULT;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, SL_Merge has a NULL argument.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if (logCount == 0)
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, there are no log files to merge.\n",
+                __LINE__, __FUNCTION__);
+    }
+    else if ((options->output != eSL_MergeOutput_Database) &&
+             (options->output != eSL_MergeOutput_NDJSON) &&
+             (options->output != eSL_MergeOutput_CSV))
+    {
+        result = EINVAL;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, merge output %d is invalid.\n",
+                __LINE__, __FUNCTION__, options->output);
+    }
+    for (i = 0; (i < logCount) && (result == SL_RESULT_SUCCESS); i++)
+    {
+        if (logPaths[i] == NULL)
+        {
+            result = EFAULT;
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, log file path %u is NULL.\n",
+                    __LINE__, __FUNCTION__, (uint32_t)i);
+        }
+    }
+
+    // Check status
+    if (result == SL_RESULT_SUCCESS)
+    {
+        (void)pthread_mutex_init(&(merge.mutex), NULL);
+        (void)pthread_cond_init(&(merge.batchQueued), NULL);
+        (void)pthread_cond_init(&(merge.batchRead), NULL);
+
+        // Open the output first, so a bad output path fails before any reading
+        if (options->output == eSL_MergeOutput_Database)
+        {
+            result = sqlite3_open_v2(outputPath, &outputDatabase,
+                                     SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+            if (result == SQLITE_OK)
+                result = sqlite3_exec(outputDatabase, "BEGIN", NULL, NULL, NULL);
+            if (result != SQLITE_OK)
+                fprintf(SL_TERMINAL,
+                        "At line %d in function %s, opening %s failed with result %d.\n",
+                        __LINE__, __FUNCTION__, outputPath, result);
+        }
+        else
+        {
+            format = (options->output == eSL_MergeOutput_CSV) ?
+                eSL_ExportFormat_CSV : eSL_ExportFormat_NDJSON;
+            result = SL_OpenExportFile(outputPath, "wb", &output, &outputBuffer);
+            if (result == SQLITE_OK)
+                SL_WriteExportHeader(output, format, true);
+        }
+        if (result == SQLITE_OK)
+            result = SL_OpenMergeSources(&merge, logPaths, logCount, options);
+
+        // Start the threads that read the log tables (none reads on this thread)
+        if (result == SQLITE_OK)
+        {
+            merge.queue = (uint32_t*)malloc(merge.sourceCount * sizeof(uint32_t));
+            merge.heap = (uint32_t*)malloc(merge.sourceCount * sizeof(uint32_t));
+            if ((merge.sourceCount > 0) && ((merge.queue == NULL) || (merge.heap == NULL)))
+                result = SQLITE_NOMEM;
+        }
+        if (result == SQLITE_OK)
+        {
+            merge.threadCount = options->threadCount;
+            if (merge.threadCount > SL_MAX_MERGE_THREADS)
+                merge.threadCount = SL_MAX_MERGE_THREADS;
+            if (merge.threadCount > merge.sourceCount)
+                merge.threadCount = merge.sourceCount;
+            for (i = 0; (i < merge.threadCount) && (result == SQLITE_OK); i++)
+            {
+                if (pthread_create(&(threads[i]), NULL, SL_MergeThread, (void*)&merge) == 0)
+                    startedCount++;
+                else
+                {
+                    result = errno;
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, pthread_create failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+                }
+            }
+        }
+
+        // Read the first batch of every log table (in parallel), and heap up the tables that
+        // have entries
+        if (result == SQLITE_OK)
+        {
+            for (i = 0; i < merge.sourceCount; i++)
+                SL_RequestMergeBatch(&merge, (uint32_t)i);
+            for (i = 0; i < merge.sourceCount; i++)
+            {
+                if (SL_NextMergeBatch(&merge, (uint32_t)i))
+                    merge.heap[merge.heapCount++] = (uint32_t)i;
+                else if ((result == SQLITE_OK) && (merge.sources[i].result != SQLITE_OK))
+                    result = merge.sources[i].result;
+            }
+            for (i = merge.heapCount / 2; (i > 0) && (result == SQLITE_OK); i--)
+                SL_SiftMergeHeap(&merge, (uint32_t)(i - 1));
+        }
+
+        // Merge: write the earliest entry of any table, then move that table along
+        while ((result == SQLITE_OK) && (merge.heapCount > 0))
+        {
+            uint32_t sourceIndex = merge.heap[0];
+            tSL_MergeSource* source = &(merge.sources[sourceIndex]);
+            sqlite3_value** values = SL_GetMergeRow(source);
+
+            if (output != NULL)
+                SL_WriteExportRow(output, format, source->logPath, source->tableName, values);
+            else
+                result = SL_WriteMergeEntry(outputDatabase, &insertStatement, source, values);
+            count++;
+
+            source->rowIndex++;
+            if ((result == SQLITE_OK) &&
+                (source->rowIndex == source->batches[source->current].rowCount) &&
+                !SL_NextMergeBatch(&merge, sourceIndex))
+            {
+                result = source->result;
+                merge.heap[0] = merge.heap[--merge.heapCount];
+            }
+            if ((result == SQLITE_OK) && (merge.heapCount > 0))
+                SL_SiftMergeHeap(&merge, 0);
+        }
+
+        // Stop the threads
+        (void)pthread_mutex_lock(&(merge.mutex));
+        merge.stopping = true;
+        (void)pthread_cond_broadcast(&(merge.batchQueued));
+        (void)pthread_mutex_unlock(&(merge.mutex));
+        for (i = 0; i < startedCount; i++)
+            (void)pthread_join(threads[i], NULL);
+        SL_CloseMergeSources(&merge);
+
+        // A database output is all or nothing
+        (void)sqlite3_finalize(insertStatement);
+        if (outputDatabase != NULL)
+        {
+            if (result == SQLITE_OK)
+            {
+                result = sqlite3_exec(outputDatabase, "COMMIT", NULL, NULL, NULL);
+                if (result != SQLITE_OK)
+                    fprintf(SL_TERMINAL,
+                            "At line %d in function %s, committing the merge failed with result %d.\n",
+                            __LINE__, __FUNCTION__, result);
+            }
+            else
+                (void)sqlite3_exec(outputDatabase, "ROLLBACK", NULL, NULL, NULL);
+        }
+        (void)sqlite3_close(outputDatabase);
+        if (output != NULL)
+            result = SL_CloseExportFile(output, outputBuffer, result);
+
+        free((void*)(merge.queue));
+        free((void*)(merge.heap));
+        (void)pthread_cond_destroy(&(merge.batchRead));
+        (void)pthread_cond_destroy(&(merge.batchQueued));
+        (void)pthread_mutex_destroy(&(merge.mutex));
+    }
+    if ((result == SL_RESULT_SUCCESS) && (entryCount != NULL))
+        *entryCount = count;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_OpenMergeSources
+// =================================================================================================
+int32_t SL_OpenMergeSources (tSL_Merge* merge,
+                             const char* const* logPaths,
+                             uint32_t logCount,
+                             const tSL_MergeOptions* options)
+{
+    int32_t result = SQLITE_OK;
+    uint32_t capacity = 0;
+    uint_fast32_t i = 0;
+
+    // Every log table of every log file is a source
+    for (i = 0; (i < logCount) && (result == SQLITE_OK); i++)
+    {
+        sqlite3* database = NULL;
+        sqlite3_stmt* statement = NULL;
+
+        result = SL_OpenExportDatabase(logPaths[i], &database);
+        if (result == SQLITE_OK)
+            result = SL_PrepareLogTableSelect(database, NULL, options->endTime, &statement);
+        while ((result == SQLITE_OK) && ((result = sqlite3_step(statement)) == SQLITE_ROW))
+        {
+            result = SQLITE_OK;
+            if (merge->sourceCount == capacity)
+            {
+                tSL_MergeSource* sources = NULL;
+
+                capacity = (capacity == 0) ? 16 : (capacity * 2);
+                sources = (tSL_MergeSource*)realloc((void*)(merge->sources),
+                                                    capacity * sizeof(tSL_MergeSource));
+                if (sources == NULL)
+                    result = SQLITE_NOMEM;
+                else
+                    merge->sources = sources;
+            }
+            if (result == SQLITE_OK)
+            {
+                tSL_MergeSource* source = &(merge->sources[merge->sourceCount]);
+
+                memset((void*)source, 0, sizeof(tSL_MergeSource));
+                source->logPath = logPaths[i];
+                source->tableName = sqlite3_mprintf("%s", sqlite3_column_text(statement, 0));
+                merge->sourceCount++;
+                if (source->tableName == NULL)
+                    result = SQLITE_NOMEM;
+            }
+        }
+        if (result == SQLITE_DONE)
+            result = SQLITE_OK; // Eat this result code
+        else if (result != SQLITE_OK)
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, selecting the log tables of %s failed with result %d.\n",
+                    __LINE__, __FUNCTION__, logPaths[i], result);
+        (void)sqlite3_finalize(statement);
+        (void)sqlite3_close(database);
+    }
+
+    // Each source reads with its own connection, so sources can be read in parallel
+    for (i = 0; (i < merge->sourceCount) && (result == SQLITE_OK); i++)
+        result = SL_PrepareMergeSource(&(merge->sources[i]), options);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_PrepareMergeSource
+// =================================================================================================
+int32_t SL_PrepareMergeSource (tSL_MergeSource* source, const tSL_MergeOptions* options)
+{
+    int32_t result = SQLITE_OK;
+    char* columns = NULL;
+    char* cmdString = NULL;
+
+    // Rows are usually logged in timestamp order, but not always (imported lines, or the clock
+    // being set back), so they're read in timestamp order, with log_id breaking ties; log tables
+    // have no timestamp index, so SQLite sorts each table as it starts reading it, spilling
+    // to temporary files past its page cache, rather than every insert paying for an index
+    result = SL_OpenExportDatabase(source->logPath, &(source->database));
+    if (result == SQLITE_OK)
+        result = SL_BuildLogColumnList(source->database, source->tableName, &columns);
+    if (result == SQLITE_OK)
+    {
+        cmdString = sqlite3_mprintf("SELECT %s FROM \"%w\" WHERE (?1 IS NULL OR log_timestamp >= ?1) AND (?2 IS NULL OR log_timestamp < ?2) ORDER BY log_timestamp, log_id",
+                                    columns, source->tableName);
+        if (cmdString == NULL)
+            result = SQLITE_NOMEM;
+        else
+            result = sqlite3_prepare_v2(source->database, cmdString, -1, &(source->statement), NULL);
+    }
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(source->statement, 1, options->startTime, -1, SQLITE_STATIC);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(source->statement, 2, options->endTime, -1, SQLITE_STATIC);
+    if (result != SQLITE_OK)
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, preparing %s of %s failed with result %d.\n",
+                __LINE__, __FUNCTION__, source->tableName, source->logPath, result);
+    sqlite3_free((void*)cmdString);
+    sqlite3_free((void*)columns);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_CloseMergeSources
+// =================================================================================================
+void SL_CloseMergeSources (tSL_Merge* merge)
+{
+    uint_fast32_t i = 0;
+    uint_fast32_t j = 0;
+
+    for (i = 0; i < merge->sourceCount; i++)
+    {
+        tSL_MergeSource* source = &(merge->sources[i]);
+
+        for (j = 0; j < (source->batches[0].rowCount * SL_LOG_COLUMN_COUNT); j++)
+            sqlite3_value_free(source->batches[0].values[j]);
+        for (j = 0; j < (source->batches[1].rowCount * SL_LOG_COLUMN_COUNT); j++)
+            sqlite3_value_free(source->batches[1].values[j]);
+        (void)sqlite3_finalize(source->statement);
+        (void)sqlite3_close(source->database);
+        sqlite3_free((void*)(source->tableName));
+    }
+    free((void*)(merge->sources));
+    merge->sources = NULL;
+    merge->sourceCount = 0;
+
+    return;
+}
+
+// =================================================================================================
+//  SL_ReadMergeBatch
+// =================================================================================================
+void SL_ReadMergeBatch (tSL_MergeSource* source)
+{
+    tSL_MergeBatch* batch = &(source->batches[1 - source->current]);
+    int32_t result = SQLITE_OK;
+    uint_fast32_t i = 0;
+
+    // The batch was merged already, so its values can go
+    for (i = 0; i < (batch->rowCount * SL_LOG_COLUMN_COUNT); i++)
+        sqlite3_value_free(batch->values[i]);
+    batch->rowCount = 0;
+
+    // Values are copied, since they have to outlive the step that read them (an exhausted
+    // source reads an empty batch)
+    while ((result == SQLITE_OK) && !source->exhausted && (batch->rowCount < SL_MERGE_BATCH_ROW_COUNT))
+    {
+        result = sqlite3_step(source->statement);
+        if (result == SQLITE_ROW)
+        {
+            sqlite3_value** values = &(batch->values[batch->rowCount * SL_LOG_COLUMN_COUNT]);
+
+            result = SQLITE_OK;
+            for (i = 0; i < SL_LOG_COLUMN_COUNT; i++)
+            {
+                values[i] = sqlite3_value_dup(sqlite3_column_value(source->statement, (int)i));
+                if (values[i] == NULL)
+                    result = SQLITE_NOMEM;
+            }
+            if (result == SQLITE_OK)
+                batch->rowCount++;
+            else
+            {
+                for (i = 0; i < SL_LOG_COLUMN_COUNT; i++)
+                    sqlite3_value_free(values[i]);
+            }
+        }
+    }
+    if (result == SQLITE_DONE)
+    {
+        source->exhausted = true;
+        result = SQLITE_OK; // Eat this result code
+    }
+    else if (result != SQLITE_OK)
+    {
+        source->exhausted = true;
+        fprintf(SL_TERMINAL,
+                "At line %d in function %s, reading %s of %s failed with result %d.\n",
+                __LINE__, __FUNCTION__, source->tableName, source->logPath, result);
+    }
+    source->result = result;
+
+    return;
+}
+
+// =================================================================================================
+//  SL_RequestMergeBatch
+// =================================================================================================
+void SL_RequestMergeBatch (tSL_Merge* merge, uint32_t sourceIndex)
+{
+    tSL_MergeSource* source = &(merge->sources[sourceIndex]);
+
+    // Without threads, the next batch is read right away
+    if (merge->threadCount == 0)
+        SL_ReadMergeBatch(source);
+    else
+    {
+        (void)pthread_mutex_lock(&(merge->mutex));
+        source->reading = true;
+        merge->queue[(merge->queueHead + merge->queueCount) % merge->sourceCount] = sourceIndex;
+        merge->queueCount++;
+        (void)pthread_cond_signal(&(merge->batchQueued));
+        (void)pthread_mutex_unlock(&(merge->mutex));
+    }
+    return;
+}
+
+// =================================================================================================
+//  SL_NextMergeBatch
+// =================================================================================================
+bool SL_NextMergeBatch (tSL_Merge* merge, uint32_t sourceIndex)
+{
+    tSL_MergeSource* source = &(merge->sources[sourceIndex]);
+    bool hasRows = false;
+
+    if (merge->threadCount > 0)
+    {
+        (void)pthread_mutex_lock(&(merge->mutex));
+        while (source->reading)
+            (void)pthread_cond_wait(&(merge->batchRead), &(merge->mutex));
+        (void)pthread_mutex_unlock(&(merge->mutex));
+    }
+
+    // Merge the batch that was read, and read the one after it in the meantime
+    source->current = 1 - source->current;
+    source->rowIndex = 0;
+    hasRows = (source->result == SQLITE_OK) && (source->batches[source->current].rowCount > 0);
+    if (hasRows)
+        SL_RequestMergeBatch(merge, sourceIndex);
+
+    return hasRows;
+}
+
+// =================================================================================================
+//  SL_MergeThread
+// =================================================================================================
+void* SL_MergeThread (void* argument)
+{
+    tSL_Merge* merge = (tSL_Merge*)argument;
+
+    (void)pthread_mutex_lock(&(merge->mutex));
+    while (!merge->stopping)
+    {
+        if (merge->queueCount == 0)
+            (void)pthread_cond_wait(&(merge->batchQueued), &(merge->mutex));
+        else
+        {
+            tSL_MergeSource* source = &(merge->sources[merge->queue[merge->queueHead]]);
+
+            merge->queueHead = (merge->queueHead + 1) % merge->sourceCount;
+            merge->queueCount--;
+
+            // Sources are read outside the lock, so several can be read at once
+            (void)pthread_mutex_unlock(&(merge->mutex));
+            SL_ReadMergeBatch(source);
+            (void)pthread_mutex_lock(&(merge->mutex));
+            source->reading = false;
+            (void)pthread_cond_broadcast(&(merge->batchRead));
+        }
+    }
+    (void)pthread_mutex_unlock(&(merge->mutex));
+
+    return NULL;
+}
+
+// =================================================================================================
+//  SL_GetMergeRow
+// =================================================================================================
+sqlite3_value** SL_GetMergeRow (const tSL_MergeSource* source)
+{
+    return (sqlite3_value**)&(source->batches[source->current].values[source->rowIndex * SL_LOG_COLUMN_COUNT]);
+}
+
+// =================================================================================================
+//  SL_MergeRowPrecedes
+// =================================================================================================
+bool SL_MergeRowPrecedes (const tSL_Merge* merge, uint32_t first, uint32_t second)
+{
+    const unsigned char* firstTimestamp =
+        sqlite3_value_text(SL_GetMergeRow(&(merge->sources[first]))[SL_MERGE_TIMESTAMP_COLUMN]);
+    const unsigned char* secondTimestamp =
+        sqlite3_value_text(SL_GetMergeRow(&(merge->sources[second]))[SL_MERGE_TIMESTAMP_COLUMN]);
+    int comparison = strcmp((firstTimestamp == NULL) ? "" : (const char*)firstTimestamp,
+                            (secondTimestamp == NULL) ? "" : (const char*)secondTimestamp);
+
+    // Sources are in log file order, then session order, which breaks ties
+    return (comparison < 0) || ((comparison == 0) && (first < second));
+}
+
+// =================================================================================================
+//  SL_SiftMergeHeap
+// =================================================================================================
+void SL_SiftMergeHeap (tSL_Merge* merge, uint32_t position)
+{
+    uint32_t sourceIndex = merge->heap[position];
+
+    while (((2 * position) + 1) < merge->heapCount)
+    {
+        uint32_t child = (2 * position) + 1;
+
+        if (((child + 1) < merge->heapCount) &&
+            SL_MergeRowPrecedes(merge, merge->heap[child + 1], merge->heap[child]))
+            child++;
+        if (!SL_MergeRowPrecedes(merge, merge->heap[child], sourceIndex))
+            break;
+        merge->heap[position] = merge->heap[child];
+        position = child;
+    }
+    merge->heap[position] = sourceIndex;
+
+    return;
+}
+
+// =================================================================================================
+//  SL_WriteMergeEntry
+// =================================================================================================
+int32_t SL_WriteMergeEntry (sqlite3* output,
+                            sqlite3_stmt** statement,
+                            const tSL_MergeSource* source,
+                            sqlite3_value** values)
+{
+    int32_t result = SQLITE_OK;
+    uint_fast32_t i = 0;
+
+    // The merged table is named for its first entry, like a session is named for its start
+    if (*statement == NULL)
+    {
+        const char* timestamp = (const char*)sqlite3_value_text(values[SL_MERGE_TIMESTAMP_COLUMN]);
+        char* cmdString = sqlite3_mprintf(kSL_CreateMergeTableSQLCommandString, timestamp);
+
+        if (cmdString == NULL)
+            result = SQLITE_NOMEM;
+        else
+            result = sqlite3_exec(output, cmdString, NULL, NULL, NULL);
+        sqlite3_free((void*)cmdString);
+        if (result == SQLITE_OK)
+        {
+            cmdString = sqlite3_mprintf(kSL_InsertMergeEntrySQLCommandString, timestamp);
+            if (cmdString == NULL)
+                result = SQLITE_NOMEM;
+            else
+                result = sqlite3_prepare_v2(output, cmdString, -1, statement, NULL);
+            sqlite3_free((void*)cmdString);
+        }
+        if (result != SQLITE_OK)
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, creating the merged log table failed with result %d.\n",
+                    __LINE__, __FUNCTION__, result);
+    }
+
+    // Every column but the log id and the dictionary id is copied
+    for (i = SL_MERGE_TIMESTAMP_COLUMN; (i < (SL_LOG_COLUMN_COUNT - 1)) && (result == SQLITE_OK); i++)
+        result = sqlite3_bind_value(*statement, (int)i, values[i]);
+    if (result == SQLITE_OK)
+        result = sqlite3_bind_text(*statement, SL_LOG_COLUMN_COUNT - 1, source->logPath, -1, SQLITE_STATIC);
+    if (result == SQLITE_OK)
+    {
+        result = sqlite3_step(*statement);
+        if (result == SQLITE_DONE)
+            result = SQLITE_OK; // Eat this result code
+        else
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, inserting a merged entry failed with result %d.\n",
+                    __LINE__, __FUNCTION__, result);
+        (void)sqlite3_reset(*statement);
+    }
+    return result;
+}
+
+// =================================================================================================
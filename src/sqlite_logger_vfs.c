@@ -0,0 +1,990 @@
+// =================================================================================================
+//! @file sqlite_logger_vfs.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the implementation of the SQLite Logger append VFS.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-25
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#if defined(__linux__)
+#define _GNU_SOURCE     // For fallocate
+#endif
+#include "sqlite_logger_vfs.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define SL_ASYNC_WRITES_SUPPORTED
+#endif
+#endif
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Where to direct fprintf output
+#define SL_TERMINAL                 stderr
+
+//  Files that are preallocated (rollback journals are deleted after every transaction, so
+//  preallocating them would only cost time)
+#define SL_APPEND_PREALLOCATED_FILES    (SQLITE_OPEN_MAIN_DB | SQLITE_OPEN_WAL)
+
+//  Files that sl_append files can have descriptors of at once
+#define SL_APPEND_MAX_DESCRIPTORS       16
+
+//  Asynchronous writes
+#define SL_ASYNC_QUEUE_DEPTH            64      // Writes in flight before waiting for them
+#define SL_ASYNC_RING_SIZE              (2 * SL_ASYNC_QUEUE_DEPTH)
+#define SL_ASYNC_SLOT_SIZE              8192    // Largest write that's queued (a default page fits)
+#define SL_ASYNC_SUBMIT_BATCH           16      // Writes queued before they're submitted
+#define SL_ASYNC_SYNC_SLOT              SL_ASYNC_QUEUE_DEPTH
+
+// =================================================================================================
+//  Private types
+// =================================================================================================
+
+//  An io_uring submission and completion queue, with a copy of each write in flight (SQLite is
+//  free to change its buffer as soon as xWrite returns)
+typedef struct
+{
+    int descriptor;
+    uint32_t* submissionHead;
+    uint32_t* submissionTail;
+    uint32_t submissionMask;
+    uint32_t* submissionArray;
+    uint32_t* completionHead;
+    uint32_t* completionTail;
+    uint32_t completionMask;
+    void* submissionEntries;
+    void* completionEntries;
+    void* submissionRing;
+    size_t submissionRingSize;
+    void* completionRing;
+    size_t completionRingSize;
+    size_t submissionEntriesSize;
+    uint32_t queuedCount;       // Entries prepared, but not submitted yet
+    uint32_t inFlightCount;     // Entries prepared or submitted, but not completed yet
+    uint32_t slotCount;         // Write slots used since the ring was last drained
+    int result;                 // First error since it was last reported
+    bool failed;                // io_uring_enter failed, so nothing more can be submitted
+    sqlite3_int64 offsets[SL_ASYNC_QUEUE_DEPTH];
+    int amounts[SL_ASYNC_QUEUE_DEPTH];
+    uint8_t buffers[SL_ASYNC_QUEUE_DEPTH][SL_ASYNC_SLOT_SIZE];
+} tSL_AsyncRing;
+
+//  An sl_append file, followed in memory by the file of the default VFS that it wraps
+typedef struct tsl_append_file
+{
+    sqlite3_file base;
+    sqlite3_file* file;
+    int descriptor;                 // -1 if unknown
+    bool preallocate;               // Whether the file can be preallocated
+    sqlite3_int64 allocatedSize;    // Bytes of the file known to be allocated
+    tSL_AsyncRing* ring;            // NULL if writes are synchronous
+    struct tsl_append_file* walFile;    // A database's WAL, while its connection has it open
+    struct tsl_append_file* mainFile;   // A WAL's database
+} tSL_AppendFile;
+
+//  A descriptor of a file, shared by the sl_append files that have it open
+typedef struct
+{
+    dev_t device;
+    ino_t inode;
+    int descriptor;
+    uint32_t useCount;
+} tSL_AppendDescriptor;
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+static int SL_AcquireDescriptor (const char* name);
+
+static void SL_ReleaseDescriptor (int descriptor);
+
+static tSL_AsyncRing* SL_OpenAsyncRing (void);
+
+static void SL_CloseAsyncRing (tSL_AsyncRing* ring);
+
+static int SL_QueueAsyncWrite (tSL_AsyncRing* ring,
+                               int descriptor,
+                               const void* buffer,
+                               int amount,
+                               sqlite3_int64 offset);
+
+static void SL_PrepareAsyncEntry (tSL_AsyncRing* ring, int descriptor, uint32_t slot);
+
+static bool SL_EnterAsyncRing (tSL_AsyncRing* ring, uint32_t waitCount);
+
+static void SL_ReapAsyncRing (tSL_AsyncRing* ring);
+
+static void SL_WaitAsyncRing (tSL_AsyncRing* ring, int descriptor, bool sync);
+
+static int SL_DrainAsyncRing (tSL_AppendFile* appendFile, bool sync);
+
+static int SL_DrainConnectionRings (tSL_AppendFile* appendFile);
+
+static int SL_AppendOpen (sqlite3_vfs* vfs,
+                          const char* name,
+                          sqlite3_file* file,
+                          int flags,
+                          int* outFlags);
+
+static int SL_AppendClose (sqlite3_file* file);
+
+static int SL_AppendRead (sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset);
+
+static int SL_AppendWrite (sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset);
+
+static int SL_AppendTruncate (sqlite3_file* file, sqlite3_int64 size);
+
+static int SL_AppendSync (sqlite3_file* file, int flags);
+
+static int SL_AppendFileSize (sqlite3_file* file, sqlite3_int64* size);
+
+static int SL_AppendLock (sqlite3_file* file, int lock);
+
+static int SL_AppendUnlock (sqlite3_file* file, int lock);
+
+static int SL_AppendCheckReservedLock (sqlite3_file* file, int* reserved);
+
+static int SL_AppendFileControl (sqlite3_file* file, int operation, void* argument);
+
+static int SL_AppendSectorSize (sqlite3_file* file);
+
+static int SL_AppendDeviceCharacteristics (sqlite3_file* file);
+
+static int SL_AppendShmMap (sqlite3_file* file, int region, int size, int extend, void volatile** memory);
+
+static int SL_AppendShmLock (sqlite3_file* file, int offset, int count, int flags);
+
+static void SL_AppendShmBarrier (sqlite3_file* file);
+
+static int SL_AppendShmUnmap (sqlite3_file* file, int deleteFlag);
+
+static int SL_AppendFetch (sqlite3_file* file, sqlite3_int64 offset, int amount, void** memory);
+
+static int SL_AppendUnfetch (sqlite3_file* file, sqlite3_int64 offset, void* memory);
+
+// =================================================================================================
+//  Private globals
+// =================================================================================================
+
+//  The sl_append VFS (a copy of the default VFS, with its own xOpen) and the VFS it wraps
+static sqlite3_vfs gSL_AppendVFS;
+static sqlite3_vfs* gSL_BaseVFS = NULL;
+
+//  Whether the wrapped VFS is the unix VFS, so its files can be written with descriptors of
+//  their own
+static bool gSL_BaseVFSIsUnix = false;
+
+//  Descriptors of the files that sl_append files write directly
+static tSL_AppendDescriptor gSL_AppendDescriptors[SL_APPEND_MAX_DESCRIPTORS];
+static pthread_mutex_t gSL_AppendDescriptorMutex = PTHREAD_MUTEX_INITIALIZER;
+
+//  Whether files opened from now on write through io_uring
+static bool gAsyncWrites = false;
+
+//  I/O methods of sl_append files
+static sqlite3_io_methods gSL_AppendIOMethods = {
+    3,                                  // iVersion
+    SL_AppendClose,                     // xClose
+    SL_AppendRead,                      // xRead
+    SL_AppendWrite,                     // xWrite
+    SL_AppendTruncate,                  // xTruncate
+    SL_AppendSync,                      // xSync
+    SL_AppendFileSize,                  // xFileSize
+    SL_AppendLock,                      // xLock
+    SL_AppendUnlock,                    // xUnlock
+    SL_AppendCheckReservedLock,         // xCheckReservedLock
+    SL_AppendFileControl,               // xFileControl
+    SL_AppendSectorSize,                // xSectorSize
+    SL_AppendDeviceCharacteristics,     // xDeviceCharacteristics
+    SL_AppendShmMap,                    // xShmMap
+    SL_AppendShmLock,                   // xShmLock
+    SL_AppendShmBarrier,                // xShmBarrier
+    SL_AppendShmUnmap,                  // xShmUnmap
+    SL_AppendFetch,                     // xFetch
+    SL_AppendUnfetch                    // xUnfetch
+};
+
+// =================================================================================================
+//  SL_RegisterAppendVFS
+// =================================================================================================
+int32_t SL_RegisterAppendVFS (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Check status
+    if (gSL_BaseVFS == NULL)
+    {
+        gSL_BaseVFS = sqlite3_vfs_find(NULL);
+        if (gSL_BaseVFS != NULL)
+        {
+            // Everything but xOpen is the default VFS's own
+            gSL_AppendVFS = *gSL_BaseVFS;
+            gSL_AppendVFS.szOsFile = (int)sizeof(tSL_AppendFile) + gSL_BaseVFS->szOsFile;
+            gSL_AppendVFS.pNext = NULL;
+            gSL_AppendVFS.zName = SL_APPEND_VFS_NAME;
+            gSL_AppendVFS.xOpen = SL_AppendOpen;
+
+            // SQLite has no file control for a file's descriptor, so files are opened again to
+            // write them directly, which is only the same as writing them through the default VFS
+            // if it's the unix VFS (or one of its variants); with any other default VFS, files are
+            // neither preallocated nor written through io_uring
+            gSL_BaseVFSIsUnix = (strncmp(gSL_BaseVFS->zName, "unix", 4) == 0);
+            result = sqlite3_vfs_register(&gSL_AppendVFS, 0);
+        }
+        else
+            result = SQLITE_ERROR;
+
+        if (result != SQLITE_OK)
+        {
+            gSL_BaseVFS = NULL;
+            fprintf(SL_TERMINAL,
+                    "At line %d in function %s, registering the %s VFS failed with result %d.\n",
+                    __LINE__, __FUNCTION__, SL_APPEND_VFS_NAME, result);
+        }
+    }
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_SetAppendAsyncWrites
+// =================================================================================================
+void SL_SetAppendAsyncWrites (bool enable)
+{
+    gAsyncWrites = enable;
+}
+
+// =================================================================================================
+//  SL_GetAppendAsyncWriteMemory
+// =================================================================================================
+uint64_t SL_GetAppendAsyncWriteMemory (void)
+{
+#ifdef SL_ASYNC_WRITES_SUPPORTED
+    return (uint64_t)sizeof(tSL_AsyncRing);
+#else
+    return 0;
+#endif
+}
+
+// =================================================================================================
+//  SL_AcquireDescriptor
+// =================================================================================================
+int SL_AcquireDescriptor (const char* name)
+{
+    int descriptor = -1;
+    struct stat status;
+    uint_fast32_t i = 0;
+    uint_fast32_t unused = SL_APPEND_MAX_DESCRIPTORS;
+
+    // Closing any descriptor of a file releases the process's POSIX locks on it (those of the
+    // default VFS included), so there's one descriptor per file, opened by the first sl_append
+    // file to use it and closed by the last (the file is found before it's opened, since a
+    // descriptor that's opened has to be kept)
+    if ((name != NULL) && (stat(name, &status) == 0))
+    {
+        (void)pthread_mutex_lock(&gSL_AppendDescriptorMutex);
+        for (i = 0; (i < SL_APPEND_MAX_DESCRIPTORS) && (descriptor < 0); i++)
+        {
+            tSL_AppendDescriptor* entry = &(gSL_AppendDescriptors[i]);
+
+            if (entry->useCount == 0)
+            {
+                if (unused == SL_APPEND_MAX_DESCRIPTORS)
+                    unused = i;
+            }
+            else if ((entry->device == status.st_dev) && (entry->inode == status.st_ino))
+            {
+                entry->useCount++;
+                descriptor = entry->descriptor;
+            }
+        }
+        if ((descriptor < 0) && (unused < SL_APPEND_MAX_DESCRIPTORS))
+        {
+            descriptor = open(name, O_RDWR | O_CLOEXEC);
+            if (descriptor >= 0)
+            {
+                gSL_AppendDescriptors[unused].device = status.st_dev;
+                gSL_AppendDescriptors[unused].inode = status.st_ino;
+                gSL_AppendDescriptors[unused].descriptor = descriptor;
+                gSL_AppendDescriptors[unused].useCount = 1;
+            }
+        }
+        (void)pthread_mutex_unlock(&gSL_AppendDescriptorMutex);
+    }
+
+    return descriptor;
+}
+
+// =================================================================================================
+//  SL_ReleaseDescriptor
+// =================================================================================================
+void SL_ReleaseDescriptor (int descriptor)
+{
+    uint_fast32_t i = 0;
+
+    (void)pthread_mutex_lock(&gSL_AppendDescriptorMutex);
+    for (i = 0; i < SL_APPEND_MAX_DESCRIPTORS; i++)
+    {
+        tSL_AppendDescriptor* entry = &(gSL_AppendDescriptors[i]);
+
+        if ((entry->useCount > 0) && (entry->descriptor == descriptor))
+        {
+            entry->useCount--;
+            if (entry->useCount == 0)
+                (void)close(descriptor);
+            break;
+        }
+    }
+    (void)pthread_mutex_unlock(&gSL_AppendDescriptorMutex);
+}
+
+// =================================================================================================
+//  SL_OpenAsyncRing
+// =================================================================================================
+tSL_AsyncRing* SL_OpenAsyncRing (void)
+{
+    tSL_AsyncRing* ring = NULL;
+
+#ifdef SL_ASYNC_WRITES_SUPPORTED
+    struct io_uring_params parameters;
+
+    ring = (tSL_AsyncRing*)calloc(1, sizeof(tSL_AsyncRing));
+    if (ring != NULL)
+    {
+        // Queued writes need kernel 5.6 or later, the first to have IORING_FEAT_RW_CUR_POS
+        memset((void*)&parameters, 0, sizeof(parameters));
+        ring->descriptor = (int)syscall(__NR_io_uring_setup, SL_ASYNC_RING_SIZE, &parameters);
+        if ((ring->descriptor >= 0) && ((parameters.features & IORING_FEAT_RW_CUR_POS) != 0))
+        {
+            ring->submissionRingSize = parameters.sq_off.array + (parameters.sq_entries * sizeof(uint32_t));
+            ring->completionRingSize = parameters.cq_off.cqes + (parameters.cq_entries * sizeof(struct io_uring_cqe));
+            ring->submissionEntriesSize = parameters.sq_entries * sizeof(struct io_uring_sqe);
+            ring->submissionRing = mmap(NULL, ring->submissionRingSize, PROT_READ | PROT_WRITE,
+                                        MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_SQ_RING);
+            ring->completionRing = mmap(NULL, ring->completionRingSize, PROT_READ | PROT_WRITE,
+                                        MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_CQ_RING);
+            ring->submissionEntries = mmap(NULL, ring->submissionEntriesSize, PROT_READ | PROT_WRITE,
+                                           MAP_SHARED | MAP_POPULATE, ring->descriptor, IORING_OFF_SQES);
+        }
+        if ((ring->submissionRing != NULL) && (ring->submissionRing != MAP_FAILED) &&
+            (ring->completionRing != NULL) && (ring->completionRing != MAP_FAILED) &&
+            (ring->submissionEntries != NULL) && (ring->submissionEntries != MAP_FAILED))
+        {
+            ring->submissionHead = (uint32_t*)((uint8_t*)ring->submissionRing + parameters.sq_off.head);
+            ring->submissionTail = (uint32_t*)((uint8_t*)ring->submissionRing + parameters.sq_off.tail);
+            ring->submissionMask = *((uint32_t*)((uint8_t*)ring->submissionRing + parameters.sq_off.ring_mask));
+            ring->submissionArray = (uint32_t*)((uint8_t*)ring->submissionRing + parameters.sq_off.array);
+            ring->completionHead = (uint32_t*)((uint8_t*)ring->completionRing + parameters.cq_off.head);
+            ring->completionTail = (uint32_t*)((uint8_t*)ring->completionRing + parameters.cq_off.tail);
+            ring->completionMask = *((uint32_t*)((uint8_t*)ring->completionRing + parameters.cq_off.ring_mask));
+            ring->completionEntries = (uint8_t*)ring->completionRing + parameters.cq_off.cqes;
+            ring->result = SQLITE_OK;
+        }
+        else    // Fall back to synchronous writes
+        {
+            SL_CloseAsyncRing(ring);
+            ring = NULL;
+        }
+    }
+#endif
+
+    return ring;
+}
+
+// =================================================================================================
+//  SL_CloseAsyncRing
+// =================================================================================================
+void SL_CloseAsyncRing (tSL_AsyncRing* ring)
+{
+    if ((ring->submissionEntries != NULL) && (ring->submissionEntries != MAP_FAILED))
+        (void)munmap(ring->submissionEntries, ring->submissionEntriesSize);
+    if ((ring->completionRing != NULL) && (ring->completionRing != MAP_FAILED))
+        (void)munmap(ring->completionRing, ring->completionRingSize);
+    if ((ring->submissionRing != NULL) && (ring->submissionRing != MAP_FAILED))
+        (void)munmap(ring->submissionRing, ring->submissionRingSize);
+    if (ring->descriptor >= 0)
+        (void)close(ring->descriptor);
+    free((void*)ring);
+}
+
+// =================================================================================================
+//  SL_PrepareAsyncEntry
+// =================================================================================================
+void SL_PrepareAsyncEntry (tSL_AsyncRing* ring, int descriptor, uint32_t slot)
+{
+#ifdef SL_ASYNC_WRITES_SUPPORTED
+    uint32_t tail = *(ring->submissionTail);
+    uint32_t index = tail & ring->submissionMask;
+    struct io_uring_sqe* entry = &(((struct io_uring_sqe*)ring->submissionEntries)[index]);
+
+    // A sync waits for every write before it (it's the last entry before the ring is drained)
+    memset((void*)entry, 0, sizeof(struct io_uring_sqe));
+    entry->fd = descriptor;
+    entry->user_data = slot;
+    if (slot == SL_ASYNC_SYNC_SLOT)
+    {
+        entry->opcode = IORING_OP_FSYNC;
+        entry->fsync_flags = IORING_FSYNC_DATASYNC;
+        entry->flags = IOSQE_IO_DRAIN;
+    }
+    else
+    {
+        entry->opcode = IORING_OP_WRITE;
+        entry->addr = (uint64_t)(uintptr_t)ring->buffers[slot];
+        entry->len = (uint32_t)ring->amounts[slot];
+        entry->off = (uint64_t)ring->offsets[slot];
+    }
+    ring->submissionArray[index] = index;
+    __atomic_store_n(ring->submissionTail, tail + 1, __ATOMIC_RELEASE);
+    ring->queuedCount++;
+    ring->inFlightCount++;
+#else
+    (void)ring;
+    (void)descriptor;
+    (void)slot;
+#endif
+}
+
+// =================================================================================================
+//  SL_EnterAsyncRing
+// =================================================================================================
+bool SL_EnterAsyncRing (tSL_AsyncRing* ring, uint32_t waitCount)
+{
+    long count = -1;
+
+#ifdef SL_ASYNC_WRITES_SUPPORTED
+    do
+        count = syscall(__NR_io_uring_enter, ring->descriptor, ring->queuedCount, waitCount,
+                        (waitCount > 0) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    while ((count < 0) && (errno == EINTR));
+    if (count >= 0)
+        ring->queuedCount -= (uint32_t)count;
+    else if (ring->result == SQLITE_OK)
+        ring->result = SQLITE_IOERR_WRITE;
+#else
+    (void)ring;
+    (void)waitCount;
+#endif
+
+    return (count >= 0);
+}
+
+// =================================================================================================
+//  SL_ReapAsyncRing
+// =================================================================================================
+void SL_ReapAsyncRing (tSL_AsyncRing* ring)
+{
+#ifdef SL_ASYNC_WRITES_SUPPORTED
+    uint32_t head = *(ring->completionHead);
+    uint32_t tail = __atomic_load_n(ring->completionTail, __ATOMIC_ACQUIRE);
+
+    // Only the first error is kept, since SQLite rolls back on it anyway
+    while (head != tail)
+    {
+        struct io_uring_cqe* entry = &(((struct io_uring_cqe*)ring->completionEntries)[head & ring->completionMask]);
+        int result = SQLITE_OK;
+
+        if (entry->user_data == SL_ASYNC_SYNC_SLOT)
+        {
+            if (entry->res < 0)
+                result = SQLITE_IOERR_FSYNC;
+        }
+        else if (entry->res != ring->amounts[entry->user_data])
+            result = (entry->res == -ENOSPC) ? SQLITE_FULL : SQLITE_IOERR_WRITE;
+        if ((result != SQLITE_OK) && (ring->result == SQLITE_OK))
+            ring->result = result;
+        ring->inFlightCount--;
+        head++;
+    }
+    __atomic_store_n(ring->completionHead, head, __ATOMIC_RELEASE);
+#else
+    (void)ring;
+#endif
+}
+
+// =================================================================================================
+//  SL_QueueAsyncWrite
+// =================================================================================================
+int SL_QueueAsyncWrite (tSL_AsyncRing* ring,
+                        int descriptor,
+                        const void* buffer,
+                        int amount,
+                        sqlite3_int64 offset)
+{
+    int result = SQLITE_OK;
+    bool overlaps = false;
+    uint32_t slot = 0;
+
+    // io_uring doesn't order the writes it's given, so a write that overlaps one in flight (SQLite
+    // rewrites WAL frames within a transaction) waits for it
+    for (slot = 0; (slot < ring->slotCount) && !overlaps; slot++)
+        overlaps = (offset < (ring->offsets[slot] + ring->amounts[slot])) &&
+                   (ring->offsets[slot] < (offset + amount));
+    if (overlaps || (ring->slotCount == SL_ASYNC_QUEUE_DEPTH))
+        SL_WaitAsyncRing(ring, descriptor, false);
+
+    // A failed ring's slots may still be in use, so nothing more is queued (the ring is torn down
+    // when it's next drained, and the file's writes are synchronous from then on)
+    if (ring->failed)
+        result = ring->result;
+    else
+    {
+        // Submit in batches, so the kernel starts on them before the ring is drained
+        slot = ring->slotCount++;
+        memcpy((void*)ring->buffers[slot], buffer, (size_t)amount);
+        ring->offsets[slot] = offset;
+        ring->amounts[slot] = amount;
+        SL_PrepareAsyncEntry(ring, descriptor, slot);
+        if ((ring->queuedCount >= SL_ASYNC_SUBMIT_BATCH) && !SL_EnterAsyncRing(ring, 0))
+            ring->failed = true;
+    }
+
+    // Other errors are reported when the ring is drained
+    return result;
+}
+
+// =================================================================================================
+//  SL_WaitAsyncRing
+// =================================================================================================
+void SL_WaitAsyncRing (tSL_AsyncRing* ring, int descriptor, bool sync)
+{
+    // Everything queued is submitted, and waited for, in one system call
+    if (sync && !ring->failed)
+        SL_PrepareAsyncEntry(ring, descriptor, SL_ASYNC_SYNC_SLOT);
+    while (((ring->queuedCount > 0) || (ring->inFlightCount > 0)) && !ring->failed)
+    {
+        if (SL_EnterAsyncRing(ring, ring->inFlightCount))
+            SL_ReapAsyncRing(ring);
+        else
+            ring->failed = true;
+    }
+
+    // If the ring failed, the writes that were submitted still complete (and the kernel reads
+    // their slots until they do), so they're waited for; those that weren't submitted never are
+    if (ring->failed)
+    {
+        SL_ReapAsyncRing(ring);
+        while (ring->inFlightCount > ring->queuedCount)
+        {
+            sched_yield();
+            SL_ReapAsyncRing(ring);
+        }
+    }
+
+    // Slots are only reused once nothing in flight can read them
+    if (ring->inFlightCount == 0)
+        ring->slotCount = 0;
+}
+
+// =================================================================================================
+//  SL_DrainAsyncRing
+// =================================================================================================
+int SL_DrainAsyncRing (tSL_AppendFile* appendFile, bool sync)
+{
+    int result = SQLITE_OK;
+
+    // Report the first error of the writes since the last drain
+    if (appendFile->ring != NULL)
+    {
+        SL_WaitAsyncRing(appendFile->ring, appendFile->descriptor, sync);
+        result = appendFile->ring->result;
+        appendFile->ring->result = SQLITE_OK;
+
+        // A failed ring is torn down (dropping what it never submitted), and the file falls back
+        // to synchronous writes
+        if (appendFile->ring->failed)
+        {
+            SL_CloseAsyncRing(appendFile->ring);
+            appendFile->ring = NULL;
+        }
+    }
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_DrainConnectionRings
+// =================================================================================================
+int SL_DrainConnectionRings (tSL_AppendFile* appendFile)
+{
+    int result = SL_DrainAsyncRing(appendFile, false);
+    int walResult = SQLITE_OK;
+
+    // The frames of a transaction are written to the WAL, but its WAL index is changed through the
+    // database, so the connection's writes to both have to be in their files first
+    if (appendFile->walFile != NULL)
+        walResult = SL_DrainAsyncRing(appendFile->walFile, false);
+
+    return (result == SQLITE_OK) ? walResult : result;
+}
+
+// =================================================================================================
+//  SL_AppendOpen
+// =================================================================================================
+int SL_AppendOpen (sqlite3_vfs* vfs,
+                   const char* name,
+                   sqlite3_file* file,
+                   int flags,
+                   int* outFlags)
+{
+    int result = SQLITE_OK;
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+
+    (void)vfs;
+    appendFile->file = (sqlite3_file*)(appendFile + 1);
+    appendFile->descriptor = -1;
+    appendFile->preallocate = false;
+    appendFile->allocatedSize = 0;
+    appendFile->ring = NULL;
+    appendFile->walFile = NULL;
+    appendFile->mainFile = NULL;
+
+    // Open the file with the default VFS, then get a descriptor for it if it's to be preallocated
+    // (only Linux can preallocate, or write through io_uring)
+    result = gSL_BaseVFS->xOpen(gSL_BaseVFS, name, appendFile->file, flags, outFlags);
+    if (appendFile->file->pMethods != NULL)
+    {
+        file->pMethods = &gSL_AppendIOMethods;
+#if defined(__linux__)
+        if ((result == SQLITE_OK) && gSL_BaseVFSIsUnix &&
+            ((flags & SL_APPEND_PREALLOCATED_FILES) != 0) && ((flags & SQLITE_OPEN_READWRITE) != 0))
+            appendFile->descriptor = SL_AcquireDescriptor(name);
+#endif
+
+        // A WAL is only used by the connection that opened it, through that connection's database
+        // file (which is an sl_append file too, since files are opened with their database's VFS)
+        if ((result == SQLITE_OK) && ((flags & SQLITE_OPEN_WAL) != 0))
+        {
+            sqlite3_file* mainFile = sqlite3_database_file_object(name);
+
+            if ((mainFile != NULL) && (mainFile->pMethods == &gSL_AppendIOMethods))
+            {
+                appendFile->mainFile = (tSL_AppendFile*)mainFile;
+                appendFile->mainFile->walFile = appendFile;
+            }
+        }
+
+        // What's already in the file is allocated
+        if (appendFile->descriptor >= 0)
+            appendFile->preallocate =
+                (appendFile->file->pMethods->xFileSize(appendFile->file, &(appendFile->allocatedSize)) == SQLITE_OK);
+
+        // Without io_uring (or with too old a kernel), writes stay synchronous
+        if ((appendFile->descriptor >= 0) && gAsyncWrites)
+            appendFile->ring = SL_OpenAsyncRing();
+    }
+    else
+        file->pMethods = NULL;
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendClose
+// =================================================================================================
+int SL_AppendClose (sqlite3_file* file)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+    int closeResult = SQLITE_OK;
+
+    if (appendFile->ring != NULL)
+    {
+        SL_CloseAsyncRing(appendFile->ring);
+        appendFile->ring = NULL;
+    }
+    if (appendFile->mainFile != NULL)
+        appendFile->mainFile->walFile = NULL;
+    if (appendFile->walFile != NULL)
+        appendFile->walFile->mainFile = NULL;
+    closeResult = appendFile->file->pMethods->xClose(appendFile->file);
+
+    // The descriptor is released once the default VFS has released its locks
+    if (appendFile->descriptor >= 0)
+    {
+        SL_ReleaseDescriptor(appendFile->descriptor);
+        appendFile->descriptor = -1;
+    }
+
+    return (result == SQLITE_OK) ? closeResult : result;
+}
+
+// =================================================================================================
+//  SL_AppendRead
+// =================================================================================================
+int SL_AppendRead (sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xRead(appendFile->file, buffer, amount, offset);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendWrite
+// =================================================================================================
+int SL_AppendWrite (sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+
+    // Allocate the blocks of the next extent in one go, rather than a few at a time as the file
+    // grows; the file size is left alone, so SQLite sees the same file it would have without
+    // preallocation
+    int result = SQLITE_OK;
+
+    if (appendFile->preallocate && ((offset + amount) > appendFile->allocatedSize))
+    {
+#if defined(__linux__)
+        sqlite3_int64 extentEnd =
+            (((offset + amount) + SL_APPEND_EXTENT_SIZE - 1) / SL_APPEND_EXTENT_SIZE) * SL_APPEND_EXTENT_SIZE;
+
+        if (fallocate(appendFile->descriptor, FALLOC_FL_KEEP_SIZE, (off_t)appendFile->allocatedSize,
+                      (off_t)(extentEnd - appendFile->allocatedSize)) == 0)
+            appendFile->allocatedSize = extentEnd;
+        else    // The file system can't preallocate, so stop trying
+            appendFile->preallocate = false;
+#else
+        // Only Linux can allocate blocks without changing the file size
+        appendFile->preallocate = false;
+#endif
+    }
+
+    // Writes through io_uring are copied and queued, and only waited for when the file is synced
+    // or otherwise used (writes too big to copy wait for the queue, and are made directly)
+    if ((appendFile->ring != NULL) && (amount <= SL_ASYNC_SLOT_SIZE))
+        result = SL_QueueAsyncWrite(appendFile->ring, appendFile->descriptor, buffer, amount, offset);
+    else
+    {
+        result = SL_DrainAsyncRing(appendFile, false);
+        if (result == SQLITE_OK)
+            result = appendFile->file->pMethods->xWrite(appendFile->file, buffer, amount, offset);
+    }
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendTruncate
+// =================================================================================================
+int SL_AppendTruncate (sqlite3_file* file, sqlite3_int64 size)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+
+    // Truncating frees the blocks past the new end of the file, preallocated or not
+    if (size < appendFile->allocatedSize)
+        appendFile->allocatedSize = size;
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xTruncate(appendFile->file, size);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendSync
+// =================================================================================================
+int SL_AppendSync (sqlite3_file* file, int flags)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SQLITE_OK;
+
+    // With io_uring, the sync is queued behind the writes, so the writes and the sync of a
+    // transaction are submitted and waited for together (like the default VFS, the sync is an
+    // fdatasync, and neither needs the directory synced)
+    if (appendFile->ring != NULL)
+        result = SL_DrainAsyncRing(appendFile, true);
+    else
+        result = appendFile->file->pMethods->xSync(appendFile->file, flags);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendFileSize
+// =================================================================================================
+int SL_AppendFileSize (sqlite3_file* file, sqlite3_int64* size)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xFileSize(appendFile->file, size);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendLock
+// =================================================================================================
+int SL_AppendLock (sqlite3_file* file, int lock)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+
+    return appendFile->file->pMethods->xLock(appendFile->file, lock);
+}
+
+// =================================================================================================
+//  SL_AppendUnlock
+// =================================================================================================
+int SL_AppendUnlock (sqlite3_file* file, int lock)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xUnlock(appendFile->file, lock);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendCheckReservedLock
+// =================================================================================================
+int SL_AppendCheckReservedLock (sqlite3_file* file, int* reserved)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+
+    return appendFile->file->pMethods->xCheckReservedLock(appendFile->file, reserved);
+}
+
+// =================================================================================================
+//  SL_AppendFileControl
+// =================================================================================================
+int SL_AppendFileControl (sqlite3_file* file, int operation, void* argument)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+
+    // A file with a chunk size is grown (and allocated) a chunk at a time by the default VFS, so
+    // preallocating its blocks as well would only cost system calls
+    if ((operation == SQLITE_FCNTL_CHUNK_SIZE) && (*((int*)argument) > 0))
+        appendFile->preallocate = false;
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xFileControl(appendFile->file, operation, argument);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendSectorSize
+// =================================================================================================
+int SL_AppendSectorSize (sqlite3_file* file)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+
+    return appendFile->file->pMethods->xSectorSize(appendFile->file);
+}
+
+// =================================================================================================
+//  SL_AppendDeviceCharacteristics
+// =================================================================================================
+int SL_AppendDeviceCharacteristics (sqlite3_file* file)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+
+    return appendFile->file->pMethods->xDeviceCharacteristics(appendFile->file);
+}
+
+// =================================================================================================
+//  SL_AppendShmMap
+// =================================================================================================
+int SL_AppendShmMap (sqlite3_file* file, int region, int size, int extend, void volatile** memory)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xShmMap(appendFile->file, region, size, extend, memory);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendShmLock
+// =================================================================================================
+int SL_AppendShmLock (sqlite3_file* file, int offset, int count, int flags)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainConnectionRings(appendFile);
+
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xShmLock(appendFile->file, offset, count, flags);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendShmBarrier
+// =================================================================================================
+void SL_AppendShmBarrier (sqlite3_file* file)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+
+    // SQLite writes the WAL index header around a barrier once a transaction's frames are
+    // written to the WAL, so other connections mustn't see the header before the frames are in
+    // the file (a failed write is reported the next time the file is used)
+    if (appendFile->ring != NULL)
+        SL_WaitAsyncRing(appendFile->ring, appendFile->descriptor, false);
+    if ((appendFile->walFile != NULL) && (appendFile->walFile->ring != NULL))
+        SL_WaitAsyncRing(appendFile->walFile->ring, appendFile->walFile->descriptor, false);
+    appendFile->file->pMethods->xShmBarrier(appendFile->file);
+}
+
+// =================================================================================================
+//  SL_AppendShmUnmap
+// =================================================================================================
+int SL_AppendShmUnmap (sqlite3_file* file, int deleteFlag)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xShmUnmap(appendFile->file, deleteFlag);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendFetch
+// =================================================================================================
+int SL_AppendFetch (sqlite3_file* file, sqlite3_int64 offset, int amount, void** memory)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+    int result = SL_DrainAsyncRing(appendFile, false);
+
+    if (result == SQLITE_OK)
+        result = appendFile->file->pMethods->xFetch(appendFile->file, offset, amount, memory);
+
+    return result;
+}
+
+// =================================================================================================
+//  SL_AppendUnfetch
+// =================================================================================================
+int SL_AppendUnfetch (sqlite3_file* file, sqlite3_int64 offset, void* memory)
+{
+    tSL_AppendFile* appendFile = (tSL_AppendFile*)file;
+
+    return appendFile->file->pMethods->xUnfetch(appendFile->file, offset, memory);
+}
+
+// =================================================================================================
@@ -0,0 +1,46 @@
+// =================================================================================================
+//! @file sqlite_logger_vfs.h
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file contains the private interface for the SQLite Logger append VFS.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-25
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#ifndef __SQLITE_LOGGER_VFS_H__
+#define __SQLITE_LOGGER_VFS_H__
+
+#include "sqlite_logger.h"
+#include "sqlite3.h"
+
+// =================================================================================================
+//  Constants
+// =================================================================================================
+
+//  Name of the VFS that the SQLite Logger database connection uses
+#define SL_APPEND_VFS_NAME              "sl_append"
+
+//  Size of the extents that database and WAL files are preallocated in
+#define SL_APPEND_EXTENT_SIZE           (8 * 1024 * 1024)
+
+// =================================================================================================
+//  Prototypes
+// =================================================================================================
+
+//  Registers the sl_append VFS (once), a shim over the default VFS that preallocates the blocks
+//  of database and WAL files in large extents ahead of their writes
+int32_t SL_RegisterAppendVFS (void);
+
+//  Sets whether the database and WAL files opened from now on are written through io_uring
+//  (files fall back to synchronous writes where io_uring isn't available)
+void SL_SetAppendAsyncWrites (bool enable);
+
+//  Returns the memory (mostly copies of the writes in flight) that io_uring writes take for each
+//  database or WAL file, or 0 where they aren't supported
+uint64_t SL_GetAppendAsyncWriteMemory (void);
+
+// =================================================================================================
+#endif	// __SQLITE_LOGGER_VFS_H__
+// =================================================================================================
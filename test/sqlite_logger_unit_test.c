@@ -12,13 +12,63 @@
 #include <CUnit.h>
 #include <Automated.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include "sqlite_logger.h"
 
 // =================================================================================================
 //  Private constants
 // =================================================================================================
-#define LOG_PATH    "../results/sqlite_logger_unit_test.sqlite3"
+#define LOG_PATH                "../results/sqlite_logger_unit_test.sqlite3"
+#define COMPRESSION_THRESHOLD   64
+#define DICTIONARY_MESSAGE_COUNT    2048
+#define EXPORT_PATH             "../results/sqlite_logger_unit_test.ndjson"
+#define PARALLEL_EXPORT_PATH    "../results/sqlite_logger_unit_test_parallel.ndjson"
+#define IMPORT_PATH             "../results/sqlite_logger_unit_test_import.log"
+#define IMPORT_NDJSON_PATH      "../results/sqlite_logger_unit_test_import.ndjson"
+#define MERGE_PATH              "../results/sqlite_logger_unit_test_merge.ndjson"
+#define PARALLEL_MERGE_PATH     "../results/sqlite_logger_unit_test_parallel_merge.ndjson"
+#define MERGE_DATABASE_PATH     "../results/sqlite_logger_unit_test_merge.sqlite3"
+#define MEMORY_BUDGET           (8 * 1024 * 1024)
+#define MISUSE_RESULT           21      // SQLITE_MISUSE (the test doesn't include sqlite3.h)
+#define MEMORY_MESSAGE_COUNT    2048
+#define FAILED_BATCH_MESSAGE_COUNT  2048    // More than a batch
+#define ASYNC_MESSAGE_COUNT     2048
+#define ASYNC_WAL_LOG_PATH      "../results/sqlite_logger_unit_test_async_wal.sqlite3"
+#define ASYNC_CHECKPOINT_INTERVAL   1
+#define MEMORY_MAP_SIZE         (64 * 1024 * 1024)
+#define MEMORY_MAP_EXPORT_PATH  "../results/sqlite_logger_unit_test_mmap.ndjson"
+#define CHECKPOINT_INTERVAL     20
+#define CHECKPOINT_PAGE_COUNT   64
+#define CHECKPOINT_MESSAGE_COUNT    4096
+#define CHECKPOINT_LOG_PATH     "../results/sqlite_logger_unit_test_checkpoint.sqlite3"
+#define CHUNK_SIZE              (4 * 1024 * 1024)
+#define CHUNK_LOG_PATH          "../results/sqlite_logger_unit_test_chunk.sqlite3"
+#define MEMORY_LIMIT            (16 * 1024 * 1024)
+#define SPAN_SLEEP_TIME         2000    // In microseconds
+#define TABLE_NAME_LENGTH       256
+#define METRIC_INTERVAL         3600    // In seconds
+#define METRIC_VALUE_COUNT      100
+#define METRIC_MESSAGE_COUNT    2048    // More than a batch
+#define ROLLUP_MESSAGE_COUNT    2048
+
+// =================================================================================================
+//  Private macros
+// =================================================================================================
+
+//  Ends the current session, changes a setting that can only be changed before SL_Initialize, and
+//  starts a session in logPath (removing the file first, if newLogFile is true, so the session
+//  starts in a new log file); it's a macro, so failed assertions report the test's line
+#define SL_RESTART_SESSION(logPath, newLogFile, setting)            \
+    do                                                              \
+    {                                                               \
+        CU_ASSERT_EQUAL(SL_Terminate(), SL_RESULT_SUCCESS);         \
+        CU_ASSERT_EQUAL((setting), SL_RESULT_SUCCESS);              \
+        if (newLogFile)                                             \
+            (void)remove(logPath);                                  \
+        CU_ASSERT_EQUAL(SL_Initialize(logPath), SL_RESULT_SUCCESS); \
+    } while (0)
 
 // =================================================================================================
 //  SL_SuiteInit
@@ -46,6 +96,64 @@ int SL_SuiteCleanup (void)
     return CUE_SUCCESS;
 }
 
+// =================================================================================================
+//  SL_CompressionSuiteInit
+// =================================================================================================
+int SL_CompressionSuiteInit (void)
+{
+    CU_ErrorCode status = CUE_SUCCESS;
+
+    int32_t result = SL_SetCompressionThreshold(COMPRESSION_THRESHOLD);
+    if (result == SL_RESULT_SUCCESS)
+        result = SL_Initialize(LOG_PATH);
+    if (result != SL_RESULT_SUCCESS)
+    {
+        status = CUE_SINIT_FAILED;
+        CU_FAIL_FATAL("SL_Initialize failed!");
+    }
+    return status;
+}
+
+// =================================================================================================
+//  SL_CompressionSuiteCleanup
+// =================================================================================================
+int SL_CompressionSuiteCleanup (void)
+{
+    (void)SL_Terminate();
+    (void)SL_SetCompressionThreshold(0);
+
+    return CUE_SUCCESS;
+}
+
+// =================================================================================================
+//  SL_DictionarySuiteInit
+// =================================================================================================
+int SL_DictionarySuiteInit (void)
+{
+    CU_ErrorCode status = CUE_SUCCESS;
+
+    int32_t result = SL_SetDictionaryCompression(true);
+    if (result == SL_RESULT_SUCCESS)
+        result = SL_Initialize(LOG_PATH);
+    if (result != SL_RESULT_SUCCESS)
+    {
+        status = CUE_SINIT_FAILED;
+        CU_FAIL_FATAL("SL_Initialize failed!");
+    }
+    return status;
+}
+
+// =================================================================================================
+//  SL_DictionarySuiteCleanup
+// =================================================================================================
+int SL_DictionarySuiteCleanup (void)
+{
+    (void)SL_Terminate();
+    (void)SL_SetDictionaryCompression(false);
+
+    return CUE_SUCCESS;
+}
+
 // =================================================================================================
 //  SL_TestLogLevel
 // =================================================================================================
@@ -259,6 +367,1148 @@ void SL_TestLogging (void)
     SL_LOG_ASSERT(test == false, "Fail", "test == false");
 }
 
+// =================================================================================================
+//  SL_CountCallback
+// =================================================================================================
+int SL_CountCallback (void* context, int columnCount, char** values, char** names)
+{
+    (void)names;
+    if ((columnCount == 1) && (values[0] != NULL))
+        *((int*)context) = atoi(values[0]);
+
+    return 0;
+}
+
+// =================================================================================================
+//  SL_StringCallback
+// =================================================================================================
+int SL_StringCallback (void* context, int columnCount, char** values, char** names)
+{
+    (void)names;
+    if ((columnCount == 1) && (values[0] != NULL))
+        snprintf((char*)context, TABLE_NAME_LENGTH, "%s", values[0]);
+
+    return 0;
+}
+
+// =================================================================================================
+//  SL_GetSessionTableName
+// =================================================================================================
+void SL_GetSessionTableName (char* tableName)
+{
+    // Only the current session's table has a live view (a TEMP one)
+    int32_t result = SL_Query("SELECT substr(name, 1, length(name) - 5) FROM sqlite_temp_master WHERE type = 'view' AND "
+                              "name LIKE 'log at %.live'",
+                              SL_StringCallback, (void*)tableName);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_CloseSession
+// =================================================================================================
+void SL_CloseSession (char* tableName)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+
+    // Entries are only compressed as they're written, so the session is closed to write them all
+    SL_GetSessionTableName(tableName);
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_TestFailedBatch
+// =================================================================================================
+void SL_TestFailedBatch (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char sql[TABLE_NAME_LENGTH + 256] = {0};
+    char message[128] = {0};
+    uint_fast32_t i = 0;
+    uint_fast32_t loggedCount = 0;
+    int count = 0;
+
+    // Make the session's inserts fail until the trigger is dropped
+    SL_GetSessionTableName(tableName);
+    sprintf(sql, "CREATE TEMP TRIGGER `failing batch` BEFORE INSERT ON main.`%s` "
+            "BEGIN SELECT RAISE(ABORT, 'Failing batch'); END", tableName);
+    result = SL_Query(sql, NULL, NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    for (i = 0; (i < FAILED_BATCH_MESSAGE_COUNT) && (result == SL_RESULT_SUCCESS); i++)
+    {
+        sprintf(message, "Failed batch message %u.", (unsigned int)i);
+        result = SL_LOG_INFO_MESSAGE(message, "Failed batch tag", NULL);
+        if (result == SL_RESULT_SUCCESS)
+            loggedCount++;
+    }
+    CU_ASSERT_NOT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // The entries are kept, and the next batch writes them
+    result = SL_Query("DROP TRIGGER temp.`failing batch`", NULL, NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_INFO_MESSAGE("Failed batch message after the failure.", "Failed batch tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    SL_CloseSession(tableName);
+    sprintf(sql, "SELECT COUNT(*) FROM `%s` WHERE log_tag = 'Failed batch tag'", tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, (int)(loggedCount + 1));
+}
+
+// =================================================================================================
+//  SL_TestRateLimiting
+// =================================================================================================
+void SL_TestRateLimiting (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char sql[512] = {0};
+    uint_fast32_t i = 0;
+    int count = 0;
+
+    // Try to set a rate limit with bad arguments
+    result = SL_SetRateLimit(10, 0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Allow a burst of 5 identical messages
+    result = SL_SetRateLimit(1, 5);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // Log a storm of identical messages; repeats past the burst are collapsed
+    for (i = 0; i < 1000; i++)
+    {
+        result = SL_LOG_WARNING_MESSAGE("This is a rate limited warning message.",
+                                        "Rate limit tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+
+    // Different messages have their own buckets
+    result = SL_LOG_WARNING_MESSAGE("This is a different warning message.",
+                                    "Rate limit tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // The burst got its own rows (and a few more, if the storm outlasted a second or a batch), and
+    // the rest of the storm was counted in their repeat counts
+    SL_GetSessionTableName(tableName);
+    sprintf(sql, "SELECT COUNT(*) FROM `%s.live` WHERE log_message = 'This is a rate limited warning message.'",
+            tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE((count >= 5) && (count <= 10));
+    sprintf(sql, "SELECT SUM(log_repeat_count) FROM `%s.live` WHERE log_message = 'This is a rate limited warning message.'",
+            tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1000);
+    sprintf(sql, "SELECT COUNT(*) FROM `%s.live` WHERE log_message = 'This is a different warning message.'",
+            tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+
+    // Disable rate limiting
+    result = SL_SetRateLimit(0, 0);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_TestSampling
+// =================================================================================================
+void SL_TestSampling (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char sql[512] = {0};
+    uint_fast32_t i = 0;
+    int count = 0;
+
+    // Try to set sampling rates with bad arguments
+    result = SL_SetSamplingRate((tSL_LogLevel)1234, 0.5);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SL_SetSamplingRate(eSL_LogLevel_Diagnostic, 0.0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SL_SetSamplingRate(eSL_LogLevel_Diagnostic, 1.5);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SL_SetTagSamplingRate(NULL, 0.5);
+    CU_ASSERT_EQUAL(result, EFAULT);
+    result = SL_SetTagSamplingRate("", 0.5);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Keep 1% of diagnostic messages and 10% of messages with the sampled tag
+    result = SL_SetLogLevel(eSL_LogLevel_Diagnostic);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetSamplingRate(eSL_LogLevel_Diagnostic, 0.01);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetTagSamplingRate("Sampled tag", 0.1);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    for (i = 0; i < 2000; i++)
+    {
+        result = SL_LOG_DIAGNOSTIC_MESSAGE("This is a sampled diagnostic message.",
+                                           "Diagnostic tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+        result = SL_LOG_INFO_MESSAGE("This is a sampled info message.",
+                                     "Sampled tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+
+    // About 20 diagnostic messages were kept (none would be kept once in 500 million runs), each
+    // with the rate it was sampled at
+    SL_GetSessionTableName(tableName);
+    sprintf(sql, "SELECT COUNT(*) FROM `%s.live` WHERE log_message = 'This is a sampled diagnostic message.'",
+            tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE((count > 0) && (count < 100));
+    sprintf(sql, "SELECT COUNT(*) FROM `%s.live` WHERE log_message = 'This is a sampled diagnostic message.' AND "
+            "log_sample_rate != 0.01", tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 0);
+
+    // About 200 messages with the sampled tag were kept (the bounds are over 7 standard
+    // deviations away), each with the tag's rate
+    sprintf(sql, "SELECT COUNT(*) FROM `%s.live` WHERE log_message = 'This is a sampled info message.'",
+            tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE((count > 100) && (count < 300));
+    sprintf(sql, "SELECT COUNT(*) FROM `%s.live` WHERE log_message = 'This is a sampled info message.' AND "
+            "log_sample_rate != 0.1", tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 0);
+
+    // Restore defaults
+    result = SL_SetTagSamplingRate("Sampled tag", 1.0);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetSamplingRate(eSL_LogLevel_Diagnostic, 1.0);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetLogLevel(eSL_LogLevel_Info);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_TestCompression
+// =================================================================================================
+void SL_TestCompression (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char message[512] = {0};
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char sql[2048] = {0};
+    uint_fast32_t i = 0;
+    int count = 0;
+
+    // Compression can't be changed once initialized
+    result = SL_SetCompressionThreshold(COMPRESSION_THRESHOLD);
+    CU_ASSERT_EQUAL(result, SL_RESULT_ALREADY_INITIALIZED);
+
+    // Build a long, compressible message
+    for (i = 0; i < 16; i++)
+        strcat(message, "Frame rendered in 16 ms. ");
+
+    // Log messages above and below the compression threshold (the short one is too short for
+    // dictionary compression as well)
+    result = SL_LOG_INFO_MESSAGE(message, "Compression tag", message);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_INFO_MESSAGE("Too short.", "Compression tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // The long message is stored compressed, and sl_decompress gives it back
+    SL_CloseSession(tableName);
+    sprintf(sql, "SELECT COUNT(*) FROM `%s` WHERE log_tag = 'Compression tag' AND typeof(log_message) = 'blob' AND "
+            "length(log_message) < %u AND sl_decompress(log_message) = '%s' AND sl_decompress(log_supplementaldata) = '%s'",
+            tableName, (unsigned int)strlen(message), message, message);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+
+    // The short message is stored as text
+    sprintf(sql, "SELECT COUNT(*) FROM `%s` WHERE log_tag = 'Compression tag' AND typeof(log_message) = 'text' AND "
+            "log_message = 'Too short.' AND sl_decompress(log_message) = 'Too short.'", tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+}
+
+// =================================================================================================
+//  SL_TestDictionaryCompression
+// =================================================================================================
+void SL_TestDictionaryCompression (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char message[128] = {0};
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char sql[1024] = {0};
+    uint_fast32_t i = 0;
+    int count = 0;
+    int compressedCount = 0;
+
+    // Dictionary compression can't be changed once initialized
+    result = SL_SetDictionaryCompression(false);
+    CU_ASSERT_EQUAL(result, SL_RESULT_ALREADY_INITIALIZED);
+
+    // Log enough short, similar messages to train a dictionary and compress against it
+    for (i = 0; i < DICTIONARY_MESSAGE_COUNT; i++)
+    {
+        sprintf(message, "Request %u from client %u completed in %u ms.", 
+                (unsigned int)i, (unsigned int)(i % 7), (unsigned int)(i % 50));
+        result = SL_LOG_INFO_MESSAGE(message, "Dictionary tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+
+    // A dictionary was trained and stored
+    SL_CloseSession(tableName);
+    result = SL_Query("SELECT COUNT(*) FROM `log dictionaries`", SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(count > 0);
+
+    // Rows compressed with it start with the dictionary marker, followed by the dictionary id (a
+    // varint, of 1 or 2 bytes for ids below 16384) that matches log_dictionary_id
+    sprintf(sql, "SELECT COUNT(*) FROM `%s` WHERE log_tag = 'Dictionary tag' AND typeof(log_message) = 'blob' AND "
+            "hex(substr(log_message, 1, 1)) = 'C6' AND "
+            "log_dictionary_id IN (SELECT dictionary_id FROM `log dictionaries`) AND "
+            "hex(substr(log_message, 2, CASE WHEN log_dictionary_id < 128 THEN 1 ELSE 2 END)) = "
+            "CASE WHEN log_dictionary_id < 128 THEN printf('%%02X', log_dictionary_id) "
+            "ELSE printf('%%02X%%02X', (log_dictionary_id & 127) | 128, log_dictionary_id >> 7) END", tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&compressedCount);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(compressedCount > (DICTIONARY_MESSAGE_COUNT / 2));
+
+    // And they decompress back to the messages that were logged
+    sprintf(sql, "SELECT COUNT(*) FROM `%s` WHERE log_tag = 'Dictionary tag' AND log_dictionary_id IS NOT NULL AND "
+            "sl_decompress(log_message) LIKE 'Request %% from client %% completed in %% ms.'", tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, compressedCount);
+    sprintf(sql, "SELECT COUNT(*) FROM `%s` WHERE log_dictionary_id IS NOT NULL AND "
+            "sl_decompress(log_message) = 'Request %u from client %u completed in %u ms.'", tableName,
+            (unsigned int)(DICTIONARY_MESSAGE_COUNT - 1), (unsigned int)((DICTIONARY_MESSAGE_COUNT - 1) % 7),
+            (unsigned int)((DICTIONARY_MESSAGE_COUNT - 1) % 50));
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+}
+
+// =================================================================================================
+//  SL_TestArchive
+// =================================================================================================
+void SL_TestArchive (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char closedTableName[TABLE_NAME_LENGTH] = {0};
+    char tableName[TABLE_NAME_LENGTH + 16] = {0};
+    char before[TABLE_NAME_LENGTH] = {0};
+    char after[TABLE_NAME_LENGTH] = {0};
+    char sql[1024] = {0};
+    const char* summary =
+        "SELECT COUNT(*) || ':' || TOTAL(log_linenumber) || ':' || TOTAL(log_repeat_count) || ':' || "
+        "TOTAL(length(sl_decompress(log_message))) || ':' || MIN(log_timestamp) || ':' || MAX(log_level) FROM %s";
+    int archiveCount = 0;
+    int count = 0;
+
+    // Close this session's log table by starting a new session, and summarize its rows
+    SL_CloseSession(closedTableName);
+    sprintf(tableName, "`%s`", closedTableName);
+    sprintf(sql, summary, tableName);
+    result = SL_Query(sql, SL_StringCallback, (void*)before);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(strncmp(before, "0:", 2) != 0);
+
+    // Archive the closed log tables; only the current session's table is left
+    result = SL_ArchiveClosedLogs();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    SL_GetSessionTableName(tableName);
+    sprintf(sql, "SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name LIKE 'log at %%' AND name != '%s'",
+            tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 0);
+
+    // The archive has the same rows, through sl_archive and through the view that replaced the table
+    sprintf(tableName, "sl_archive('%s')", closedTableName);
+    sprintf(sql, summary, tableName);
+    result = SL_Query(sql, SL_StringCallback, (void*)after);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(strcmp(before, after) == 0);
+    memset((void*)after, 0, sizeof(after));
+    sprintf(tableName, "`%s`", closedTableName);
+    sprintf(sql, summary, tableName);
+    result = SL_Query(sql, SL_StringCallback, (void*)after);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(strcmp(before, after) == 0);
+
+    // Logging to the new session still works, and there's nothing left to archive
+    result = SL_LOG_INFO_MESSAGE("Logged after archiving.", "Archive tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Query("SELECT COUNT(*) FROM `log archive`", SL_CountCallback, (void*)&archiveCount);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_ArchiveClosedLogs();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Query("SELECT COUNT(*) FROM `log archive`", SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, archiveCount);
+}
+
+// =================================================================================================
+//  SL_TestPending
+// =================================================================================================
+void SL_TestPending (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char sql[TABLE_NAME_LENGTH + 128] = {0};
+    int count = -1;
+
+    // Query arguments are checked
+    result = SL_Query(NULL, NULL, NULL);
+    CU_ASSERT_EQUAL(result, EFAULT);
+
+    // Unflushed entries are visible on the logger connection
+    result = SL_LOG_ERROR_MESSAGE("This message is still pending.", "Pending tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Query("SELECT COUNT(*) FROM sl_pending WHERE log_tag = 'Pending tag' AND log_level = 'Error'",
+                      SL_CountCallback, &count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+
+    // So are they in the session's live view, which isn't in the log file, and only lasts as
+    // long as the session
+    SL_GetSessionTableName(tableName);
+    sprintf(sql, "SELECT COUNT(*) FROM `%s.live` WHERE log_id IS NULL AND log_tag = 'Pending tag'", tableName);
+    result = SL_Query(sql, SL_CountCallback, &count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+    result = SL_Query("SELECT COUNT(*) FROM sqlite_master WHERE name LIKE 'log at %.live'", SL_CountCallback, &count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 0);
+    SL_CloseSession(tableName);
+    sprintf(sql, "SELECT COUNT(*) FROM sqlite_temp_master WHERE name = '%s.live'", tableName);
+    result = SL_Query(sql, SL_CountCallback, &count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 0);
+}
+
+// =================================================================================================
+//  SL_SubscriptionCallback
+// =================================================================================================
+void SL_SubscriptionCallback (const tSL_LogRecord* record, void* context)
+{
+    if ((record->level == eSL_LogLevel_Error) && (strcmp(record->tag, "Subscription tag") == 0))
+        (*((int*)context))++;
+}
+
+// =================================================================================================
+//  SL_UnsubscribingCallback
+// =================================================================================================
+void SL_UnsubscribingCallback (const tSL_LogRecord* record, void* context)
+{
+    uint32_t* state = (uint32_t*)context;   // The subscription id, then the delivery count
+
+    // Unsubscribe from the first delivery
+    (void)record;
+    CU_ASSERT_EQUAL(SL_Unsubscribe(state[0]), SL_RESULT_SUCCESS);
+    state[1]++;
+}
+
+// =================================================================================================
+//  SL_TestSubscription
+// =================================================================================================
+void SL_TestSubscription (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_SubscriptionFilter filter = {eSL_LogLevel_Error, "Subscription tag", false};
+    uint32_t subscriptionId = 0;
+    uint32_t state[2] = {0, 0};
+    int count = 0;
+
+    // Subscription arguments are checked
+    result = SL_Subscribe(NULL, SL_SubscriptionCallback, &count, &subscriptionId);
+    CU_ASSERT_EQUAL(result, EFAULT);
+    result = SL_Unsubscribe(12345);
+    CU_ASSERT_EQUAL(result, ENOENT);
+
+    // Only entries that match the filter are delivered
+    result = SL_Subscribe(&filter, SL_SubscriptionCallback, &count, &subscriptionId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_ERROR_MESSAGE("This error is delivered.", "Subscription tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_WARNING_MESSAGE("This warning isn't delivered.", "Subscription tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_ERROR_MESSAGE("This error isn't delivered.", "Another tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+
+    // Nothing is delivered after unsubscribing
+    result = SL_Unsubscribe(subscriptionId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_ERROR_MESSAGE("This error isn't delivered either.", "Subscription tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+    result = SL_Unsubscribe(subscriptionId);
+    CU_ASSERT_EQUAL(result, ENOENT);
+
+    // A callback can unsubscribe itself
+    result = SL_Subscribe(&filter, SL_UnsubscribingCallback, (void*)state, &(state[0]));
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_ERROR_MESSAGE("This error is delivered once.", "Subscription tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_ERROR_MESSAGE("This error isn't delivered.", "Subscription tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(state[1], 1);
+    result = SL_Unsubscribe(state[0]);
+    CU_ASSERT_EQUAL(result, ENOENT);
+
+    // Subscriptions still work after it, and a stale id doesn't unsubscribe the subscription
+    // that reuses its slot
+    result = SL_Subscribe(&filter, SL_SubscriptionCallback, &count, &subscriptionId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(subscriptionId % 16, state[0] % 16);
+    CU_ASSERT_NOT_EQUAL(subscriptionId, state[0]);
+    result = SL_Unsubscribe(state[0]);
+    CU_ASSERT_EQUAL(result, ENOENT);
+    result = SL_LOG_ERROR_MESSAGE("This error is delivered too.", "Subscription tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 2);
+    result = SL_Unsubscribe(subscriptionId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // Entries are delivered to a write subscription once they're written, not when logged (the
+    // entries logged so far are written first)
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    count = 0;
+    filter.onWrite = true;
+    result = SL_Subscribe(&filter, SL_SubscriptionCallback, &count, &subscriptionId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_ERROR_MESSAGE("This error is delivered when written.", "Subscription tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_LOG_WARNING_MESSAGE("This warning isn't delivered when written.", "Subscription tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 0);
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Unsubscribe(subscriptionId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_FilesMatch
+// =================================================================================================
+bool SL_FilesMatch (const char* path1, const char* path2)
+{
+    bool match = false;
+    FILE* file1 = fopen(path1, "rb");
+    FILE* file2 = fopen(path2, "rb");
+
+    if ((file1 != NULL) && (file2 != NULL))
+    {
+        int c1 = 0;
+        int c2 = 0;
+
+        do
+        {
+            c1 = getc(file1);
+            c2 = getc(file2);
+        } while ((c1 == c2) && (c1 != EOF));
+        match = (c1 == c2);
+    }
+    if (file1 != NULL)
+        (void)fclose(file1);
+    if (file2 != NULL)
+        (void)fclose(file2);
+
+    return match;
+}
+
+// =================================================================================================
+//  SL_TestExport
+// =================================================================================================
+void SL_TestExport (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_ExportOptions options = {eSL_ExportFormat_NDJSON, NULL, NULL, NULL, 1};
+    tSL_ExportOptions badOptions = {(tSL_ExportFormat)99, NULL, NULL, NULL, 1};
+
+    // Export arguments are checked
+    result = SL_Export(LOG_PATH, NULL, &options);
+    CU_ASSERT_EQUAL(result, EFAULT);
+    result = SL_Export(LOG_PATH, EXPORT_PATH, &badOptions);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Exporting with several threads gives the same result as exporting with one
+    result = SL_Export(LOG_PATH, EXPORT_PATH, &options);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    options.threadCount = 4;
+    result = SL_Export(LOG_PATH, PARALLEL_EXPORT_PATH, &options);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(SL_FilesMatch(EXPORT_PATH, PARALLEL_EXPORT_PATH));
+}
+
+// =================================================================================================
+//  SL_TestImport
+// =================================================================================================
+void SL_TestImport (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_ImportOptions options = {eSL_ImportFormat_Text, 2};
+    uint64_t entryCount = 0;
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char sql[TABLE_NAME_LENGTH + 256] = {0};
+    int count = 0;
+    FILE* file = fopen(IMPORT_PATH, "w");
+
+    // A text log with a timestamp and level, a bare message, and a line with no message
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+    fputs("2022-03-14 10:00:00.000000 CDT WARN Imported warning\n", file);
+    fputs("Imported message\n", file);
+    fputs("2022-03-14 10:00:01.000000 CDT ERROR\n", file);
+    (void)fclose(file);
+
+    result = SL_Import(IMPORT_PATH, &options, &entryCount);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(entryCount, 2);
+
+    // The bare message has the timestamp of the line before it
+    result = SL_Query("SELECT name FROM sqlite_master WHERE type = 'table' AND name GLOB 'log at [0-9]*' "
+                      "ORDER BY name DESC LIMIT 1", SL_StringCallback, (void*)tableName);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    sprintf(sql, "SELECT COUNT(*) FROM `%s` WHERE log_message = 'Imported message' AND "
+            "log_timestamp = '2022-03-14 10:00:00.000000 CDT'", tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+
+    // Entries in the format of an export import back (a small file is written, rather than
+    // importing the whole log into itself, so the log doesn't grow with every run)
+    file = fopen(IMPORT_NDJSON_PATH, "w");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(file);
+    fputs("{\"log_table\":\"log at 2022-03-14 10:00:00.000000 CDT\",\"log_id\":1,"
+          "\"log_timestamp\":\"2022-03-14 10:00:02.000000 CDT\",\"log_message\":\"Exported info\","
+          "\"log_level\":\"Info\",\"log_filename\":\"import.c\",\"log_functionname\":\"main\","
+          "\"log_linenumber\":10,\"log_tag\":\"Import tag\",\"log_supplementaldata\":\"Data\","
+          "\"log_repeat_count\":1,\"log_sample_rate\":1}\n", file);
+    fputs("{\"log_table\":\"log at 2022-03-14 10:00:00.000000 CDT\",\"log_id\":2,"
+          "\"log_timestamp\":\"2022-03-14 10:00:03.000000 CDT\",\"log_message\":\"Exported error\","
+          "\"log_level\":\"Error\",\"log_tag\":\"Import tag\",\"log_repeat_count\":3,"
+          "\"log_sample_rate\":1}\n", file);
+    (void)fclose(file);
+    options.format = eSL_ImportFormat_NDJSON;
+    result = SL_Import(IMPORT_NDJSON_PATH, &options, &entryCount);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(entryCount, 2);
+
+    // Logging to the session still works
+    result = SL_LOG_INFO_MESSAGE("Logged after importing.", "Import tag", NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_TestMerge
+// =================================================================================================
+void SL_TestMerge (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    const char* logPaths[] = {LOG_PATH, LOG_PATH};
+    tSL_MergeOptions options = {eSL_MergeOutput_NDJSON, NULL, NULL, 0};
+    uint64_t entryCount = 0;
+    uint64_t parallelEntryCount = 0;
+    uint64_t databaseEntryCount = 0;
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char mergedTableName[TABLE_NAME_LENGTH] = {0};
+    char sql[TABLE_NAME_LENGTH + 256] = {0};
+    int count = -1;
+
+    // Merge arguments are checked
+    result = SL_Merge(logPaths, 0, MERGE_PATH, &options, &entryCount);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SL_Merge(logPaths, 2, NULL, &options, &entryCount);
+    CU_ASSERT_EQUAL(result, EFAULT);
+
+    // Give the current session an entry that's out of timestamp order (like an imported one)
+    SL_GetSessionTableName(tableName);
+    sprintf(sql, "INSERT INTO `%s` (log_timestamp, log_message, log_level) "
+            "VALUES ('2000-01-01 00:00:00.000000', 'Out of order message.', 'Info')", tableName);
+    result = SL_Query(sql, NULL, NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // Merging with reader threads gives the same result as merging on the calling thread
+    result = SL_Merge(logPaths, 2, MERGE_PATH, &options, &entryCount);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE((entryCount > 0) && ((entryCount % 2) == 0));
+    options.threadCount = 4;
+    result = SL_Merge(logPaths, 2, PARALLEL_MERGE_PATH, &options, &parallelEntryCount);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(entryCount, parallelEntryCount);
+    CU_ASSERT_TRUE(SL_FilesMatch(MERGE_PATH, PARALLEL_MERGE_PATH));
+
+    // A database output gets every entry
+    (void)remove(MERGE_DATABASE_PATH);
+    options.output = eSL_MergeOutput_Database;
+    result = SL_Merge(logPaths, 2, MERGE_DATABASE_PATH, &options, &databaseEntryCount);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(entryCount, databaseEntryCount);
+
+    // Every entry was merged in timestamp order, the out of order one first
+    result = SL_Query("ATTACH '" MERGE_DATABASE_PATH "' AS merged", NULL, NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Query("SELECT name FROM merged.sqlite_master WHERE type = 'table' AND name GLOB 'log at *'",
+                      SL_StringCallback, (void*)mergedTableName);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(strcmp(mergedTableName, "log at 2000-01-01 00:00:00.000000") == 0);
+    sprintf(sql, "SELECT COUNT(*) FROM (SELECT log_timestamp < lag(log_timestamp) OVER (ORDER BY log_id) AS early "
+            "FROM merged.`%s`) WHERE early", mergedTableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 0);
+    result = SL_Query("DETACH merged", NULL, NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    sprintf(sql, "DELETE FROM `%s` WHERE log_message = 'Out of order message.'", tableName);
+    result = SL_Query(sql, NULL, NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_TestPreallocatedMemory
+// =================================================================================================
+void SL_TestPreallocatedMemory (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char message[128] = {0};
+    uint_fast32_t i = 0;
+    int heapLimit = 0;
+
+    // The memory budget has to be big enough to use
+    result = SL_SetPreallocatedMemory(1024, true);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Log a session within the budget (which can't be changed while it's initialized)
+    result = SL_SetPreallocatedMemory(MEMORY_BUDGET, true);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetPreallocatedMemory(MEMORY_BUDGET, true);
+    CU_ASSERT_EQUAL(result, SL_RESULT_ALREADY_INITIALIZED);
+    for (i = 0; i < MEMORY_MESSAGE_COUNT; i++)
+    {
+        sprintf(message, "Preallocated message %u.", (unsigned int)i);
+        result = SL_LOG_INFO_MESSAGE(message, "Memory tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // Terminating shut SQLite down, so it can be configured again, with the page cache from the
+    // budget and a heap limit
+    result = SL_SetPreallocatedMemory(MEMORY_BUDGET, false);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetMemoryLimit(MEMORY_LIMIT);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Query("PRAGMA hard_heap_limit", SL_CountCallback, (void*)&heapLimit);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE((heapLimit > 0) && (heapLimit < (MEMORY_LIMIT - MEMORY_BUDGET)));
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetMemoryLimit(0);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // Once a session without a budget has used SQLite, it isn't shut down for a budget
+    result = SL_SetPreallocatedMemory(0, false);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetPreallocatedMemory(MEMORY_BUDGET, true);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, MISUSE_RESULT);
+    result = SL_SetPreallocatedMemory(0, false);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_IntegrityCallback
+// =================================================================================================
+int SL_IntegrityCallback (void* context, int columnCount, char** values, char** names)
+{
+    (void)names;
+    if ((columnCount == 1) && (values[0] != NULL))
+        *((bool*)context) = (strcmp(values[0], "ok") == 0);
+
+    return 0;
+}
+
+// =================================================================================================
+//  SL_TestAsyncWrites
+// =================================================================================================
+void SL_TestAsyncWrites (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_CheckpointStats stats;
+    char tableName[TABLE_NAME_LENGTH] = {0};
+    char message[128] = {0};
+    char sql[512] = {0};
+    uint_fast32_t i = 0;
+    bool intact = false;
+    int count = 0;
+
+    // Asynchronous writes can't be changed once initialized
+    result = SL_SetAsyncWrites(true);
+    CU_ASSERT_EQUAL(result, SL_RESULT_ALREADY_INITIALIZED);
+
+    // Log a session through io_uring (or synchronously, where it isn't available), and check
+    // that the log file reads back intact
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetAsyncWrites(true));
+    for (i = 0; i < ASYNC_MESSAGE_COUNT; i++)
+    {
+        sprintf(message, "Asynchronous message %u.", (unsigned int)i);
+        result = SL_LOG_INFO_MESSAGE(message, "Async tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+    result = SL_Query("PRAGMA integrity_check", SL_IntegrityCallback, &intact);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(intact);
+
+    // In WAL mode (in a log file of its own, since WAL mode sticks), the checkpointer reads the
+    // frames of each transaction as soon as they're committed, and every entry is kept
+    SL_RESTART_SESSION(ASYNC_WAL_LOG_PATH, true,
+        SL_SetWALCheckpointing(ASYNC_CHECKPOINT_INTERVAL, CHECKPOINT_PAGE_COUNT));
+    SL_GetSessionTableName(tableName);
+    for (i = 0; i < (ASYNC_MESSAGE_COUNT * 4); i++)
+    {
+        sprintf(message, "Asynchronous WAL message %u.", (unsigned int)i);
+        result = SL_LOG_INFO_MESSAGE(message, "Async tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+    result = SL_GetCheckpointStats(&stats);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(stats.errorCount, 0);
+    SL_RESTART_SESSION(ASYNC_WAL_LOG_PATH, false, SL_SetWALCheckpointing(0, 0));
+    sprintf(sql, "SELECT COUNT(*) FROM `%s`", tableName);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, ASYNC_MESSAGE_COUNT * 4);
+    intact = false;
+    result = SL_Query("PRAGMA integrity_check", SL_IntegrityCallback, &intact);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(intact);
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetAsyncWrites(false));
+}
+
+// =================================================================================================
+//  SL_TestMemoryMap
+// =================================================================================================
+void SL_TestMemoryMap (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_ExportOptions options = {eSL_ExportFormat_NDJSON, NULL, NULL, NULL, 1};
+    int size = 0;
+
+    // The logger connection maps the log file right away
+    result = SL_SetMemoryMapSize(MEMORY_MAP_SIZE);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Query("PRAGMA mmap_size", SL_CountCallback, &size);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(size, MEMORY_MAP_SIZE);
+
+    // Exports read the same rows from a memory map as with read()
+    result = SL_Export(LOG_PATH, MEMORY_MAP_EXPORT_PATH, &options);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetMemoryMapSize(0);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Export(LOG_PATH, EXPORT_PATH, &options);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(SL_FilesMatch(EXPORT_PATH, MEMORY_MAP_EXPORT_PATH));
+}
+
+// =================================================================================================
+//  SL_TestCheckpointing
+// =================================================================================================
+void SL_TestCheckpointing (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_CheckpointStats stats;
+    char message[128] = {0};
+    uint_fast32_t i = 0;
+
+    // Checkpointing can't be changed once initialized, and stats need somewhere to go
+    result = SL_SetWALCheckpointing(CHECKPOINT_INTERVAL, CHECKPOINT_PAGE_COUNT);
+    CU_ASSERT_EQUAL(result, SL_RESULT_ALREADY_INITIALIZED);
+    result = SL_GetCheckpointStats(NULL);
+    CU_ASSERT_EQUAL(result, EFAULT);
+
+    // Log a session in WAL mode (in its own log file, which stays in WAL mode), then wait long
+    // enough for all of the WAL to be checkpointed
+    SL_RESTART_SESSION(CHECKPOINT_LOG_PATH, true,
+        SL_SetWALCheckpointing(CHECKPOINT_INTERVAL, CHECKPOINT_PAGE_COUNT));
+    for (i = 0; i < CHECKPOINT_MESSAGE_COUNT; i++)
+    {
+        sprintf(message, "Checkpointed message %u.", (unsigned int)i);
+        result = SL_LOG_INFO_MESSAGE(message, "Checkpoint tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+    (void)usleep(CHECKPOINT_INTERVAL * 10 * 1000);
+    result = SL_GetCheckpointStats(&stats);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(stats.checkpointCount > 0);
+    CU_ASSERT_TRUE(stats.truncateCount > 0);
+    CU_ASSERT_EQUAL(stats.walFrameCount, 0);
+    CU_ASSERT_EQUAL(stats.errorCount, 0);
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetWALCheckpointing(0, 0));
+}
+
+// =================================================================================================
+//  SL_TestChunkSize
+// =================================================================================================
+void SL_TestChunkSize (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char message[128] = {0};
+    char journalMode[16] = {0};
+    uint_fast32_t i = 0;
+    FILE* logFile = NULL;
+    long logFileSize = 0;
+
+    // Chunk sizes are checked
+    result = SL_SetChunkSize(UINT32_MAX);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Once the log file grows (in WAL mode, so a checkpoint moves everything into it), it's a
+    // whole number of chunks; WAL mode sticks, so the session is logged in a log file of its own
+    SL_RESTART_SESSION(CHUNK_LOG_PATH, true, SL_SetChunkSize(CHUNK_SIZE));
+    result = SL_Query("PRAGMA journal_mode = WAL", SL_StringCallback, (void*)journalMode);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE(strcmp(journalMode, "wal") == 0);
+    for (i = 0; i < DICTIONARY_MESSAGE_COUNT; i++)
+    {
+        sprintf(message, "Chunked message %u.", (unsigned int)i);
+        result = SL_LOG_INFO_MESSAGE(message, "Chunk tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+    result = SL_Query("PRAGMA wal_checkpoint", NULL, NULL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    logFile = fopen(CHUNK_LOG_PATH, "rb");
+    CU_ASSERT_PTR_NOT_NULL(logFile);
+    if (logFile != NULL)
+    {
+        (void)fseek(logFile, 0, SEEK_END);
+        logFileSize = ftell(logFile);
+        (void)fclose(logFile);
+    }
+    CU_ASSERT_TRUE((logFileSize > 0) && ((logFileSize % CHUNK_SIZE) == 0));
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetChunkSize(0));
+}
+
+// =================================================================================================
+//  SL_TestMemoryLimit
+// =================================================================================================
+void SL_TestMemoryLimit (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char message[128] = {0};
+    uint_fast32_t i = 0;
+    int heapLimit = 0;
+
+    // The memory limit has to leave room for SQLite
+    result = SL_SetMemoryLimit(1024);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SL_SetMemoryLimit(MEMORY_LIMIT / 8);   // Less than the log entry buffers
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, EINVAL);
+
+    // Log a session within the limit, then lift it
+    result = SL_SetMemoryLimit(MEMORY_LIMIT);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetMemoryLimit(MEMORY_LIMIT);
+    CU_ASSERT_EQUAL(result, SL_RESULT_ALREADY_INITIALIZED);
+    for (i = 0; i < MEMORY_MESSAGE_COUNT; i++)
+    {
+        sprintf(message, "Limited message %u.", (unsigned int)i);
+        result = SL_LOG_INFO_MESSAGE(message, "Memory tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+    result = SL_Query("PRAGMA hard_heap_limit", SL_CountCallback, (void*)&heapLimit);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_TRUE((heapLimit > 0) && (heapLimit < MEMORY_LIMIT));
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetMemoryLimit(0);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+}
+
+// =================================================================================================
+//  SL_TestSpans
+// =================================================================================================
+void SL_TestSpans (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_SpanId parentId = SL_NO_PARENT_SPAN;
+    tSL_SpanId childId = SL_NO_PARENT_SPAN;
+    char sql[256] = {0};
+    int count = 0;
+
+    // Spans need a name, and have to be open to end
+    result = SL_SpanBegin(NULL, "Span tag", SL_NO_PARENT_SPAN, &parentId);
+    CU_ASSERT_EQUAL(result, EFAULT);
+    result = SL_SpanEnd(UINT64_MAX);
+    CU_ASSERT_EQUAL(result, ENOENT);
+
+    // Time a span nested in another
+    result = SL_SpanBegin("Parent span", "Span tag", SL_NO_PARENT_SPAN, &parentId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SpanBegin("Child span", "Span tag", parentId, &childId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_NOT_EQUAL(parentId, childId);
+    usleep(SPAN_SLEEP_TIME);
+    result = SL_SpanEnd(childId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SpanEnd(childId);
+    CU_ASSERT_EQUAL(result, ENOENT);
+    result = SL_SpanEnd(parentId);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // Ended spans are written with the next batch
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    sprintf(sql, "SELECT COUNT(*) FROM `log spans` WHERE span_id = %llu AND span_parent_id = %llu AND "
+            "span_duration_ns >= %d AND span_duration_ns = span_end_ns - span_start_ns",
+            (unsigned long long)childId, (unsigned long long)parentId, SPAN_SLEEP_TIME * 1000);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+    sprintf(sql, "SELECT COUNT(*) FROM `log spans` WHERE span_id = %llu AND span_parent_id IS NULL AND "
+            "span_duration_ns >= %d", (unsigned long long)parentId, SPAN_SLEEP_TIME * 1000);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+}
+
+// =================================================================================================
+//  SL_TestMetrics
+// =================================================================================================
+void SL_TestMetrics (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char name[64] = {0};
+    char sql[256] = {0};
+    uint_fast32_t i = 0;
+    int count = 0;
+
+    // The interval can't be changed once initialized
+    result = SL_SetMetricInterval(METRIC_INTERVAL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_ALREADY_INITIALIZED);
+    result = SL_Terminate();
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_SetMetricInterval(0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    result = SL_SetMetricInterval(METRIC_INTERVAL);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    result = SL_Initialize(LOG_PATH);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+
+    // Metrics need a name (the log file outlives test runs, so this run's is made unique)
+    result = SL_RecordMetric(NULL, 1.0);
+    CU_ASSERT_EQUAL(result, EFAULT);
+    result = SL_RecordMetric("", 1.0);
+    CU_ASSERT_EQUAL(result, EINVAL);
+    sprintf(name, "Test metric %ld", (long)time(NULL));
+    for (i = 1; i <= METRIC_VALUE_COUNT; i++)
+    {
+        result = SL_RecordMetric(name, (double)i);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+
+    // The interval in progress is written by SL_Terminate
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetMetricInterval(60));
+    sprintf(sql, "SELECT SUM(metric_count) = %d AND SUM(metric_sum) = %d AND MIN(metric_min) = 1 AND "
+            "MAX(metric_max) = %d FROM `log metrics` WHERE metric_name = '%s'",
+            METRIC_VALUE_COUNT, (METRIC_VALUE_COUNT * (METRIC_VALUE_COUNT + 1)) / 2, METRIC_VALUE_COUNT, name);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+    sprintf(sql, "SELECT MIN(json_array_length(metric_histogram)) FROM `log metrics` WHERE metric_name = '%s'",
+            name);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 32);
+
+    // An interval that has ended is written with the next batch, without another value recorded
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetMetricInterval(1));
+    sprintf(name, "Ended metric %ld", (long)time(NULL));
+    result = SL_RecordMetric(name, 1.0);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    usleep(1100 * 1000);
+    for (i = 0; i < METRIC_MESSAGE_COUNT; i++)
+    {
+        result = SL_LOG_INFO_MESSAGE("Logged after a metric interval ended.", "Metric tag", NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+    sprintf(sql, "SELECT COUNT(*) FROM `log metrics` WHERE metric_name = '%s' AND metric_count = 1", name);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, 1);
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetMetricInterval(60));
+}
+
+// =================================================================================================
+//  SL_TestRollups
+// =================================================================================================
+void SL_TestRollups (void)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    char tag[64] = {0};
+    char message[128] = {0};
+    char sql[256] = {0};
+    uint_fast32_t i = 0;
+    int count = 0;
+
+    // Rollups can't be turned on once initialized
+    result = SL_SetRollups(true);
+    CU_ASSERT_EQUAL(result, SL_RESULT_ALREADY_INITIALIZED);
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetRollups(true));
+
+    // Log a few batches under a tag of this run's own (the log file outlives test runs)
+    sprintf(tag, "Rollup tag %ld", (long)time(NULL));
+    for (i = 0; i < ROLLUP_MESSAGE_COUNT; i++)
+    {
+        sprintf(message, "Rollup message %u.", (unsigned int)i);
+        if ((i % 2) == 0)
+            result = SL_LOG_INFO_MESSAGE(message, tag, NULL);
+        else
+            result = SL_LOG_WARNING_MESSAGE(message, tag, NULL);
+        CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    }
+    SL_RESTART_SESSION(LOG_PATH, false, SL_SetRollups(false));
+
+    // The counts match the log entries
+    sprintf(sql, "SELECT SUM(rollup_count) FROM `log rollups` WHERE rollup_tag = '%s' AND rollup_level = 'Warning'",
+            tag);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, ROLLUP_MESSAGE_COUNT / 2);
+    sprintf(sql, "SELECT SUM(rollup_repeat_count) FROM `log rollups` WHERE rollup_tag = '%s'", tag);
+    result = SL_Query(sql, SL_CountCallback, (void*)&count);
+    CU_ASSERT_EQUAL(result, SL_RESULT_SUCCESS);
+    CU_ASSERT_EQUAL(count, ROLLUP_MESSAGE_COUNT);
+}
+
 // =================================================================================================
 //  main
 // =================================================================================================
@@ -268,14 +1518,56 @@ int main (int argc, const char * argv[])
     CU_ErrorCode result = CU_initialize_registry();
     if (result == CUE_SUCCESS)
     {
-        // Set up test suite
-        CU_pSuite testSuite = CU_add_suite("SQLite Logger test suite",
-                                           SL_SuiteInit,
-                                           SL_SuiteCleanup);
+        // Set up test suites; SQLite's memory has to be configured before anything else uses
+        // SQLite, so the memory suite runs first, and opens its own sessions; the compression
+        // suites run before the main suite, so that the log file has compressed sessions to
+        // archive and export
+        CU_pSuite testSuite = NULL;
+        CU_pSuite compressionSuite = NULL;
+        CU_pSuite dictionarySuite = NULL;
+        CU_pSuite memorySuite = CU_add_suite("SQLite Logger memory test suite", NULL, NULL);
+        if (memorySuite != NULL)
+        {
+            CU_ADD_TEST(memorySuite, SL_TestPreallocatedMemory);
+            CU_ADD_TEST(memorySuite, SL_TestMemoryLimit);
+            compressionSuite = CU_add_suite("SQLite Logger compression test suite",
+                                            SL_CompressionSuiteInit,
+                                            SL_CompressionSuiteCleanup);
+        }
+        if (compressionSuite != NULL)
+        {
+            CU_ADD_TEST(compressionSuite, SL_TestCompression);
+            dictionarySuite = CU_add_suite("SQLite Logger dictionary compression test suite",
+                                           SL_DictionarySuiteInit,
+                                           SL_DictionarySuiteCleanup);
+        }
+        if (dictionarySuite != NULL)
+        {
+            CU_ADD_TEST(dictionarySuite, SL_TestDictionaryCompression);
+            testSuite = CU_add_suite("SQLite Logger test suite",
+                                     SL_SuiteInit,
+                                     SL_SuiteCleanup);
+        }
         if (testSuite != NULL)
         {
             CU_ADD_TEST(testSuite, SL_TestLogLevel);
             CU_ADD_TEST(testSuite, SL_TestLogging);
+            CU_ADD_TEST(testSuite, SL_TestFailedBatch);
+            CU_ADD_TEST(testSuite, SL_TestRateLimiting);
+            CU_ADD_TEST(testSuite, SL_TestSampling);
+            CU_ADD_TEST(testSuite, SL_TestArchive);
+            CU_ADD_TEST(testSuite, SL_TestPending);
+            CU_ADD_TEST(testSuite, SL_TestSubscription);
+            CU_ADD_TEST(testSuite, SL_TestExport);
+            CU_ADD_TEST(testSuite, SL_TestImport);
+            CU_ADD_TEST(testSuite, SL_TestMerge);
+            CU_ADD_TEST(testSuite, SL_TestAsyncWrites);
+            CU_ADD_TEST(testSuite, SL_TestMemoryMap);
+            CU_ADD_TEST(testSuite, SL_TestCheckpointing);
+            CU_ADD_TEST(testSuite, SL_TestChunkSize);
+            CU_ADD_TEST(testSuite, SL_TestSpans);
+            CU_ADD_TEST(testSuite, SL_TestMetrics);
+            CU_ADD_TEST(testSuite, SL_TestRollups);
         }
         else    // CU_add_suite failed
         {
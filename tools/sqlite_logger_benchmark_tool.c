@@ -0,0 +1,147 @@
+// =================================================================================================
+//! @file sqlite_logger_benchmark_tool.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file implements a command line tool that measures SQLite Logger insert throughput.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-24
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sqlite_logger.h"
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Usage text
+static const char* kSL_UsageString =
+    "Usage: sqlite_logger_benchmark [options] <log file>\n"
+    "Options:\n"
+    "  -n <entries>   Number of entries to log (the default is 1000000)\n"
+    "  -r <runs>      Number of runs, each to a new log file (the default is 3)\n"
+    "  -a             Write the log file through io_uring\n"
+    "  -h             Print this text\n";
+
+//  Tag of the benchmark entries
+#define SL_BENCHMARK_TAG    "sqlite_logger_benchmark"
+
+// =================================================================================================
+//  Private prototypes
+// =================================================================================================
+
+static double SL_GetSeconds (void);
+
+static int32_t SL_RunBenchmark (const char* path, uint32_t entryCount, double* seconds);
+
+// =================================================================================================
+//  main
+// =================================================================================================
+int main (int argc, char* argv[])
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    uint32_t entryCount = 1000000;
+    uint32_t runCount = 3;
+    int option = 0;
+
+    while ((result == SL_RESULT_SUCCESS) && ((option = getopt(argc, argv, "n:r:ah")) != -1))
+    {
+        switch (option)
+        {
+            case 'n':
+                entryCount = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                runCount = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'a':
+                result = SL_SetAsyncWrites(true);
+                break;
+            default:
+                result = EXIT_FAILURE;
+                break;
+        }
+    }
+    if ((result != SL_RESULT_SUCCESS) || ((argc - optind) != 1) || (entryCount == 0) || (runCount == 0))
+    {
+        fputs(kSL_UsageString, stderr);
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        double best = 0.0;
+        uint32_t i = 0;
+
+        // The best run is reported, since it has the least interference from the rest of the host
+        for (i = 0; (i < runCount) && (result == SL_RESULT_SUCCESS); i++)
+        {
+            double seconds = 0.0;
+
+            (void)remove(argv[optind]);
+            result = SL_RunBenchmark(argv[optind], entryCount, &seconds);
+            if (result == SL_RESULT_SUCCESS)
+            {
+                printf("Run %u: %u entries in %.3f s (%.0f entries/s).\n",
+                       i + 1, entryCount, seconds, entryCount / seconds);
+                if ((i == 0) || (seconds < best))
+                    best = seconds;
+            }
+        }
+        if (result == SL_RESULT_SUCCESS)
+            printf("Best: %.0f entries/s.\n", entryCount / best);
+        else
+        {
+            fprintf(stderr, "Benchmark failed with result %d (%s).\n", result, SL_Result_String(result));
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
+//  SL_GetSeconds
+// =================================================================================================
+double SL_GetSeconds (void)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+// =================================================================================================
+//  SL_RunBenchmark
+// =================================================================================================
+int32_t SL_RunBenchmark (const char* path, uint32_t entryCount, double* seconds)
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    double start = 0.0;
+    uint32_t i = 0;
+
+    // Messages differ, so none of them are collapsed into repeats; terminating writes the last
+    // batch, so it's part of the time
+    result = SL_Initialize(path);
+    start = SL_GetSeconds();
+    for (i = 0; (i < entryCount) && (result == SL_RESULT_SUCCESS); i++)
+    {
+        char message[128] = {0};
+
+        snprintf(message, sizeof(message), "Request %u from client %u completed in %u ms.",
+                 i, i % 16, i % 100);
+        result = SL_LOG_INFO_MESSAGE(message, SL_BENCHMARK_TAG, NULL);
+    }
+    if (SL_Terminate() != SL_RESULT_SUCCESS)
+        result = (result == SL_RESULT_SUCCESS) ? EXIT_FAILURE : result;
+    *seconds = SL_GetSeconds() - start;
+
+    return result;
+}
+
+// =================================================================================================
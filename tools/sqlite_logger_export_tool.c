@@ -0,0 +1,88 @@
+// =================================================================================================
+//! @file sqlite_logger_export_tool.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file implements a command line tool that exports SQLite Logger log files.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-18
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sqlite_logger.h"
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Usage text
+static const char* kSL_UsageString =
+    "Usage: sqlite_logger_export [options] <log file> <output file>\n"
+    "Options:\n"
+    "  -f <format>    Export format, ndjson (the default) or csv\n"
+    "  -t <table>     Export only this log table (for example, \"log at 2022-03-14 10:00:00.000000 CDT\")\n"
+    "  -s <time>      Export only entries logged at or after this time (for example, \"2022-03-14 10:00:00\")\n"
+    "  -e <time>      Export only entries logged before this time\n"
+    "  -j <threads>   Number of threads to export with (the default is 1)\n"
+    "  -h             Print this text\n";
+
+// =================================================================================================
+//  main
+// =================================================================================================
+int main (int argc, char* argv[])
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_ExportOptions options = {eSL_ExportFormat_NDJSON, NULL, NULL, NULL, 1};
+    int option = 0;
+
+    while ((result == SL_RESULT_SUCCESS) && ((option = getopt(argc, argv, "f:t:s:e:j:h")) != -1))
+    {
+        switch (option)
+        {
+            case 'f':
+                if (strcmp(optarg, "ndjson") == 0)
+                    options.format = eSL_ExportFormat_NDJSON;
+                else if (strcmp(optarg, "csv") == 0)
+                    options.format = eSL_ExportFormat_CSV;
+                else
+                    result = EXIT_FAILURE;
+                break;
+            case 't':
+                options.tableName = optarg;
+                break;
+            case 's':
+                options.startTime = optarg;
+                break;
+            case 'e':
+                options.endTime = optarg;
+                break;
+            case 'j':
+                options.threadCount = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            default:
+                result = EXIT_FAILURE;
+                break;
+        }
+    }
+    if ((result != SL_RESULT_SUCCESS) || ((argc - optind) != 2))
+    {
+        fputs(kSL_UsageString, stderr);
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        result = SL_Export(argv[optind], argv[optind + 1], &options);
+        if (result != SL_RESULT_SUCCESS)
+        {
+            fprintf(stderr, "Export failed with result %d (%s).\n", result, SL_Result_String(result));
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
+
+// =================================================================================================
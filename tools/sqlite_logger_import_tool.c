@@ -0,0 +1,106 @@
+// =================================================================================================
+//! @file sqlite_logger_import_tool.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file implements a command line tool that imports log files into a SQLite Logger
+//! log file.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-21
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sqlite_logger.h"
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Usage text
+static const char* kSL_UsageString =
+    "Usage: sqlite_logger_import [options] <log file> <input file>...\n"
+    "Options:\n"
+    "  -f <format>    Input format, text (the default) or ndjson\n"
+    "  -j <threads>   Number of threads to parse with (the default is 1)\n"
+    "  -c <threshold> Compress messages of at least this many bytes\n"
+    "  -d             Use dictionary compression\n"
+    "  -h             Print this text\n";
+
+//  Tag of the entries that record each import
+#define SL_IMPORT_TAG   "sqlite_logger_import"
+
+// =================================================================================================
+//  main
+// =================================================================================================
+int main (int argc, char* argv[])
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_ImportOptions options = {eSL_ImportFormat_Text, 1};
+    int option = 0;
+    int i = 0;
+
+    while ((result == SL_RESULT_SUCCESS) && ((option = getopt(argc, argv, "f:j:c:dh")) != -1))
+    {
+        switch (option)
+        {
+            case 'f':
+                if (strcmp(optarg, "text") == 0)
+                    options.format = eSL_ImportFormat_Text;
+                else if (strcmp(optarg, "ndjson") == 0)
+                    options.format = eSL_ImportFormat_NDJSON;
+                else
+                    result = EXIT_FAILURE;
+                break;
+            case 'j':
+                options.threadCount = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                result = SL_SetCompressionThreshold((uint32_t)strtoul(optarg, NULL, 10));
+                break;
+            case 'd':
+                result = SL_SetDictionaryCompression(true);
+                break;
+            default:
+                result = EXIT_FAILURE;
+                break;
+        }
+    }
+    if ((result != SL_RESULT_SUCCESS) || ((argc - optind) < 2))
+    {
+        fputs(kSL_UsageString, stderr);
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        // Each input file gets its own log table, and the tool's own log table records the imports
+        result = SL_Initialize(argv[optind]);
+        for (i = optind + 1; (i < argc) && (result == SL_RESULT_SUCCESS); i++)
+        {
+            uint64_t entryCount = 0;
+
+            result = SL_Import(argv[i], &options, &entryCount);
+            if (result == SL_RESULT_SUCCESS)
+            {
+                char message[1024] = {0};
+
+                snprintf(message, sizeof(message), "Imported %llu entries from %s.",
+                         (unsigned long long)entryCount, argv[i]);
+                printf("%s\n", message);
+                result = SL_LOG_INFO_MESSAGE(message, SL_IMPORT_TAG, NULL);
+            }
+        }
+        if (result != SL_RESULT_SUCCESS)
+            fprintf(stderr, "Import failed with result %d (%s).\n", result, SL_Result_String(result));
+        if (SL_Terminate() != SL_RESULT_SUCCESS)
+            result = EXIT_FAILURE;
+        else if (result != SL_RESULT_SUCCESS)
+            result = EXIT_FAILURE;
+    }
+    return result;
+}
+
+// =================================================================================================
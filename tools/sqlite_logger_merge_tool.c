@@ -0,0 +1,91 @@
+// =================================================================================================
+//! @file sqlite_logger_merge_tool.c
+//! @author Gary Woodcock (gary.woodcock@unthinkable.com)
+//! @brief This file implements a command line tool that merges SQLite Logger log files.
+//! @remarks Requires ANSI C99 (or better) compliant compilers.
+//! @remarks Supported host operating systems: Any Unix/Linux
+//! @date 2022-03-23
+//! @copyright Copyright (c) 2022 Unthinkable Research LLC. All rights reserved.
+//!
+//  Includes
+// =================================================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "sqlite_logger.h"
+
+// =================================================================================================
+//  Private constants
+// =================================================================================================
+
+//  Usage text
+static const char* kSL_UsageString =
+    "Usage: sqlite_logger_merge [options] <output file> <log file>...\n"
+    "Options:\n"
+    "  -f <format>    Output format, sqlite (the default), ndjson or csv\n"
+    "  -s <time>      Merge only entries logged at or after this time (for example, \"2022-03-14 10:00:00\")\n"
+    "  -e <time>      Merge only entries logged before this time\n"
+    "  -j <threads>   Number of threads to read the log files with (the default is 1)\n"
+    "  -h             Print this text\n";
+
+// =================================================================================================
+//  main
+// =================================================================================================
+int main (int argc, char* argv[])
+{
+    int32_t result = SL_RESULT_SUCCESS;
+    tSL_MergeOptions options = {eSL_MergeOutput_Database, NULL, NULL, 1};
+    int option = 0;
+
+    while ((result == SL_RESULT_SUCCESS) && ((option = getopt(argc, argv, "f:s:e:j:h")) != -1))
+    {
+        switch (option)
+        {
+            case 'f':
+                if (strcmp(optarg, "sqlite") == 0)
+                    options.output = eSL_MergeOutput_Database;
+                else if (strcmp(optarg, "ndjson") == 0)
+                    options.output = eSL_MergeOutput_NDJSON;
+                else if (strcmp(optarg, "csv") == 0)
+                    options.output = eSL_MergeOutput_CSV;
+                else
+                    result = EXIT_FAILURE;
+                break;
+            case 's':
+                options.startTime = optarg;
+                break;
+            case 'e':
+                options.endTime = optarg;
+                break;
+            case 'j':
+                options.threadCount = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            default:
+                result = EXIT_FAILURE;
+                break;
+        }
+    }
+    if ((result != SL_RESULT_SUCCESS) || ((argc - optind) < 2))
+    {
+        fputs(kSL_UsageString, stderr);
+        result = EXIT_FAILURE;
+    }
+    else
+    {
+        uint64_t entryCount = 0;
+
+        result = SL_Merge((const char* const*)&(argv[optind + 1]), (uint32_t)(argc - optind - 1),
+                          argv[optind], &options, &entryCount);
+        if (result == SL_RESULT_SUCCESS)
+            printf("Merged %llu entries into %s.\n", (unsigned long long)entryCount, argv[optind]);
+        else
+        {
+            fprintf(stderr, "Merge failed with result %d (%s).\n", result, SL_Result_String(result));
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
+
+// =================================================================================================